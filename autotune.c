@@ -0,0 +1,173 @@
+#include "autotune.h"
+#include "timers.h"
+#include "occupancy.h"
+#include <stdio.h>
+
+int chooseAutoThreadCap(int maxThreads, InputData *simulationData) {
+    long slots = (long) simulationData->rows * simulationData->columns;
+
+    int entities = simulationData->entitiesAccumulatedPerRow[ simulationData->rows - 1 ];
+
+    long cap = maxThreads;
+
+    if (slots / AUTO_MIN_SLOTS_PER_THREAD < cap) {
+        cap = slots / AUTO_MIN_SLOTS_PER_THREAD;
+    }
+
+    if (entities / AUTO_MIN_ENTITIES_PER_THREAD < cap) {
+        cap = entities / AUTO_MIN_ENTITIES_PER_THREAD;
+    }
+
+    return cap > 1 ? (int) cap : 1;
+}
+
+/*
+ * The part of a simulation that is left, simulated in steps with the number of threads picked as it goes. The
+ * generations of the job are never changed, its checkpoints and snapshots still see the whole simulation
+ */
+typedef struct TunedRun_ {
+
+    SimulationEngine *engine;
+
+    SimulationJob *job;
+
+    //The first generation that was not simulated yet
+    int generation;
+
+} TunedRun;
+
+//Generations left to simulate
+static int generationsLeft(TunedRun *run) {
+    return run->job->simulationData->n_gen - run->generation;
+}
+
+//The rabbits and foxes of the world, from its occupancy plane (the entity counts are not kept up to date by every mode)
+static long countAnimals(InputData *simulationData, WorldSlot *world) {
+    long animals = 0;
+
+    for (int row = 0; row < simulationData->rows; row++) {
+        uint64_t *words = occupancyRow(simulationData, world, row);
+
+        for (int word = 0; word < OCCUPANCY_WORDS(simulationData->columns); word++) {
+            animals += __builtin_popcountll(words[ word ]);
+        }
+    }
+
+    return animals;
+}
+
+/*
+ * Simulate the next generations, at most the given number. Returns the time every generation took for every animal
+ * the world had when they started: the population changes as the world runs, and the time of a generation with it,
+ * so the times of different generations are only compared per animal
+ */
+static double runTunedGenerations(TunedRun *run, int threads, int generations) {
+    if (generations > generationsLeft(run)) {
+        generations = generationsLeft(run);
+    }
+
+    if (generations <= 0) {
+        return 0;
+    }
+
+    long animals = countAnimals(run->job->simulationData, run->job->world);
+
+    long start = monotonicNanos();
+
+    runSimulationJobGenerations(run->engine, run->job, threads, run->generation, run->generation + generations);
+
+    run->generation += generations;
+
+    return (double) (monotonicNanos() - start) / generations / (animals > 0 ? animals : 1);
+}
+
+/*
+ * Simulate the first generations with the cap, half of it and so on, and return the number of threads that was the
+ * fastest. Stops when there are not enough generations left to measure the next count
+ */
+static int calibrateThreads(TunedRun *run, int cap) {
+    //Not measured, the first generations also warm the caches up
+    runTunedGenerations(run, cap, AUTO_CALIBRATION_GENERATIONS);
+
+    int best = cap;
+
+    double bestNanos = 0;
+
+    for (int threads = cap; threads >= 1 && generationsLeft(run) >= AUTO_CALIBRATION_GENERATIONS; threads /= 2) {
+        double nanos = runTunedGenerations(run, threads, AUTO_CALIBRATION_GENERATIONS);
+
+        fprintf(stderr, "  %d threads: %.1f ns per generation and animal\n", threads, nanos);
+
+        if (threads == cap || nanos < bestNanos) {
+            best = threads;
+            bestNanos = nanos;
+        } else if (nanos > bestNanos * (1 + AUTO_SHRINK_TOLERANCE)) {
+            //Fewer threads only get slower from here
+            break;
+        }
+    }
+
+    return best;
+}
+
+void runTunedSimulationJob(SimulationEngine *engine, SimulationJob *job) {
+    InputData *simulationData = job->simulationData;
+
+    TunedRun run = {.engine = engine, .job = job, .generation = simulationData->firstGeneration};
+
+    int cap = chooseAutoThreadCap(getEngineThreadCount(engine), simulationData);
+
+    long start = monotonicNanos();
+
+    fprintf(stderr, "Auto threads: %dx%d world with %d animals, up to %d of %d threads\n", simulationData->rows,
+            simulationData->columns, simulationData->entitiesAccumulatedPerRow[ simulationData->rows - 1 ], cap,
+            getEngineThreadCount(engine));
+
+    int threads = cap > 1 ? calibrateThreads(&run, cap) : 1;
+
+    fprintf(stderr, "  simulating on %d threads%s\n", threads, threads == 1 ? " (sequentially)" : "");
+
+    //Windows with the current threads before the next try with fewer, doubled every time fewer were slower
+    int windowsBetweenTries = 1, windowsLeft = 1;
+
+    double windowNanos = 0;
+
+    while (generationsLeft(&run) > 0) {
+        //A try needs the time of a whole window with the current threads to compare with, and a whole window itself
+        int wholeWindow = generationsLeft(&run) >= AUTO_WINDOW_GENERATIONS;
+
+        if (threads == 1 || windowNanos == 0 || windowsLeft > 0 || !wholeWindow) {
+            double nanos = runTunedGenerations(&run, threads, AUTO_WINDOW_GENERATIONS);
+
+            //The last generations can be too few to compare with
+            if (wholeWindow) {
+                windowNanos = nanos;
+            }
+
+            if (windowsLeft > 0) {
+                windowsLeft--;
+            }
+
+            continue;
+        }
+
+        int fewer = threads / 2, generation = run.generation;
+
+        double nanos = runTunedGenerations(&run, fewer, AUTO_WINDOW_GENERATIONS);
+
+        if (nanos <= windowNanos * (1 + AUTO_SHRINK_TOLERANCE)) {
+            fprintf(stderr, "  generation %d: %d threads took %.1f ns per generation and animal against %.1f with %d, "
+                            "shrinking\n", generation, fewer, nanos, windowNanos, threads);
+
+            threads = fewer;
+            windowNanos = nanos;
+            windowsBetweenTries = 1;
+        } else {
+            windowsBetweenTries *= 2;
+        }
+
+        windowsLeft = windowsBetweenTries;
+    }
+
+    job->micros = (monotonicNanos() - start) / 1000;
+}
@@ -0,0 +1,60 @@
+#ifndef TRABALHO_2_AUTOTUNE_H
+#define TRABALHO_2_AUTOTUNE_H
+
+#include "engine.h"
+
+/*
+ * Picks the number of threads a world is simulated with (ecosystem auto). Small or sparse worlds spend more time
+ * synchronizing the threads than moving the animals, and past some number of threads every world gets slower.
+ *
+ * The number of threads is first capped by the size of the world and its population, so every thread gets enough
+ * slots and animals, and worlds that are too small are simulated sequentially. The first generations then calibrate
+ * the counts left: they are simulated with the cap, half of it, and so on down to a single thread, for a few
+ * generations each, stopping once fewer threads got slower. The generations of the calibration are part of the
+ * simulation, nothing is simulated twice.
+ *
+ * The rest of the world is simulated in windows of generations. The population changes as it runs, so every few
+ * windows one is simulated with half the threads, which are kept when they are about as fast as the threads before
+ * them: the threads left out were no longer making the generations faster. The threads are only ever shrunk. The
+ * times are compared per animal, so a growing population is not taken for fewer threads being slower.
+ *
+ * What was measured and picked is written to stderr.
+ */
+
+//Slots (and animals) every thread needs at least, worlds that can't give two threads that many are sequential
+#ifndef AUTO_MIN_SLOTS_PER_THREAD
+#define AUTO_MIN_SLOTS_PER_THREAD 1024
+#endif
+
+#ifndef AUTO_MIN_ENTITIES_PER_THREAD
+#define AUTO_MIN_ENTITIES_PER_THREAD 64
+#endif
+
+//Generations simulated with every number of threads during the calibration
+#ifndef AUTO_CALIBRATION_GENERATIONS
+#define AUTO_CALIBRATION_GENERATIONS 32
+#endif
+
+//Generations between two checks of the time per generation after the calibration
+#ifndef AUTO_WINDOW_GENERATIONS
+#define AUTO_WINDOW_GENERATIONS 128
+#endif
+
+//Fewer threads are taken when they are at most this much slower per generation (a fraction)
+#ifndef AUTO_SHRINK_TOLERANCE
+#define AUTO_SHRINK_TOLERANCE 0.05
+#endif
+
+/**
+ * The most threads the calibration starts from for a world, on an engine with maxThreads workers. 1 when the world
+ * should be simulated sequentially
+ */
+int chooseAutoThreadCap(int maxThreads, InputData *simulationData);
+
+/**
+ * Simulate every generation of a job like runSimulationJob, with the number of the workers of the engine picked as
+ * the world runs. job->micros is set to the time of the whole simulation
+ */
+void runTunedSimulationJob(SimulationEngine *engine, SimulationJob *job);
+
+#endif //TRABALHO_2_AUTOTUNE_H
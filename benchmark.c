@@ -0,0 +1,391 @@
+#include "benchmark.h"
+#include "timers.h"
+#include "occupancy.h"
+#include "movements.h"
+#include "matrix_utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+//The times of a run, kept until the JSON is written
+typedef struct BenchmarkRun_ {
+
+    int warmup, threads;
+
+    long totalNanos, topologyNanos, outputNanos;
+
+    PhaseTimers *timers;
+
+} BenchmarkRun;
+
+static long phaseTotal(PhaseTimers *timers, int thread, TimedPhase phase) {
+    long total = 0;
+
+    for (int generation = 0; generation < timers->generations; generation++) {
+        total += timers->nanos[ ((size_t) thread * timers->generations + generation) * TIMED_PHASES + phase ];
+    }
+
+    return total;
+}
+
+//1 when every thread of the run that opened its events could count this one
+static int isEventCountedInRun(BenchmarkRun *run, CountedEvent event) {
+    PhaseCounters *counters = run->timers->counters;
+
+    int opened = 0;
+
+    for (int thread = 0; thread < run->threads; thread++) {
+        if (counters->threads[ thread ]->opened) {
+            if (!isEventCounted(counters, thread, event)) {
+                return 0;
+            }
+
+            opened = 1;
+        }
+    }
+
+    return opened;
+}
+
+static void writeCountersJson(FILE *jsonFile, BenchmarkRun *run) {
+    PhaseCounters *counters = run->timers->counters;
+
+    if (counters == NULL) {
+        fprintf(jsonFile, "null");
+        return;
+    }
+
+    fprintf(jsonFile, "{\"phase_totals\": {");
+
+    for (int phase = 0; phase < TIMED_PHASES; phase++) {
+        fprintf(jsonFile, "%s\"%s\": {", phase > 0 ? ", " : "", timedPhaseName(phase));
+
+        int written = 0;
+
+        for (int event = 0; event < COUNTED_EVENTS; event++) {
+            if (!isEventCountedInRun(run, event)) {
+                continue;
+            }
+
+            uint64_t total = 0;
+
+            for (int thread = 0; thread < run->threads; thread++) {
+                total += phaseEventTotal(counters, thread, phase, event);
+            }
+
+            fprintf(jsonFile, "%s\"%s\": %llu", written++ > 0 ? ", " : "", countedEventName(event),
+                    (unsigned long long) total);
+        }
+
+        fprintf(jsonFile, "}");
+    }
+
+    fprintf(jsonFile, "},\n      \"per_thread\": [\n");
+
+    for (int thread = 0; thread < run->threads; thread++) {
+        fprintf(jsonFile, "       {");
+
+        for (int phase = 0; phase < TIMED_PHASES; phase++) {
+            fprintf(jsonFile, "%s\"%s\": {", phase > 0 ? ", " : "", timedPhaseName(phase));
+
+            int written = 0;
+
+            for (int event = 0; event < COUNTED_EVENTS; event++) {
+                if (isEventCounted(counters, thread, event)) {
+                    fprintf(jsonFile, "%s\"%s\": %llu", written++ > 0 ? ", " : "", countedEventName(event),
+                            (unsigned long long) phaseEventTotal(counters, thread, phase, event));
+                }
+            }
+
+            fprintf(jsonFile, "}");
+        }
+
+        fprintf(jsonFile, "}%s\n", thread < run->threads - 1 ? "," : "");
+    }
+
+    fprintf(jsonFile, "     ]}");
+}
+
+static void writeRunJson(FILE *jsonFile, BenchmarkRun *run) {
+    PhaseTimers *timers = run->timers;
+
+    fprintf(jsonFile, "    {\"warmup\": %s, \"threads\": %d, \"total_ns\": %ld, \"topology_ns\": %ld, "
+                      "\"output_ns\": %ld,\n", run->warmup ? "true" : "false", run->threads, run->totalNanos,
+            run->topologyNanos, run->outputNanos);
+
+    fprintf(jsonFile, "     \"phase_totals_ns\": {");
+
+    for (int phase = 0; phase < TIMED_PHASES; phase++) {
+        long total = 0;
+
+        for (int thread = 0; thread < run->threads; thread++) {
+            total += phaseTotal(timers, thread, phase);
+        }
+
+        fprintf(jsonFile, "%s\"%s\": %ld", phase > 0 ? ", " : "", timedPhaseName(phase), total);
+    }
+
+    fprintf(jsonFile, "},\n     \"per_thread\": [\n");
+
+    for (int thread = 0; thread < run->threads; thread++) {
+        fprintf(jsonFile, "      {\"totals_ns\": {");
+
+        for (int phase = 0; phase < TIMED_PHASES; phase++) {
+            fprintf(jsonFile, "%s\"%s\": %ld", phase > 0 ? ", " : "", timedPhaseName(phase),
+                    phaseTotal(timers, thread, phase));
+        }
+
+        fprintf(jsonFile, "},\n       \"generations_ns\": {");
+
+        for (int phase = 0; phase < TIMED_PHASES; phase++) {
+            fprintf(jsonFile, "%s\"%s\": [", phase > 0 ? ",\n                          " : "",
+                    timedPhaseName(phase));
+
+            for (int generation = 0; generation < timers->generations; generation++) {
+                fprintf(jsonFile, "%s%ld", generation > 0 ? ", " : "",
+                        timers->nanos[ ((size_t) thread * timers->generations + generation) * TIMED_PHASES + phase ]);
+            }
+
+            fprintf(jsonFile, "]");
+        }
+
+        fprintf(jsonFile, "}}%s\n", thread < run->threads - 1 ? "," : "");
+    }
+
+    fprintf(jsonFile, "     ],\n     \"counters\": ");
+
+    writeCountersJson(jsonFile, run);
+
+    fprintf(jsonFile, "}");
+}
+
+//1 when every run could count the event, the runs don't always use the same threads
+static int isEventCountedInRuns(BenchmarkRun *runs, int runCount, CountedEvent event) {
+    for (int run = 0; run < runCount; run++) {
+        if (!isEventCountedInRun(&runs[ run ], event)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+//Say which events could not be counted, and why, so a missing event in the results is not taken for a zero
+static void warnUncountedEvents(BenchmarkRun *runs, int runCount) {
+    for (int event = 0; event < COUNTED_EVENTS; event++) {
+        if (isEventCountedInRuns(runs, runCount, event)) {
+            continue;
+        }
+
+        int error = 0;
+
+        for (int run = 0; run < runCount && error == 0; run++) {
+            PhaseCounters *counters = runs[ run ].timers->counters;
+
+            for (int thread = 0; thread < runs[ run ].threads && error == 0; thread++) {
+                error = counters->threads[ thread ]->openErrors[ event ];
+            }
+        }
+
+        fprintf(stderr, "WARNING: The %s of the phases can't be counted (%s), only their times are measured\n",
+                countedEventName(event), error != 0 ? strerror(error) : "no thread opened its counters");
+    }
+}
+
+static void writeBenchmarkJson(const char *path, SimulationJob *job, int entities, int threadCount, int sequential,
+                               const BenchmarkOptions *options, long loadNanos, BenchmarkRun *runs) {
+    FILE *jsonFile = fopen(path, "w");
+
+    if (jsonFile == NULL) {
+        fprintf(stderr, "ERROR: Failed to open benchmark output file %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    InputData *simulationData = job->simulationData;
+
+    fprintf(jsonFile, "{\n  \"world\": {\"rows\": %d, \"columns\": %d, \"generations\": %d, \"first_generation\": %d, "
+                      "\"entities\": %d, \"rocks\": %d},\n", simulationData->rows, simulationData->columns,
+            simulationData->n_gen, simulationData->firstGeneration, entities, simulationData->rocks);
+
+    fprintf(jsonFile, "  \"threads\": %d, \"sequential\": %s, \"warmup\": %d, \"repeats\": %d,\n", threadCount,
+            sequential ? "true" : "false", options->warmup, options->repeats);
+
+    fprintf(jsonFile, "  \"phases\": [");
+
+    for (int phase = 0; phase < TIMED_PHASES; phase++) {
+        fprintf(jsonFile, "%s\"%s\"", phase > 0 ? ", " : "", timedPhaseName(phase));
+    }
+
+    fprintf(jsonFile, "],\n  \"load\": {\"total_ns\": %ld, \"parse_ns\": %ld},\n", loadNanos, job->parseNanos);
+
+    int runCount = options->warmup + options->repeats;
+
+    fprintf(jsonFile, "  \"counters\": {\"requested\": %s, \"events\": {", options->counters ? "true" : "false");
+
+    for (int event = 0; event < COUNTED_EVENTS; event++) {
+        fprintf(jsonFile, "%s\"%s\": %s", event > 0 ? ", " : "", countedEventName(event),
+                options->counters && isEventCountedInRuns(runs, runCount, event) ? "true" : "false");
+    }
+
+    fprintf(jsonFile, "}},\n  \"runs\": [\n");
+
+    for (int run = 0; run < runCount; run++) {
+        writeRunJson(jsonFile, &runs[ run ]);
+
+        fprintf(jsonFile, "%s\n", run < runCount - 1 ? "," : "");
+    }
+
+    fprintf(jsonFile, "  ]\n}\n");
+
+    if (fclose(jsonFile) != 0) {
+        fprintf(stderr, "ERROR: Failed to write the benchmark results to %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void runSimulationBenchmark(SimulationEngine *engine, AnalysisMode analysisMode, BitboardKernel bitboardKernel,
+                            const SnapshotOptions *snapshots, FILE *inputFile, FILE *outputFile,
+                            const BenchmarkOptions *options) {
+
+    long loadStart = monotonicNanos();
+
+    SimulationJob *job;
+
+    if (snapshots->binaryInput) {
+        job = engine != NULL ? loadSnapshotJobOnEngine(engine, inputFile) : loadSnapshotJob(inputFile);
+    } else if (engine != NULL) {
+        job = loadSimulationJobOnEngine(engine, inputFile);
+    } else {
+        job = loadSimulationJob(inputFile);
+    }
+
+    long loadNanos = monotonicNanos() - loadStart;
+
+    InputData *simulationData = job->simulationData;
+
+    //Every run starts from the world as it was loaded, the rebalances change the entity counts too
+    size_t worldSize = WORLD_MATRIX_SIZE(simulationData->rows, simulationData->columns),
+            countsSize = sizeof(int) * simulationData->rows;
+
+    WorldSlot *loadedWorld = malloc(worldSize);
+
+    int *loadedCounts = malloc(countsSize), *loadedAccumulatedCounts = malloc(countsSize);
+
+    memcpy(loadedWorld, job->world, worldSize);
+    memcpy(loadedCounts, simulationData->entitiesPerRow, countsSize);
+    memcpy(loadedAccumulatedCounts, simulationData->entitiesAccumulatedPerRow, countsSize);
+
+    int threadCount = engine != NULL ? getEngineThreadCount(engine) : 1;
+
+    struct ThreadedData *sequentialData = NULL;
+
+    if (engine == NULL) {
+        simulationData->threads = 1;
+
+        sequentialData = malloc(sizeof(struct ThreadedData));
+
+        initializeThreadingSystem(1, simulationData, sequentialData);
+
+        setThreadAnalysis(analysisMode, bitboardKernel, sequentialData);
+
+        prepareThreadingSystem(1, simulationData, sequentialData);
+    }
+
+    //Nothing is written for the discarded results, but they are still formatted
+    FILE *discardFile = fopen("/dev/null", "w");
+
+    int runCount = options->warmup + options->repeats;
+
+    BenchmarkRun *runs = calloc(runCount, sizeof(BenchmarkRun));
+
+    for (int run = 0; run < runCount; run++) {
+        BenchmarkRun *current = &runs[ run ];
+
+        int lastRun = run == runCount - 1;
+
+        current->warmup = run < options->warmup;
+
+        memcpy(job->world, loadedWorld, worldSize);
+        memcpy(job->backWorld, loadedWorld, worldSize);
+        memcpy(simulationData->entitiesPerRow, loadedCounts, countsSize);
+        memcpy(simulationData->entitiesAccumulatedPerRow, loadedAccumulatedCounts, countsSize);
+
+        long start = monotonicNanos();
+
+        calculateWorldTopology(simulationData, job->world);
+
+        current->topologyNanos = monotonicNanos() - start;
+
+        current->timers = createPhaseTimers(threadCount, simulationData->firstGeneration,
+                                            simulationData->n_gen - simulationData->firstGeneration);
+
+        if (options->counters) {
+            current->timers->counters = createPhaseCounters(threadCount, TIMED_PHASES);
+        }
+
+        start = monotonicNanos();
+
+        if (engine != NULL) {
+            setEngineTimers(engine, current->timers);
+
+            runSimulationJob(engine, job);
+
+            setEngineTimers(engine, NULL);
+        } else {
+            setThreadTimers(current->timers, sequentialData);
+
+            for (int gen = simulationData->firstGeneration; gen < simulationData->n_gen; gen++) {
+                executeSequentialGeneration(gen, simulationData, sequentialData, job->world, job->backWorld);
+            }
+
+            setThreadTimers(NULL, sequentialData);
+
+            job->micros = (monotonicNanos() - start) / 1000;
+        }
+
+        current->totalNanos = monotonicNanos() - start;
+        current->threads = simulationData->threads;
+
+        if (lastRun) {
+            printf("RESULTS:\n");
+        }
+
+        start = monotonicNanos();
+
+        if (engine != NULL) {
+            outputSimulationJobOnEngine(engine, lastRun ? outputFile : discardFile, job);
+        } else {
+            outputSimulationJob(lastRun ? outputFile : discardFile, job);
+        }
+
+        current->outputNanos = monotonicNanos() - start;
+
+        if (lastRun) {
+            printf("Took %ld microseconds\n", job->micros);
+        }
+    }
+
+    if (options->counters) {
+        warnUncountedEvents(runs, runCount);
+    }
+
+    writeBenchmarkJson(options->outputPath, job, loadedAccumulatedCounts[ simulationData->rows - 1 ], threadCount,
+                       engine == NULL, options, loadNanos, runs);
+
+    for (int run = 0; run < runCount; run++) {
+        destroyPhaseTimers(runs[ run ].timers);
+    }
+
+    free(runs);
+
+    fclose(discardFile);
+
+    if (sequentialData != NULL) {
+        destroyThreadingSystem(1, sequentialData);
+    }
+
+    free(loadedWorld);
+    free(loadedCounts);
+    free(loadedAccumulatedCounts);
+
+    destroySimulationJob(job);
+}
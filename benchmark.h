@@ -0,0 +1,62 @@
+#ifndef TRABALHO_2_BENCHMARK_H
+#define TRABALHO_2_BENCHMARK_H
+
+#include <stdio.h>
+#include "engine.h"
+
+#define DEFAULT_BENCHMARK_WARMUP 1
+
+#define DEFAULT_BENCHMARK_REPEATS 3
+
+#define DEFAULT_BENCHMARK_OUTPUT "benchmark.json"
+
+/*
+ * In process benchmark (--benchmark).
+ *
+ * The world is loaded once and then simulated warmup + repeats times, every run starting from a copy of the loaded
+ * world, with the phases of every thread timed for every generation (see timers.h). The topology is built again and
+ * the results formatted at the end of every run, to time them too, but only the last run writes its results.
+ *
+ * The times go to a JSON file:
+ *  {
+ *    "world": { "rows", "columns", "generations", "first_generation", "entities", "rocks" },
+ *    "threads": the threads of the engine (1 when sequential), "sequential": true or false,
+ *    "warmup", "repeats", "phases": [ the names of the phases, in the order of the per thread arrays ],
+ *    "load": { "total_ns", "parse_ns" },
+ *    "runs": [ { "warmup": true for the warmup runs, "threads": the threads the run used,
+ *                "total_ns", "topology_ns", "output_ns",
+ *                "phase_totals_ns": { phase: nanoseconds of every thread added up },
+ *                "per_thread": [ { "totals_ns": { phase: nanoseconds },
+ *                                  "generations_ns": { phase: [ nanoseconds of every generation ] } } ],
+ *                "counters": null, or with --benchmark-counters
+ *                            { "phase_totals": { phase: { event: count of every thread added up } },
+ *                              "per_thread": [ { phase: { event: count } } ] } } ],
+ *    "counters": { "requested": true or false, "events": { event: true when every thread could count it } }
+ *  }
+ *
+ * Only the events every thread counted are in the totals of a run, a thread only has the events it counted. When
+ * none can be counted the benchmark goes on with its timers, and says which ones are missing (and why) on stderr.
+ */
+typedef struct BenchmarkOptions_ {
+
+    int warmup, repeats;
+
+    //Where the JSON results are written
+    const char *outputPath;
+
+    //Count the hardware events of every phase too (see counters.h)
+    int counters;
+
+} BenchmarkOptions;
+
+/**
+ * Benchmark the simulation of the world in inputFile and write its results to outputFile
+ * @param engine The engine to run the world on, NULL to run it on the calling thread like runSequentialSimulation
+ * @param analysisMode How the moves are found when running sequentially, the engine has its own
+ * @param snapshots Only binaryInput is used, checkpoints and snapshot output are not taken while benchmarking
+ */
+void runSimulationBenchmark(SimulationEngine *engine, AnalysisMode analysisMode, BitboardKernel bitboardKernel,
+                            const SnapshotOptions *snapshots, FILE *inputFile, FILE *outputFile,
+                            const BenchmarkOptions *options);
+
+#endif //TRABALHO_2_BENCHMARK_H
@@ -22,6 +22,8 @@ EXECUTABLE = './ecosystem'
 ECOSYSTEM_DIR = 'ecosystem_examples'
 RESULTS_FILE = 'benchmark_results.json'
 PLOTS_DIR = 'benchmark_plots'
+# Also count the cycles, instructions, cache misses and context switches of every phase, when the kernel allows it
+COUNT_EVENTS = True
 
 class BenchmarkRunner:
     def __init__(self):
@@ -47,94 +49,80 @@ class BenchmarkRunner:
         """Get the input file path for a given input size"""
         return f"{ECOSYSTEM_DIR}/input{input_size}"
     
-    def run_single_benchmark(self, input_size, thread_count, runs=3):
-        """Run a single benchmark configuration multiple times and return average time"""
+    def run_single_benchmark(self, input_size, thread_count, runs=3, warmup=1):
+        """Run a benchmark configuration with the built-in benchmark mode and return its times"""
         input_file = self.get_input_file(input_size)
         
         if not os.path.exists(input_file):
             print(f"Warning: Input file {input_file} not found, skipping...")
             return None
         
-        times = []
         print(f"  Running {input_size} with {thread_count if thread_count > 0 else 'sequential'} thread(s)...", end=' ')
         
-        for run in range(runs):
-            try:
-                # Run the simulation and parse execution time from output
-                with open(input_file, 'r') as f:
-                    result = subprocess.run(
-                        [EXECUTABLE, str(thread_count)],
-                        stdin=f,
-                        capture_output=True,
-                        text=True,
-                        timeout=300  # 5 minute timeout
-                    )
-                
-                if result.returncode != 0:
-                    print(f"\nError in run {run+1}: {result.stderr}")
-                    continue
-                
-                # Parse execution time from the output for parallel runs only
-                # Sequential runs don't output timing info, so we use process timing
-                execution_time = None
-                
-                if thread_count > 0:  # Parallel execution
-                    for line in result.stdout.split('\n'):
-                        if 'Took' in line and 'microseconds' in line:
-                            try:
-                                # Extract microseconds from "Took X microseconds"
-                                parts = line.split()
-                                microseconds_idx = parts.index('microseconds')
-                                microseconds = int(parts[microseconds_idx - 1])
-                                execution_time = microseconds / 1_000_000  # Convert to seconds
-                                break
-                            except (ValueError, IndexError):
-                                continue
-                
-                # For sequential or if timing not found, measure process time
-                if execution_time is None:
-                    # Measure actual execution time excluding I/O
-                    start_time = time.perf_counter()
-                    with open(input_file, 'r') as f:
-                        process_result = subprocess.run(
-                            [EXECUTABLE, str(thread_count)],
-                            stdin=f,
-                            stdout=subprocess.DEVNULL,  # Suppress output for timing
-                            stderr=subprocess.PIPE,
-                            text=True,
-                            timeout=300
-                        )
-                    end_time = time.perf_counter()
-                    
-                    if process_result.returncode != 0:
-                        print(f"\nError in timing run {run+1}: {process_result.stderr}")
-                        continue
-                        
-                    execution_time = end_time - start_time
-                
-                times.append(execution_time)
-                print(f"{execution_time:.3f}s", end=' ')
-                
-            except subprocess.TimeoutExpired:
-                print(f"\nTimeout in run {run+1}")
-                continue
-            except Exception as e:
-                print(f"\nException in run {run+1}: {e}")
-                continue
-        
-        if not times:
+        # The simulation times itself, with the warmup runs and the repeats in a single process,
+        # and writes the time of every phase to a JSON file
+        json_file = f'benchmark_{input_size}_{thread_count}.json'
+        
+        try:
+            with open(input_file, 'r') as f:
+                result = subprocess.run(
+                    [EXECUTABLE, str(thread_count), f'--benchmark={warmup},{runs}', f'--benchmark-output={json_file}']
+                    + (['--benchmark-counters'] if COUNT_EVENTS else []),
+                    stdin=f,
+                    stdout=subprocess.DEVNULL,
+                    stderr=subprocess.PIPE,
+                    text=True,
+                    timeout=300 * (warmup + runs)  # 5 minutes per run
+                )
+            
+            if result.returncode != 0:
+                print(f"\nError: {result.stderr}")
+                print("FAILED")
+                return None
+            
+            with open(json_file, 'r') as f:
+                report = json.load(f)
+        except subprocess.TimeoutExpired:
+            print("\nTimeout")
             print("FAILED")
             return None
+        finally:
+            if os.path.exists(json_file):
+                os.remove(json_file)
+        
+        measured = [run for run in report['runs'] if not run['warmup']]
+        
+        times = [run['total_ns'] / 1e9 for run in measured]
+        
+        for execution_time in times:
+            print(f"{execution_time:.3f}s", end=' ')
         
         avg_time = sum(times) / len(times)
         std_dev = np.std(times) if len(times) > 1 else 0
         print(f"-> avg: {avg_time:.3f}s ±{std_dev:.3f}s")
         
+        # Average time of every phase, added up over the threads
+        phases = {phase: sum(run['phase_totals_ns'][phase] for run in measured) / len(measured) / 1e9
+                  for phase in report['phases']}
+        
+        # Average count of every event the threads could count in every phase, added up over the threads
+        counted = [event for event, available in report['counters']['events'].items() if available]
+        counters = {phase: {event: sum(run['counters']['phase_totals'][phase][event]
+                                       for run in measured) / len(measured)
+                            for event in counted}
+                    for phase in report['phases']} if counted else None
+        
         return {
             'average': avg_time,
             'std_dev': std_dev,
             'times': times,
-            'runs': len(times)
+            'runs': len(times),
+            'phases': phases,
+            'counters': counters,
+            'topology': sum(run['topology_ns'] for run in measured) / len(measured) / 1e9,
+            'output': sum(run['output_ns'] for run in measured) / len(measured) / 1e9,
+            'load': report['load']['total_ns'] / 1e9,
+            'parse': report['load']['parse_ns'] / 1e9
         }
     
     def run_all_benchmarks(self):
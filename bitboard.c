@@ -0,0 +1,361 @@
+#include "bitboard.h"
+#include "occupancy.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BITBOARD_X86 1
+#else
+#define BITBOARD_X86 0
+#endif
+
+#define DIRECTIONS 4
+
+//The planes of a row and of the rows above and below it, NULL outside the world
+typedef struct RowPlanes_ {
+
+    const uint64_t *occupied, *foxes, *rocks;
+
+    const uint64_t *occupiedAbove, *rocksAbove, *foxesAbove;
+
+    const uint64_t *occupiedBelow, *rocksBelow, *foxesBelow;
+
+    int words;
+
+    //Slots of the last word that are inside the world
+    uint64_t lastWordMask;
+
+} RowPlanes;
+
+static void loadRowPlanes(InputData *data, WorldSlot *world, int row, RowPlanes *planes) {
+    planes->occupied = occupancyRow(data, world, row);
+    planes->foxes = foxRow(data, world, row);
+    planes->rocks = rockRow(data, world, row);
+
+    planes->occupiedAbove = row > 0 ? occupancyRow(data, world, row - 1) : NULL;
+    planes->foxesAbove = row > 0 ? foxRow(data, world, row - 1) : NULL;
+    planes->rocksAbove = row > 0 ? rockRow(data, world, row - 1) : NULL;
+
+    planes->occupiedBelow = row < data->rows - 1 ? occupancyRow(data, world, row + 1) : NULL;
+    planes->foxesBelow = row < data->rows - 1 ? foxRow(data, world, row + 1) : NULL;
+    planes->rocksBelow = row < data->rows - 1 ? rockRow(data, world, row + 1) : NULL;
+
+    planes->words = OCCUPANCY_WORDS(data->columns);
+    planes->lastWordMask = ~0ULL >> (planes->words * 64 - data->columns);
+}
+
+static uint64_t emptyWord(const uint64_t *occupied, const uint64_t *rocks, const RowPlanes *planes, int word) {
+    if (occupied == NULL || word < 0 || word >= planes->words) return 0;
+
+    uint64_t empty = ~(occupied[ word ] | rocks[ word ]);
+
+    return word == planes->words - 1 ? empty & planes->lastWordMask : empty;
+}
+
+static uint64_t rabbitWord(const uint64_t *occupied, const uint64_t *foxes, const RowPlanes *planes, int word) {
+    if (occupied == NULL || word < 0 || word >= planes->words) return 0;
+
+    return occupied[ word ] & ~foxes[ word ];
+}
+
+//A word at a time, works for every word of the row
+static void classifyWord(const RowPlanes *planes, int word, int withRabbits, NeighbourMasks *masks) {
+    uint64_t empty = emptyWord(planes->occupied, planes->rocks, planes, word);
+
+    masks->empty[ NORTH ][ word ] = emptyWord(planes->occupiedAbove, planes->rocksAbove, planes, word);
+    masks->empty[ SOUTH ][ word ] = emptyWord(planes->occupiedBelow, planes->rocksBelow, planes, word);
+    masks->empty[ EAST ][ word ] = (empty >> 1) | (emptyWord(planes->occupied, planes->rocks, planes, word + 1) << 63);
+    masks->empty[ WEST ][ word ] = (empty << 1) | (emptyWord(planes->occupied, planes->rocks, planes, word - 1) >> 63);
+
+    if (!withRabbits) return;
+
+    uint64_t rabbits = rabbitWord(planes->occupied, planes->foxes, planes, word);
+
+    masks->rabbits[ NORTH ][ word ] = rabbitWord(planes->occupiedAbove, planes->foxesAbove, planes, word);
+    masks->rabbits[ SOUTH ][ word ] = rabbitWord(planes->occupiedBelow, planes->foxesBelow, planes, word);
+    masks->rabbits[ EAST ][ word ] = (rabbits >> 1) | (rabbitWord(planes->occupied, planes->foxes, planes, word + 1) << 63);
+    masks->rabbits[ WEST ][ word ] = (rabbits << 1) | (rabbitWord(planes->occupied, planes->foxes, planes, word - 1) >> 63);
+}
+
+#if BITBOARD_X86
+
+/*
+ * The vector kernels only do the words that have a word on both sides and are whole (not the last word of the row),
+ * starting at firstWord and while a whole vector fits before lastWord. They return the first word they did not do
+ */
+
+__attribute__((target("sse2")))
+static int classifyWordsSse2(const RowPlanes *planes, int firstWord, int lastWord, int withRabbits,
+                             NeighbourMasks *masks) {
+    const __m128i zero = _mm_setzero_si128(), ones = _mm_set1_epi32(-1);
+
+    int word = firstWord;
+
+    for (; word + 1 <= lastWord; word += 2) {
+#define LOAD(plane, offset) _mm_loadu_si128((const __m128i *) &(plane)[ word + (offset) ])
+#define EMPTY(occupied, rocks, offset) ((occupied) == NULL ? zero : \
+        _mm_andnot_si128(_mm_or_si128(LOAD(occupied, offset), LOAD(rocks, offset)), ones))
+#define RABBITS(occupied, foxes, offset) ((occupied) == NULL ? zero : \
+        _mm_andnot_si128(LOAD(foxes, offset), LOAD(occupied, offset)))
+
+        __m128i empty = EMPTY(planes->occupied, planes->rocks, 0);
+
+        _mm_storeu_si128((__m128i *) &masks->empty[ NORTH ][ word ], EMPTY(planes->occupiedAbove, planes->rocksAbove, 0));
+        _mm_storeu_si128((__m128i *) &masks->empty[ SOUTH ][ word ], EMPTY(planes->occupiedBelow, planes->rocksBelow, 0));
+        _mm_storeu_si128((__m128i *) &masks->empty[ EAST ][ word ],
+                         _mm_or_si128(_mm_srli_epi64(empty, 1),
+                                      _mm_slli_epi64(EMPTY(planes->occupied, planes->rocks, 1), 63)));
+        _mm_storeu_si128((__m128i *) &masks->empty[ WEST ][ word ],
+                         _mm_or_si128(_mm_slli_epi64(empty, 1),
+                                      _mm_srli_epi64(EMPTY(planes->occupied, planes->rocks, -1), 63)));
+
+        if (withRabbits) {
+            __m128i rabbits = RABBITS(planes->occupied, planes->foxes, 0);
+
+            _mm_storeu_si128((__m128i *) &masks->rabbits[ NORTH ][ word ], RABBITS(planes->occupiedAbove, planes->foxesAbove, 0));
+            _mm_storeu_si128((__m128i *) &masks->rabbits[ SOUTH ][ word ], RABBITS(planes->occupiedBelow, planes->foxesBelow, 0));
+            _mm_storeu_si128((__m128i *) &masks->rabbits[ EAST ][ word ],
+                             _mm_or_si128(_mm_srli_epi64(rabbits, 1),
+                                          _mm_slli_epi64(RABBITS(planes->occupied, planes->foxes, 1), 63)));
+            _mm_storeu_si128((__m128i *) &masks->rabbits[ WEST ][ word ],
+                             _mm_or_si128(_mm_slli_epi64(rabbits, 1),
+                                          _mm_srli_epi64(RABBITS(planes->occupied, planes->foxes, -1), 63)));
+        }
+
+#undef LOAD
+#undef EMPTY
+#undef RABBITS
+    }
+
+    return word;
+}
+
+__attribute__((target("avx2")))
+static int classifyWordsAvx2(const RowPlanes *planes, int firstWord, int lastWord, int withRabbits,
+                             NeighbourMasks *masks) {
+    const __m256i zero = _mm256_setzero_si256(), ones = _mm256_set1_epi32(-1);
+
+    int word = firstWord;
+
+    for (; word + 3 <= lastWord; word += 4) {
+#define LOAD(plane, offset) _mm256_loadu_si256((const __m256i *) &(plane)[ word + (offset) ])
+#define EMPTY(occupied, rocks, offset) ((occupied) == NULL ? zero : \
+        _mm256_andnot_si256(_mm256_or_si256(LOAD(occupied, offset), LOAD(rocks, offset)), ones))
+#define RABBITS(occupied, foxes, offset) ((occupied) == NULL ? zero : \
+        _mm256_andnot_si256(LOAD(foxes, offset), LOAD(occupied, offset)))
+
+        __m256i empty = EMPTY(planes->occupied, planes->rocks, 0);
+
+        _mm256_storeu_si256((__m256i *) &masks->empty[ NORTH ][ word ], EMPTY(planes->occupiedAbove, planes->rocksAbove, 0));
+        _mm256_storeu_si256((__m256i *) &masks->empty[ SOUTH ][ word ], EMPTY(planes->occupiedBelow, planes->rocksBelow, 0));
+        _mm256_storeu_si256((__m256i *) &masks->empty[ EAST ][ word ],
+                            _mm256_or_si256(_mm256_srli_epi64(empty, 1),
+                                            _mm256_slli_epi64(EMPTY(planes->occupied, planes->rocks, 1), 63)));
+        _mm256_storeu_si256((__m256i *) &masks->empty[ WEST ][ word ],
+                            _mm256_or_si256(_mm256_slli_epi64(empty, 1),
+                                            _mm256_srli_epi64(EMPTY(planes->occupied, planes->rocks, -1), 63)));
+
+        if (withRabbits) {
+            __m256i rabbits = RABBITS(planes->occupied, planes->foxes, 0);
+
+            _mm256_storeu_si256((__m256i *) &masks->rabbits[ NORTH ][ word ], RABBITS(planes->occupiedAbove, planes->foxesAbove, 0));
+            _mm256_storeu_si256((__m256i *) &masks->rabbits[ SOUTH ][ word ], RABBITS(planes->occupiedBelow, planes->foxesBelow, 0));
+            _mm256_storeu_si256((__m256i *) &masks->rabbits[ EAST ][ word ],
+                                _mm256_or_si256(_mm256_srli_epi64(rabbits, 1),
+                                                _mm256_slli_epi64(RABBITS(planes->occupied, planes->foxes, 1), 63)));
+            _mm256_storeu_si256((__m256i *) &masks->rabbits[ WEST ][ word ],
+                                _mm256_or_si256(_mm256_slli_epi64(rabbits, 1),
+                                                _mm256_srli_epi64(RABBITS(planes->occupied, planes->foxes, -1), 63)));
+        }
+
+#undef LOAD
+#undef EMPTY
+#undef RABBITS
+    }
+
+    return word;
+}
+
+#endif
+
+static BitboardKernel bestSupportedKernel() {
+#if BITBOARD_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) return BITBOARD_AVX2;
+    if (__builtin_cpu_supports("sse2")) return BITBOARD_SSE2;
+#endif
+
+    return BITBOARD_WORDS;
+}
+
+static int isKernelSupported(BitboardKernel kernel) {
+    switch (kernel) {
+        case BITBOARD_WORDS:
+            return 1;
+#if BITBOARD_X86
+        case BITBOARD_SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case BITBOARD_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return 0;
+    }
+}
+
+const char *bitboardKernelName(BitboardKernel kernel) {
+    switch (kernel) {
+        case BITBOARD_AUTO:
+            return "auto";
+        case BITBOARD_WORDS:
+            return "words";
+        case BITBOARD_SSE2:
+            return "sse2";
+        case BITBOARD_AVX2:
+            return "avx2";
+        default:
+            return "unknown";
+    }
+}
+
+NeighbourMasks *createNeighbourMasks(BitboardKernel kernel) {
+    if (kernel == BITBOARD_AUTO) {
+        kernel = bestSupportedKernel();
+    } else if (!isKernelSupported(kernel)) {
+        fprintf(stderr, "The CPU does not support the %s bitboard kernel\n", bitboardKernelName(kernel));
+        exit(EXIT_FAILURE);
+    }
+
+    NeighbourMasks *masks = malloc(sizeof(NeighbourMasks));
+
+    masks->capacity = 0;
+    masks->kernel = kernel;
+
+    for (int direction = 0; direction < DIRECTIONS; direction++) {
+        masks->empty[ direction ] = NULL;
+        masks->rabbits[ direction ] = NULL;
+    }
+
+    return masks;
+}
+
+void ensureNeighbourMasksCapacity(NeighbourMasks *masks, int words) {
+    if (words <= masks->capacity) return;
+
+    masks->capacity = words;
+
+    for (int direction = 0; direction < DIRECTIONS; direction++) {
+        masks->empty[ direction ] = realloc(masks->empty[ direction ], sizeof(uint64_t) * words);
+        masks->rabbits[ direction ] = realloc(masks->rabbits[ direction ], sizeof(uint64_t) * words);
+    }
+}
+
+void classifyRowNeighbours(InputData *data, WorldSlot *world, int row, int firstWord, int lastWord, int withRabbits,
+                           NeighbourMasks *masks) {
+    RowPlanes planes;
+
+    loadRowPlanes(data, world, row, &planes);
+
+    int word = firstWord;
+
+    //The first word of the row has no word before it, and the last one has none after it and is not whole
+    if (word == 0 && word <= lastWord) {
+        classifyWord(&planes, word++, withRabbits, masks);
+    }
+
+    int vectorLastWord = lastWord < planes.words - 2 ? lastWord : planes.words - 2;
+
+#if BITBOARD_X86
+    if (masks->kernel == BITBOARD_AVX2) {
+        word = classifyWordsAvx2(&planes, word, vectorLastWord, withRabbits, masks);
+    }
+
+    if (masks->kernel == BITBOARD_AVX2 || masks->kernel == BITBOARD_SSE2) {
+        word = classifyWordsSse2(&planes, word, vectorLastWord, withRabbits, masks);
+    }
+#endif
+
+    for (; word <= lastWord; word++) {
+        classifyWord(&planes, word, withRabbits, masks);
+    }
+}
+
+int classifyOccupiedWords(InputData *data, WorldSlot *world, int row, int firstWord, int lastWord, int withRabbits,
+                          NeighbourMasks *masks) {
+    const uint64_t *occupied = occupancyRow(data, world, row);
+
+    int runEnd = firstWord;
+
+    while (runEnd < lastWord && occupied[ runEnd + 1 ] != 0) {
+        runEnd++;
+    }
+
+    classifyRowNeighbours(data, world, row, firstWord, runEnd, withRabbits, masks);
+
+    return runEnd;
+}
+
+//Bit d is set when the mask of MoveDirection d is set for the column
+static unsigned int directionsAt(uint64_t *const directionMasks[ DIRECTIONS ], int col) {
+    int word = col / 64, bit = col % 64;
+
+    return (unsigned int) (((directionMasks[ NORTH ][ word ] >> bit) & 1) |
+                           (((directionMasks[ EAST ][ word ] >> bit) & 1) << 1) |
+                           (((directionMasks[ SOUTH ][ word ] >> bit) & 1) << 2) |
+                           (((directionMasks[ WEST ][ word ] >> bit) & 1) << 3));
+}
+
+void bitboardRabbitMovementOptions(NeighbourMasks *masks, int col, struct RabbitMovements *result) {
+    result->emptyDirections = (unsigned char) directionsAt(masks->empty, col);
+    result->emptyMovements = __builtin_popcount(result->emptyDirections);
+}
+
+void bitboardFoxMovementOptions(NeighbourMasks *masks, int col, struct FoxMovements *result) {
+    result->rabbitDirections = (unsigned char) directionsAt(masks->rabbits, col);
+    result->rabbitMovements = __builtin_popcount(result->rabbitDirections);
+    result->emptyDirections = (unsigned char) directionsAt(masks->empty, col);
+    result->emptyMovements = __builtin_popcount(result->emptyDirections);
+}
+
+void validateRabbitMovementOptions(int row, int col, InputData *data, WorldSlot *world, struct RabbitMovements *options) {
+    struct RabbitMovements expected;
+
+    analyzeRabbitMovementOptions(row, col, data, world, &expected);
+
+    if (options->emptyDirections != expected.emptyDirections || options->emptyMovements != expected.emptyMovements) {
+        fprintf(stderr, "ERROR: Bitboard moves of the rabbit at %d %d (empty %#x) don't match the scalar ones "
+                        "(empty %#x)\n", row, col, options->emptyDirections, expected.emptyDirections);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void validateFoxMovementOptions(int row, int col, InputData *data, WorldSlot *world, struct FoxMovements *options) {
+    struct FoxMovements expected;
+
+    analyzeFoxMovementOptions(row, col, data, world, &expected);
+
+    if (options->emptyDirections != expected.emptyDirections || options->emptyMovements != expected.emptyMovements ||
+        options->rabbitDirections != expected.rabbitDirections || options->rabbitMovements != expected.rabbitMovements) {
+        fprintf(stderr, "ERROR: Bitboard moves of the fox at %d %d (empty %#x, rabbits %#x) don't match the scalar "
+                        "ones (empty %#x, rabbits %#x)\n", row, col, options->emptyDirections,
+                options->rabbitDirections, expected.emptyDirections, expected.rabbitDirections);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void destroyNeighbourMasks(NeighbourMasks *masks) {
+    if (masks == NULL) {
+        return;
+    }
+
+    for (int direction = 0; direction < DIRECTIONS; direction++) {
+        free(masks->empty[ direction ]);
+        free(masks->rabbits[ direction ]);
+    }
+
+    free(masks);
+}
@@ -0,0 +1,75 @@
+#ifndef TRABALHO_2_BITBOARD_H
+#define TRABALHO_2_BITBOARD_H
+
+#include <stdint.h>
+#include "rabbitsandfoxes.h"
+#include "movements.h"
+
+/*
+ * Bitboard neighbour classification (ANALYSIS_BITBOARD).
+ *
+ * Instead of looking at the neighbours of every animal slot by slot, the occupancy, fox and rock planes of the
+ * front buffer (see occupancy.h) are combined a whole row at a time into masks that say, for every slot of the row,
+ * whether the slot next to it in each direction is empty and whether it holds a rabbit. The masks of a row take a
+ * few shifts per 64 slots, and with SSE2 or AVX2 the row is done 128 or 256 slots at a time. The move options of an
+ * animal are then 4 bits picked out of the masks.
+ *
+ * The planes always match the slots, so the options are the same analyze*MovementOptions finds (build with
+ * VALIDATE_BITBOARD to check every animal against it).
+ */
+
+typedef struct NeighbourMasks_ {
+
+    //Words every mask can hold, one per 64 columns of the world
+    int capacity;
+
+    //Bit col % 64 of word col / 64 of empty[d] is set when the slot next to column col in MoveDirection d is
+    //empty (inside the world, not a rock nor an animal). rabbits[d] is the same for the slots holding a rabbit
+    uint64_t *empty[4], *rabbits[4];
+
+    //The kernel the masks are computed with
+    BitboardKernel kernel;
+
+} NeighbourMasks;
+
+/**
+ * Create the masks of a thread. BITBOARD_AUTO picks the widest kernel the CPU supports, asking for a kernel the CPU
+ * does not support is an error
+ */
+NeighbourMasks *createNeighbourMasks(BitboardKernel kernel);
+
+void ensureNeighbourMasksCapacity(NeighbourMasks *masks, int words);
+
+/**
+ * Compute the masks of the words firstWord to lastWord of a row of world, which must not be changing
+ * @param withRabbits Also compute the rabbit masks (only the foxes need them)
+ */
+void classifyRowNeighbours(InputData *data, WorldSlot *world, int row, int firstWord, int lastWord, int withRabbits,
+                           NeighbourMasks *masks);
+
+/**
+ * Compute the masks of the run of words of a row that hold animals, from firstWord up to lastWord at most. This way
+ * the words of a crowded row are classified together, and the empty stretches of a sparse one are skipped
+ * @return The last word of the run
+ */
+int classifyOccupiedWords(InputData *data, WorldSlot *world, int row, int firstWord, int lastWord, int withRabbits,
+                          NeighbourMasks *masks);
+
+//Same results as analyzeRabbitMovementOptions, from the masks of the row of the rabbit
+void bitboardRabbitMovementOptions(NeighbourMasks *masks, int col, struct RabbitMovements *result);
+
+//Same results as analyzeFoxMovementOptions, from the masks of the row of the fox
+void bitboardFoxMovementOptions(NeighbourMasks *masks, int col, struct FoxMovements *result);
+
+/**
+ * Compare the options found with the bitboard with the ones analyze*MovementOptions finds, exits on a mismatch
+ */
+void validateRabbitMovementOptions(int row, int col, InputData *data, WorldSlot *world, struct RabbitMovements *options);
+
+void validateFoxMovementOptions(int row, int col, InputData *data, WorldSlot *world, struct FoxMovements *options);
+
+const char *bitboardKernelName(BitboardKernel kernel);
+
+void destroyNeighbourMasks(NeighbourMasks *masks);
+
+#endif //TRABALHO_2_BITBOARD_H
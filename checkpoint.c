@@ -0,0 +1,144 @@
+#include "checkpoint.h"
+#include "occupancy.h"
+#include "snapshot.h"
+#include "output.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void *runCheckpointWriter(void *args) {
+    CheckpointWriter *checkpoints = args;
+
+    size_t pathLength = strlen(checkpoints->path);
+
+    char *temporaryPath = malloc(pathLength + sizeof(".tmp"));
+
+    memcpy(temporaryPath, checkpoints->path, pathLength);
+    memcpy(&temporaryPath[ pathLength ], ".tmp", sizeof(".tmp"));
+
+    pthread_mutex_lock(&checkpoints->lock);
+
+    while (1) {
+        while (!checkpoints->pending && !checkpoints->shutdown) {
+            pthread_cond_wait(&checkpoints->posted, &checkpoints->lock);
+        }
+
+        if (!checkpoints->pending) {
+            break;
+        }
+
+        //The simulation does not touch the buffer while it is pending
+        pthread_mutex_unlock(&checkpoints->lock);
+
+        saveWorldSnapshot(temporaryPath, checkpoints->simulationData, checkpoints->buffer, checkpoints->generation);
+
+        if (rename(temporaryPath, checkpoints->path) != 0) {
+            fprintf(stderr, "ERROR: Failed to move the checkpoint to %s\n", checkpoints->path);
+            exit(EXIT_FAILURE);
+        }
+
+        pthread_mutex_lock(&checkpoints->lock);
+
+        checkpoints->pending = 0;
+
+        pthread_cond_broadcast(&checkpoints->written);
+    }
+
+    pthread_mutex_unlock(&checkpoints->lock);
+
+    free(temporaryPath);
+
+    return NULL;
+}
+
+CheckpointWriter *createCheckpointWriter(const char *path, int interval, InputData *simulationData) {
+    CheckpointWriter *checkpoints = malloc(sizeof(CheckpointWriter));
+
+    checkpoints->path = path;
+    checkpoints->interval = interval;
+    checkpoints->simulationData = simulationData;
+    checkpoints->buffer = malloc(WORLD_MATRIX_SIZE(simulationData->rows, simulationData->columns));
+    checkpoints->generation = 0;
+    checkpoints->pending = 0;
+    checkpoints->shutdown = 0;
+
+    if (checkpoints->buffer == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate the checkpoint buffer\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_mutex_init(&checkpoints->lock, NULL);
+    pthread_cond_init(&checkpoints->posted, NULL);
+    pthread_cond_init(&checkpoints->written, NULL);
+
+    pthread_create(&checkpoints->thread, NULL, runCheckpointWriter, checkpoints);
+
+    return checkpoints;
+}
+
+int isCheckpointDue(CheckpointWriter *checkpoints, int generation) {
+    //A finished simulation has nothing left to resume
+    return generation % checkpoints->interval == 0 && generation < checkpoints->simulationData->n_gen;
+}
+
+void waitForCheckpointWriter(CheckpointWriter *checkpoints) {
+    pthread_mutex_lock(&checkpoints->lock);
+
+    while (checkpoints->pending) {
+        pthread_cond_wait(&checkpoints->written, &checkpoints->lock);
+    }
+
+    pthread_mutex_unlock(&checkpoints->lock);
+}
+
+void copyCheckpointPart(CheckpointWriter *checkpoints, WorldSlot *world, int part, int parts) {
+    InputData *simulationData = checkpoints->simulationData;
+
+    //The even split of the rows the workers first touch their bands of the world with (see placement.h), so the
+    //buffer is placed like the world. Parts past the rows (tiles) copy nothing
+    int startRow = (int) ((long) part * simulationData->rows / parts),
+        endRow = (int) ((long) (part + 1) * simulationData->rows / parts) - 1;
+
+    if (endRow >= startRow) {
+        copyWorldRows(simulationData, world, checkpoints->buffer, startRow, endRow);
+    }
+}
+
+void postCheckpoint(CheckpointWriter *checkpoints, int generation) {
+    pthread_mutex_lock(&checkpoints->lock);
+
+    checkpoints->generation = generation;
+    checkpoints->pending = 1;
+
+    pthread_cond_signal(&checkpoints->posted);
+
+    pthread_mutex_unlock(&checkpoints->lock);
+}
+
+void takeCheckpoint(CheckpointWriter *checkpoints, WorldSlot *world, int generation) {
+    waitForCheckpointWriter(checkpoints);
+
+    copyCheckpointPart(checkpoints, world, 0, 1);
+
+    postCheckpoint(checkpoints, generation);
+}
+
+void destroyCheckpointWriter(CheckpointWriter *checkpoints) {
+    pthread_mutex_lock(&checkpoints->lock);
+
+    checkpoints->shutdown = 1;
+
+    pthread_cond_signal(&checkpoints->posted);
+
+    pthread_mutex_unlock(&checkpoints->lock);
+
+    //The writer only stops once nothing is pending
+    pthread_join(checkpoints->thread, NULL);
+
+    pthread_mutex_destroy(&checkpoints->lock);
+    pthread_cond_destroy(&checkpoints->posted);
+    pthread_cond_destroy(&checkpoints->written);
+
+    free(checkpoints->buffer);
+    free(checkpoints);
+}
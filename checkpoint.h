@@ -0,0 +1,77 @@
+#ifndef TRABALHO_2_CHECKPOINT_H
+#define TRABALHO_2_CHECKPOINT_H
+
+#include <pthread.h>
+#include "rabbitsandfoxes.h"
+
+/*
+ * Periodic checkpoints of a simulation.
+ *
+ * Every interval generations the simulation stops at the end of a generation, when the whole state is in the front
+ * buffer, and copies it into the buffer of the writer (every thread copies its part of the bytes). A background
+ * thread then writes the copy as a snapshot (see snapshot.h) while the simulation goes on, first to a temporary file
+ * that is renamed over the checkpoint once it is complete, so an interrupted write never leaves a broken checkpoint.
+ *
+ * If the previous checkpoint is still being written when the next one is due, the simulation waits for it.
+ * Resuming from a checkpoint (--resume) continues from the generation it was taken at and ends with the same world
+ * as a run that was never interrupted, the age and food of every animal are part of the snapshot.
+ */
+
+#define DEFAULT_CHECKPOINT_PATH "ecosystem.checkpoint"
+
+typedef struct CheckpointWriter_ {
+
+    const char *path;
+
+    //Generations between checkpoints
+    int interval;
+
+    InputData *simulationData;
+
+    //Copy of the world being written, and the generations that had been simulated when it was taken
+    WorldSlot *buffer;
+
+    int generation;
+
+    //Set while the buffer holds a copy that is not written yet
+    int pending;
+
+    int shutdown;
+
+    pthread_t thread;
+
+    pthread_mutex_t lock;
+
+    pthread_cond_t posted, written;
+
+} CheckpointWriter;
+
+/**
+ * Start the background writer of the checkpoints of a world
+ * @param interval Generations between checkpoints
+ */
+CheckpointWriter *createCheckpointWriter(const char *path, int interval, InputData *simulationData);
+
+//1 when a checkpoint has to be taken once the given number of generations were simulated
+int isCheckpointDue(CheckpointWriter *checkpoints, int generation);
+
+//Wait for the previous checkpoint to be written, so the buffer can take the next one
+void waitForCheckpointWriter(CheckpointWriter *checkpoints);
+
+/**
+ * Copy a part of the world into the buffer of the writer, the world is split in bands of the same number of rows
+ */
+void copyCheckpointPart(CheckpointWriter *checkpoints, WorldSlot *world, int part, int parts);
+
+//Hand the copied world to the background thread, once every part of it is copied
+void postCheckpoint(CheckpointWriter *checkpoints, int generation);
+
+//Take a checkpoint on the calling thread alone
+void takeCheckpoint(CheckpointWriter *checkpoints, WorldSlot *world, int generation);
+
+/**
+ * Wait for the last checkpoint to be written and stop the writer
+ */
+void destroyCheckpointWriter(CheckpointWriter *checkpoints);
+
+#endif //TRABALHO_2_CHECKPOINT_H
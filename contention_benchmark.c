@@ -0,0 +1,238 @@
+/*
+ * Per thread state contention microbenchmark
+ *
+ * Usage: contention_benchmark [rows] [rounds] [max threads], e.g. contention_benchmark 100 200000 32
+ *
+ * Every thread does what the threads of a generation do to the state the other threads can see, over and over:
+ * counts entities in the rows of its band, adds conflicts to its lists, and moves its phase counter on while
+ * polling the counters of the threads next to it. It is run with 1, 2, 4, ... up to max threads, comparing:
+ *  - the packed layout the threads used to have: one array of row counts for the whole world (the bands share the
+ *    lines at their edges, with few rows per thread several bands share a line), the conflicts and phase counters
+ *    of the threads back to back
+ *  - the padded layout: every thread counts in its own cache aligned array, and has its conflicts and phase counter
+ *    in its own WorkerBlock
+ *
+ * Both must count the same entities, the total is checked. The difference only shows with the threads on different
+ * cores: on a single core the threads never write the same line at the same time.
+ */
+
+#include "threads.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+//Entities counted in every row of the band per round
+#define ENTITIES_PER_ROW 16
+
+typedef struct ContentionState_ {
+
+    int threads, rows, rounds;
+
+    pthread_barrier_t start;
+
+    //Packed layout
+    int *rowCounts;
+
+    Conflicts *conflicts;
+
+    PhaseCounter *phaseCounters;
+
+    //Padded layout
+    int **rowCountsPerThread;
+
+    WorkerBlock *workers;
+
+    int padded;
+
+} ContentionState;
+
+typedef struct ContentionThread_ {
+
+    ContentionState *state;
+
+    int thread;
+
+    double seconds;
+
+    //Rounds the neighbours were seen done with, so the polls are not optimized away
+    long polled;
+
+} ContentionThread;
+
+static double elapsedSeconds(struct timespec *start, struct timespec *end) {
+    return (double) (end->tv_sec - start->tv_sec) + (double) (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void *alignedLines(size_t size) {
+    size_t lines = (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE;
+
+    void *memory = aligned_alloc(CACHE_LINE_SIZE, lines * CACHE_LINE_SIZE);
+
+    if (memory == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate %zu bytes\n", size);
+        exit(EXIT_FAILURE);
+    }
+
+    return memory;
+}
+
+static void *runContentionThread(void *argument) {
+    ContentionThread *self = argument;
+    ContentionState *state = self->state;
+
+    int thread = self->thread;
+
+    //The same split as the bands of an even world
+    int startRow = thread * state->rows / state->threads, endRow = (thread + 1) * state->rows / state->threads - 1;
+
+    volatile int *rowCounts = state->padded ? state->rowCountsPerThread[thread] : state->rowCounts;
+
+    volatile int *conflictCounts = state->padded ? state->workers[thread].conflicts.count :
+                                   state->conflicts[thread].count;
+
+    int *ourPhase = state->padded ? &state->workers[thread].phaseCounter.phase : &state->phaseCounters[thread].phase;
+
+    int *abovePhase = NULL, *bellowPhase = NULL;
+
+    if (thread > 0) {
+        abovePhase = state->padded ? &state->workers[thread - 1].phaseCounter.phase :
+                     &state->phaseCounters[thread - 1].phase;
+    }
+
+    if (thread < state->threads - 1) {
+        bellowPhase = state->padded ? &state->workers[thread + 1].phaseCounter.phase :
+                      &state->phaseCounters[thread + 1].phase;
+    }
+
+    struct timespec start, end;
+
+    pthread_barrier_wait(&state->start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    long seen = 0;
+
+    for (int round = 0; round < state->rounds; round++) {
+        for (int row = startRow; row <= endRow; row++) {
+            rowCounts[row] = 0;
+
+            for (int entity = 0; entity < ENTITIES_PER_ROW; entity++) {
+                rowCounts[row]++;
+            }
+        }
+
+        conflictCounts[round % 4]++;
+
+        __atomic_store_n(ourPhase, round + 1, __ATOMIC_RELEASE);
+
+        //Only polled, the threads don't wait for each other so the time is the cost of the sharing alone
+        if (abovePhase != NULL) seen += __atomic_load_n(abovePhase, __ATOMIC_ACQUIRE) > round;
+        if (bellowPhase != NULL) seen += __atomic_load_n(bellowPhase, __ATOMIC_ACQUIRE) > round;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    self->seconds = elapsedSeconds(&start, &end);
+    self->polled = seen;
+
+    return NULL;
+}
+
+//Run the threads on one of the layouts, returns the time of the slowest thread and sets the entities counted
+static double runContention(ContentionState *state, int padded, long *entities) {
+    state->padded = padded;
+
+    for (int thread = 0; thread < state->threads; thread++) {
+        state->phaseCounters[thread].phase = 0;
+        state->workers[thread].phaseCounter.phase = 0;
+    }
+
+    pthread_t *threads = malloc(sizeof(pthread_t) * state->threads);
+    ContentionThread *arguments = malloc(sizeof(ContentionThread) * state->threads);
+
+    pthread_barrier_init(&state->start, NULL, state->threads);
+
+    for (int thread = 0; thread < state->threads; thread++) {
+        arguments[thread] = (ContentionThread) {.state = state, .thread = thread, .seconds = 0, .polled = 0};
+
+        pthread_create(&threads[thread], NULL, runContentionThread, &arguments[thread]);
+    }
+
+    double slowest = 0;
+
+    for (int thread = 0; thread < state->threads; thread++) {
+        pthread_join(threads[thread], NULL);
+
+        if (arguments[thread].seconds > slowest) slowest = arguments[thread].seconds;
+    }
+
+    pthread_barrier_destroy(&state->start);
+
+    *entities = 0;
+
+    for (int thread = 0; thread < state->threads; thread++) {
+        int startRow = thread * state->rows / state->threads, endRow = (thread + 1) * state->rows / state->threads - 1;
+
+        for (int row = startRow; row <= endRow; row++) {
+            *entities += padded ? state->rowCountsPerThread[thread][row] : state->rowCounts[row];
+        }
+    }
+
+    free(threads);
+    free(arguments);
+
+    return slowest;
+}
+
+int main(int argc, char **argv) {
+    int rows = argc > 1 ? atoi(argv[1]) : 100, rounds = argc > 2 ? atoi(argv[2]) : 200000,
+            maxThreads = argc > 3 ? atoi(argv[3]) : 32;
+
+    if (rows <= 0 || rounds <= 0 || maxThreads <= 0 || maxThreads > rows) {
+        fprintf(stderr, "Usage: %s [rows] [rounds] [max threads (up to rows)]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("Per thread state contention, %d rows, %d rounds, %d entities per row\n", rows, rounds, ENTITIES_PER_ROW);
+    printf("%8s %14s %14s %10s\n", "threads", "packed (s)", "padded (s)", "speedup");
+
+    for (int threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        ContentionState state = {.threads = threadCount, .rows = rows, .rounds = rounds};
+
+        state.rowCounts = calloc(rows, sizeof(int));
+        state.conflicts = calloc(threadCount, sizeof(Conflicts));
+        state.phaseCounters = calloc(threadCount, sizeof(PhaseCounter));
+        state.rowCountsPerThread = malloc(sizeof(int *) * threadCount);
+        state.workers = alignedLines(sizeof(WorkerBlock) * threadCount);
+
+        for (int thread = 0; thread < threadCount; thread++) {
+            state.rowCountsPerThread[thread] = alignedLines(sizeof(int) * rows);
+            state.workers[thread].conflicts = (Conflicts) {0};
+        }
+
+        long packedEntities, paddedEntities;
+
+        double packedSeconds = runContention(&state, 0, &packedEntities),
+                paddedSeconds = runContention(&state, 1, &paddedEntities);
+
+        printf("%8d %14.3f %14.3f %9.2fx\n", threadCount, packedSeconds, paddedSeconds, packedSeconds / paddedSeconds);
+
+        if (packedEntities != paddedEntities || packedEntities != (long) rows * ENTITIES_PER_ROW) {
+            fprintf(stderr, "ERROR: The layouts counted different entities (%ld and %ld)\n", packedEntities,
+                    paddedEntities);
+            exit(EXIT_FAILURE);
+        }
+
+        for (int thread = 0; thread < threadCount; thread++) {
+            free(state.rowCountsPerThread[thread]);
+        }
+
+        free(state.rowCounts);
+        free(state.conflicts);
+        free(state.phaseCounters);
+        free(state.rowCountsPerThread);
+        free(state.workers);
+    }
+
+    return 0;
+}
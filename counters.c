@@ -0,0 +1,201 @@
+#include "counters.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#define HAVE_PERF_EVENTS 1
+#else
+#define HAVE_PERF_EVENTS 0
+#endif
+
+static const char *const EVENT_NAMES[COUNTED_EVENTS] = {
+        [EVENT_CYCLES] = "cycles",
+        [EVENT_INSTRUCTIONS] = "instructions",
+        [EVENT_LLC_MISSES] = "llc_misses",
+        [EVENT_CONTEXT_SWITCHES] = "context_switches"
+};
+
+PhaseCounters *createPhaseCounters(int threadCount, int phaseCount) {
+    PhaseCounters *counters = malloc(sizeof(PhaseCounters));
+
+    counters->threadCount = threadCount;
+    counters->phaseCount = phaseCount;
+    counters->threads = malloc(sizeof(ThreadCounters *) * threadCount);
+
+    for (int thread = 0; thread < threadCount; thread++) {
+        ThreadCounters *threadCounters = malloc(sizeof(ThreadCounters));
+
+        threadCounters->opened = 0;
+        threadCounters->groupFd = -1;
+        threadCounters->eventCount = 0;
+        threadCounters->totals = calloc((size_t) phaseCount * COUNTED_EVENTS, sizeof(uint64_t));
+
+        for (int event = 0; event < COUNTED_EVENTS; event++) {
+            threadCounters->fds[ event ] = -1;
+            threadCounters->openErrors[ event ] = 0;
+            threadCounters->last[ event ] = 0;
+        }
+
+        counters->threads[ thread ] = threadCounters;
+    }
+
+    return counters;
+}
+
+const char *countedEventName(CountedEvent event) {
+    return EVENT_NAMES[ event ];
+}
+
+#if HAVE_PERF_EVENTS
+
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} EVENT_CONFIGS[COUNTED_EVENTS] = {
+        [EVENT_CYCLES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        [EVENT_INSTRUCTIONS] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        [EVENT_LLC_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        [EVENT_CONTEXT_SWITCHES] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES }
+};
+
+//Open an event of the calling thread, in the group of groupFd (-1 to lead a new one)
+static int openThreadEvent(CountedEvent event, int groupFd) {
+    struct perf_event_attr attributes;
+
+    memset(&attributes, 0, sizeof(attributes));
+
+    attributes.size = sizeof(attributes);
+    attributes.type = EVENT_CONFIGS[ event ].type;
+    attributes.config = EVENT_CONFIGS[ event ].config;
+    attributes.read_format = PERF_FORMAT_GROUP;
+    attributes.exclude_hv = 1;
+
+    int fd = (int) syscall(SYS_perf_event_open, &attributes, 0, -1, groupFd, 0);
+
+    if (fd < 0 && (errno == EACCES || errno == EPERM)) {
+        //perf_event_paranoid may only let us count in user space, the context switches are then never counted
+        attributes.exclude_kernel = 1;
+
+        fd = (int) syscall(SYS_perf_event_open, &attributes, 0, -1, groupFd, 0);
+    }
+
+    return fd;
+}
+
+static void openThreadCounters(ThreadCounters *threadCounters) {
+    threadCounters->opened = 1;
+
+    for (int event = 0; event < COUNTED_EVENTS; event++) {
+        int fd = openThreadEvent(event, threadCounters->groupFd);
+
+        if (fd < 0) {
+            threadCounters->openErrors[ event ] = errno;
+            continue;
+        }
+
+        if (threadCounters->groupFd < 0) {
+            threadCounters->groupFd = fd;
+        }
+
+        threadCounters->fds[ event ] = fd;
+        threadCounters->eventCount++;
+    }
+}
+
+//Read the current value of the events of the thread, 0 for the ones not counted. 0 when the group can't be read
+static int readThreadCounters(ThreadCounters *threadCounters, uint64_t values[COUNTED_EVENTS]) {
+    //The number of events and then their values
+    uint64_t group[ COUNTED_EVENTS + 1 ];
+
+    memset(values, 0, sizeof(uint64_t) * COUNTED_EVENTS);
+
+    if (threadCounters->groupFd < 0) {
+        return 0;
+    }
+
+    ssize_t size = read(threadCounters->groupFd, group, sizeof(uint64_t) * (threadCounters->eventCount + 1));
+
+    if (size < (ssize_t) sizeof(uint64_t) * (threadCounters->eventCount + 1)) {
+        return 0;
+    }
+
+    //The group is read in the order the events joined it
+    int position = 1;
+
+    for (int event = 0; event < COUNTED_EVENTS; event++) {
+        if (threadCounters->fds[ event ] >= 0) {
+            values[ event ] = group[ position++ ];
+        }
+    }
+
+    return 1;
+}
+
+#else
+
+static void openThreadCounters(ThreadCounters *threadCounters) {
+    threadCounters->opened = 1;
+
+    for (int event = 0; event < COUNTED_EVENTS; event++) {
+        threadCounters->openErrors[ event ] = ENOSYS;
+    }
+}
+
+static int readThreadCounters(ThreadCounters *threadCounters, uint64_t values[COUNTED_EVENTS]) {
+    memset(values, 0, sizeof(uint64_t) * COUNTED_EVENTS);
+
+    return 0;
+}
+
+#endif
+
+void restartPhaseCounters(PhaseCounters *counters, int thread) {
+    ThreadCounters *threadCounters = counters->threads[ thread ];
+
+    if (!threadCounters->opened) {
+        openThreadCounters(threadCounters);
+    }
+
+    uint64_t now[ COUNTED_EVENTS ];
+
+    if (readThreadCounters(threadCounters, now)) {
+        memcpy(threadCounters->last, now, sizeof(now));
+    }
+}
+
+void countPhaseEvents(PhaseCounters *counters, int thread, int phase) {
+    ThreadCounters *threadCounters = counters->threads[ thread ];
+
+    uint64_t now[ COUNTED_EVENTS ];
+
+    if (!readThreadCounters(threadCounters, now)) {
+        return;
+    }
+
+    for (int event = 0; event < COUNTED_EVENTS; event++) {
+        threadCounters->totals[ phase * COUNTED_EVENTS + event ] += now[ event ] - threadCounters->last[ event ];
+        threadCounters->last[ event ] = now[ event ];
+    }
+}
+
+void destroyPhaseCounters(PhaseCounters *counters) {
+    for (int thread = 0; thread < counters->threadCount; thread++) {
+        ThreadCounters *threadCounters = counters->threads[ thread ];
+
+        for (int event = 0; event < COUNTED_EVENTS; event++) {
+            if (threadCounters->fds[ event ] >= 0) {
+                close(threadCounters->fds[ event ]);
+            }
+        }
+
+        free(threadCounters->totals);
+        free(threadCounters);
+    }
+
+    free(counters->threads);
+    free(counters);
+}
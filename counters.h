@@ -0,0 +1,90 @@
+#ifndef TRABALHO_2_COUNTERS_H
+#define TRABALHO_2_COUNTERS_H
+
+#include <stdint.h>
+
+/*
+ * Per phase hardware counters of a simulation, for the benchmark mode (--benchmark-counters, see benchmark.h).
+ *
+ * Every thread opens its own perf_event_open group the first time it reads its counters, counting only itself, and
+ * adds what the events counted during every phase to its totals, next to the phase timers (see timers.h). Events the
+ * kernel or the machine don't give us (no PMU in a virtual machine, perf_event_paranoid, a build without
+ * linux/perf_event.h) are left out of the group, and when none can be opened the thread only has its timers.
+ */
+
+typedef enum CountedEvent_ {
+
+    EVENT_CYCLES,
+
+    EVENT_INSTRUCTIONS,
+
+    //Misses of the last level cache
+    EVENT_LLC_MISSES,
+
+    EVENT_CONTEXT_SWITCHES,
+
+    COUNTED_EVENTS
+
+} CountedEvent;
+
+typedef struct ThreadCounters_ {
+
+    //Set once the thread tried to open its group
+    int opened;
+
+    //The group leader, -1 when no event could be opened
+    int groupFd;
+
+    //Descriptor of every event, -1 when it could not be opened. A read of the group has the events that were opened,
+    //in this order
+    int fds[ COUNTED_EVENTS ];
+
+    int eventCount;
+
+    //errno of the failed open of every event, 0 for the ones that were opened
+    int openErrors[ COUNTED_EVENTS ];
+
+    //The events at the last reading, to count the next phase from
+    uint64_t last[ COUNTED_EVENTS ];
+
+    //[phase * COUNTED_EVENTS + event]
+    uint64_t *totals;
+
+} ThreadCounters;
+
+typedef struct PhaseCounters_ {
+
+    int threadCount, phaseCount;
+
+    //Allocated apart, every thread only writes to its own
+    ThreadCounters **threads;
+
+} PhaseCounters;
+
+PhaseCounters *createPhaseCounters(int threadCount, int phaseCount);
+
+//Name of an event in the benchmark results
+const char *countedEventName(CountedEvent event);
+
+/**
+ * Start counting the next phase of a thread from now. Must be called by the thread itself, the first call opens its
+ * events
+ */
+void restartPhaseCounters(PhaseCounters *counters, int thread);
+
+//Add what the events of the calling thread counted since the last reading to a phase
+void countPhaseEvents(PhaseCounters *counters, int thread, int phase);
+
+//1 when the thread opened its events and this one is among them
+static inline int isEventCounted(PhaseCounters *counters, int thread, CountedEvent event) {
+    return counters->threads[ thread ]->fds[ event ] >= 0;
+}
+
+static inline uint64_t phaseEventTotal(PhaseCounters *counters, int thread, int phase, CountedEvent event) {
+    return counters->threads[ thread ]->totals[ phase * COUNTED_EVENTS + event ];
+}
+
+//Closes the events of every thread, from any thread
+void destroyPhaseCounters(PhaseCounters *counters);
+
+#endif //TRABALHO_2_COUNTERS_H
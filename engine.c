@@ -0,0 +1,904 @@
+#include "engine.h"
+#include "output.h"
+#include "matrix_utils.h"
+#include "threads.h"
+#include "scheduler.h"
+#include "loader.h"
+#include "writer.h"
+#include "snapshot.h"
+#include "checkpoint.h"
+#include "placement.h"
+#include "autotune.h"
+#include <stdlib.h>
+#include <sys/time.h>
+
+struct EngineWorker {
+
+    int threadNumber;
+
+    SimulationEngine *engine;
+
+    //Threading system for a single thread, used to simulate whole worlds in batch mode. Created on the first batch
+    struct ThreadedData *sequentialData;
+
+};
+
+struct SimulationEngine_ {
+
+    int threadCount;
+
+    struct ThreadedData *threadedData;
+
+    struct EngineWorker *workers;
+
+    pthread_mutex_t lock;
+
+    //Workers wait on jobPosted for a new job (or the shutdown), the submitter waits on jobDone
+    pthread_cond_t jobPosted, jobDone;
+
+    //Incremented every time a job is posted, so workers can tell a new job from a spurious wake up
+    unsigned long jobSequence;
+
+    SimulationJob *currentJob;
+
+    //The generations the current job is simulated from and up to (not included)
+    int firstGeneration, endGeneration;
+
+    //When not NULL the posted work is a batch of independent jobs, handed out to the workers in order
+    SimulationJob **batchJobs;
+
+    //When not NULL the posted work is loading a world (see loader.h)
+    WorldLoad *currentLoad;
+
+    //When not NULL the posted work is formatting the results of a world (see writer.h)
+    ResultWrite *currentWrite;
+
+    //When not NULL the posted work is copying a loaded world into placedWorld and placedBackWorld, every worker
+    //touching its band first (see placeJobOnEngine)
+    SimulationJob *currentPlacement;
+
+    WorldSlot *placedWorld, *placedBackWorld;
+
+    int placementThreads;
+
+    //Where the workers run and the worlds are placed, NULL when the workers are not pinned (see placement.h)
+    ThreadPlacement *placement;
+
+    //Threading system for the calling thread, when runSimulationJobGenerations simulates a job without the workers
+    struct ThreadedData *sequentialData;
+
+    //runEngineSimulation picks the number of workers it simulates the world with (see autotune.h)
+    int autoThreads;
+
+    //What runEngineSimulation reads and writes as snapshots
+    SnapshotOptions snapshots;
+
+    int batchJobCount, nextBatchJob;
+
+    ThreadRowData *threadRowData;
+
+    int workersDone;
+
+    int shutdown;
+};
+
+static void runJobOnWorker(int threadNumber, SimulationJob *job, int firstGeneration, int endGeneration,
+                           struct ThreadedData *threadedData, ThreadRowData *threadRowData) {
+
+    FILE *outputFile;
+
+    int printOutput = PRINT_ALL_GEN;
+
+    if (threadNumber == 0 && printOutput) {
+        outputFile = fopen("allgen.txt", "w");
+    }
+
+    for (int gen = firstGeneration; gen < endGeneration; gen++) {
+
+        if (printOutput) {
+            pthread_barrier_wait(&threadedData->barrier);
+
+            if (threadNumber == 0) {
+                fprintf(outputFile, "Generation %d\n", gen);
+                printf("Generation %d\n", gen);
+                displayGenerationState(outputFile, job->simulationData, job->world);
+                fprintf(outputFile, "\n");
+            }
+
+            pthread_barrier_wait(&threadedData->barrier);
+        }
+
+        if (threadedData->partitionMode == PARTITION_STEALING) {
+            executeScheduledGeneration(threadNumber, gen, job->simulationData,
+                                       threadedData, job->world, job->backWorld);
+        } else {
+            executeParallelGeneration(threadNumber, gen, job->simulationData,
+                                      threadedData, job->world, job->backWorld, threadRowData);
+        }
+
+        if (job->checkpoints != NULL && isCheckpointDue(job->checkpoints, gen + 1)) {
+            if (threadNumber == 0) {
+                waitForCheckpointWriter(job->checkpoints);
+            }
+
+            //Every thread is done with the generation (the threads next to each other can be a generation apart
+            //with SYNC_NEIGHBOURS) and the buffer of the writer is free
+            pthread_barrier_wait(&threadedData->barrier);
+
+            copyCheckpointPart(job->checkpoints, job->world, threadNumber, job->simulationData->threads);
+
+            pthread_barrier_wait(&threadedData->barrier);
+
+            if (threadNumber == 0) {
+                postCheckpoint(job->checkpoints, gen + 1);
+            }
+        }
+    }
+
+    if (printOutput && threadNumber == 0) {
+        fclose(outputFile);
+    }
+}
+
+static long elapsedMicros(struct timeval *start, struct timeval *end) {
+    long seconds = (end->tv_sec - start->tv_sec);
+
+    return ((seconds * 1000000) + end->tv_usec) - (start->tv_usec);
+}
+
+static void runBatchOnWorker(struct EngineWorker *worker) {
+
+    SimulationEngine *engine = worker->engine;
+
+    if (worker->sequentialData == NULL) {
+        worker->sequentialData = malloc(sizeof(struct ThreadedData));
+
+        initializeThreadingSystem(1, NULL, worker->sequentialData);
+    }
+
+    //The worlds of the batch are simulated the way the engine was told to
+    setThreadAnalysis(engine->threadedData->analysisMode, engine->threadedData->bitboardKernel, worker->sequentialData);
+
+    while (1) {
+        pthread_mutex_lock(&engine->lock);
+
+        if (engine->nextBatchJob >= engine->batchJobCount) {
+            pthread_mutex_unlock(&engine->lock);
+            break;
+        }
+
+        SimulationJob *job = engine->batchJobs[ engine->nextBatchJob++ ];
+
+        pthread_mutex_unlock(&engine->lock);
+
+        job->simulationData->threads = 1;
+
+        prepareThreadingSystem(1, job->simulationData, worker->sequentialData);
+
+        struct timeval start, end;
+
+        gettimeofday(&start, NULL);
+
+        for (int gen = job->simulationData->firstGeneration; gen < job->simulationData->n_gen; gen++) {
+            executeSequentialGeneration(gen, job->simulationData, worker->sequentialData, job->world, job->backWorld);
+        }
+
+        gettimeofday(&end, NULL);
+
+        job->micros = elapsedMicros(&start, &end);
+
+        pthread_mutex_lock(&engine->lock);
+
+        job->finished = 1;
+
+        //The submitter waits for the jobs in order, wake it up so it can check if this was the one
+        pthread_cond_broadcast(&engine->jobDone);
+
+        pthread_mutex_unlock(&engine->lock);
+    }
+}
+
+//Copy the band of rows of a worker into the new buffers of the world, so its pages end up on the node of the worker
+static void placeWorldBand(int threadNumber, SimulationEngine *engine) {
+    InputData *simulationData = engine->currentPlacement->simulationData;
+
+    //The even split the bands of the world are rebalanced from (see setThreadRowGroups)
+    int startRow = (int) ((long) threadNumber * simulationData->rows / engine->placementThreads),
+        endRow = (int) ((long) (threadNumber + 1) * simulationData->rows / engine->placementThreads) - 1;
+
+    copyWorldRows(simulationData, engine->currentPlacement->world, engine->placedWorld, startRow, endRow);
+    copyWorldRows(simulationData, engine->currentPlacement->backWorld, engine->placedBackWorld, startRow, endRow);
+}
+
+static void *executeEngineWorker(void *args) {
+
+    struct EngineWorker *worker = args;
+    SimulationEngine *engine = worker->engine;
+
+    unsigned long lastJob = 0;
+
+    while (1) {
+        pthread_mutex_lock(&engine->lock);
+
+        while (!engine->shutdown && engine->jobSequence == lastJob) {
+            pthread_cond_wait(&engine->jobPosted, &engine->lock);
+        }
+
+        if (engine->shutdown) {
+            pthread_mutex_unlock(&engine->lock);
+            break;
+        }
+
+        lastJob = engine->jobSequence;
+
+        SimulationJob *job = engine->currentJob;
+
+        pthread_mutex_unlock(&engine->lock);
+
+        if (engine->batchJobs != NULL) {
+            runBatchOnWorker(worker);
+        }
+        else if (engine->currentLoad != NULL) {
+            if (worker->threadNumber < engine->currentLoad->threadCount) {
+                loadWorldPart(worker->threadNumber, engine->currentLoad);
+            }
+        }
+        else if (engine->currentWrite != NULL) {
+            if (worker->threadNumber < engine->currentWrite->threadCount) {
+                formatResultBand(worker->threadNumber, engine->currentWrite);
+            }
+        }
+        else if (engine->currentPlacement != NULL) {
+            if (worker->threadNumber < engine->placementThreads) {
+                placeWorldBand(worker->threadNumber, engine);
+            }
+        }
+        else if (worker->threadNumber < job->simulationData->threads) {
+            //Workers past the number of threads the job uses sit this one out
+            runJobOnWorker(worker->threadNumber, job, engine->firstGeneration, engine->endGeneration,
+                           engine->threadedData, engine->threadRowData);
+        }
+
+        pthread_mutex_lock(&engine->lock);
+
+        engine->workersDone++;
+
+        if (engine->workersDone == engine->threadCount) {
+            pthread_cond_broadcast(&engine->jobDone);
+        }
+
+        pthread_mutex_unlock(&engine->lock);
+    }
+
+    return NULL;
+}
+
+SimulationEngine *createSimulationEngine(int threadCount) {
+
+    SimulationEngine *engine = malloc(sizeof(SimulationEngine));
+
+    engine->threadCount = threadCount;
+    engine->jobSequence = 0;
+    engine->currentJob = NULL;
+    engine->firstGeneration = 0;
+    engine->endGeneration = 0;
+    engine->batchJobs = NULL;
+    engine->currentLoad = NULL;
+    engine->currentWrite = NULL;
+    engine->currentPlacement = NULL;
+    engine->placement = NULL;
+    engine->sequentialData = NULL;
+    engine->autoThreads = 0;
+    engine->snapshots.binaryInput = 0;
+    engine->snapshots.outputPath = NULL;
+    engine->snapshots.checkpointPath = NULL;
+    engine->snapshots.checkpointInterval = 0;
+    engine->batchJobCount = 0;
+    engine->nextBatchJob = 0;
+    engine->workersDone = 0;
+    engine->shutdown = 0;
+
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->jobPosted, NULL);
+    pthread_cond_init(&engine->jobDone, NULL);
+
+    engine->threadedData = malloc(sizeof(struct ThreadedData));
+
+    //The conflict arrays get their size when the first world is submitted
+    initializeThreadingSystem(threadCount, NULL, engine->threadedData);
+
+    engine->threadRowData = malloc(sizeof(ThreadRowData) * threadCount);
+
+    engine->workers = malloc(sizeof(struct EngineWorker) * threadCount);
+
+    for (int thread = 0; thread < threadCount; thread++) {
+
+        engine->workers[ thread ].threadNumber = thread;
+        engine->workers[ thread ].engine = engine;
+        engine->workers[ thread ].sequentialData = NULL;
+
+        printf("Initializing thread %d \n", thread);
+
+        pthread_create(&engine->threadedData->threads[ thread ], NULL, executeEngineWorker, &engine->workers[ thread ]);
+    }
+
+    return engine;
+}
+
+void setEngineSynchronization(SimulationEngine *engine, SyncMode syncMode, int rebalanceInterval) {
+    setThreadSynchronization(syncMode, rebalanceInterval, engine->threadedData);
+}
+
+void setEnginePartitioning(SimulationEngine *engine, PartitionMode partitionMode) {
+    setThreadPartitioning(partitionMode, engine->threadedData);
+}
+
+void setEngineAnalysis(SimulationEngine *engine, AnalysisMode analysisMode, BitboardKernel bitboardKernel) {
+    setThreadAnalysis(analysisMode, bitboardKernel, engine->threadedData);
+}
+
+void setEngineTaskTileSize(SimulationEngine *engine, int tileSize) {
+    setThreadTaskTileSize(tileSize, engine->threadedData);
+}
+
+void setEngineTimers(SimulationEngine *engine, struct PhaseTimers_ *timers) {
+    setThreadTimers(timers, engine->threadedData);
+}
+
+void setEnginePlacement(SimulationEngine *engine, PinMode pinMode) {
+    if (engine->placement != NULL) {
+        destroyThreadPlacement(engine->placement);
+        engine->placement = NULL;
+    }
+
+    if (pinMode == PIN_NONE) {
+        int allThreads[] = {0, engine->threadCount};
+
+        setThreadRowGroups(1, allThreads, engine->threadedData);
+        return;
+    }
+
+    engine->placement = createThreadPlacement(pinMode, engine->threadCount);
+
+    for (int thread = 0; thread < engine->threadCount; thread++) {
+        pinPlacedThread(engine->placement, thread, engine->threadedData->threads[ thread ]);
+    }
+
+    //The bands of a node are only rebalanced between its threads, so its rows stay on its memory
+    setThreadRowGroups(getPlacementNodeCount(engine->placement), getPlacementNodeThreads(engine->placement),
+                       engine->threadedData);
+}
+
+void setEngineAutoThreads(SimulationEngine *engine, int autoThreads) {
+    engine->autoThreads = autoThreads;
+}
+
+int getEngineThreadCount(SimulationEngine *engine) {
+    return engine->threadCount;
+}
+
+void setEngineSnapshots(SimulationEngine *engine, const SnapshotOptions *snapshots) {
+    engine->snapshots = *snapshots;
+}
+
+//Load the next world of the reader
+static SimulationJob *readSimulationJob(InputReader *reader) {
+
+    SimulationJob *job = malloc(sizeof(SimulationJob));
+
+    long parsedBefore = reader->parseNanos;
+
+    job->simulationData = parseSimulationParameters(reader);
+
+    job->world = initializeWorldMatrix(job->simulationData);
+
+    job->backWorld = initializeWorldMatrix(job->simulationData);
+
+    loadWorldEntities(reader, job->simulationData, job->world);
+
+    job->parseNanos = reader->parseNanos - parsedBefore;
+
+    //Rocks are never written again, so the back buffer has to start with them
+    copyWorldMatrix(job->simulationData, job->world, job->backWorld);
+
+    job->micros = 0;
+    job->finished = 0;
+    job->checkpoints = NULL;
+
+    return job;
+}
+
+SimulationJob *loadSimulationJob(FILE *inputFile) {
+
+    InputReader *reader = openInputReader(inputFile);
+
+    SimulationJob *job = readSimulationJob(reader);
+
+    if (PRINT_PARSE_THROUGHPUT) {
+        reportParseThroughput(stderr, reader);
+    }
+
+    closeInputReader(reader);
+
+    return job;
+}
+
+SimulationJob *loadSnapshotJob(FILE *inputFile) {
+
+    SimulationJob *job = malloc(sizeof(SimulationJob));
+
+    job->simulationData = readWorldSnapshot(inputFile, &job->world);
+
+    job->parseNanos = 0;
+
+    job->backWorld = initializeWorldMatrix(job->simulationData);
+
+    printf("Initial population: %d\n", job->simulationData->initialPopulation);
+
+    copyWorldMatrix(job->simulationData, job->world, job->backWorld);
+
+    job->micros = 0;
+    job->finished = 0;
+    job->checkpoints = NULL;
+
+    return job;
+}
+
+//Wake the workers up for the work that was just posted and wait for all of them to be done. Needs the lock
+static void runPostedWork(SimulationEngine *engine) {
+
+    engine->workersDone = 0;
+    engine->jobSequence++;
+
+    pthread_cond_broadcast(&engine->jobPosted);
+
+    while (engine->workersDone < engine->threadCount) {
+        pthread_cond_wait(&engine->jobDone, &engine->lock);
+    }
+}
+
+//The number of threads the bands of a world are placed for, the same runSimulationJob gives it
+static int placementThreadCount(SimulationEngine *engine, SimulationJob *job) {
+    return engine->threadCount < job->simulationData->rows ? engine->threadCount : job->simulationData->rows;
+}
+
+static void reportJobPlacement(SimulationEngine *engine, SimulationJob *job) {
+    reportWorldPlacement(stderr, engine->placement, job->simulationData, placementThreadCount(engine, job), job->world,
+                         job->backWorld);
+}
+
+/*
+ * Move a world the calling thread loaded into new buffers, copied by the workers: the pages of the new buffers are
+ * placed on the node of the worker that touches them first, so every band ends up on the node of its thread
+ */
+static void placeJobOnEngine(SimulationEngine *engine, SimulationJob *job) {
+    if (engine->placement == NULL) {
+        return;
+    }
+
+    //Never touched before, calloc maps them fresh
+    WorldSlot *placedWorld = initializeWorldMatrix(job->simulationData),
+            *placedBackWorld = initializeWorldMatrix(job->simulationData);
+
+    pthread_mutex_lock(&engine->lock);
+
+    engine->currentPlacement = job;
+    engine->placedWorld = placedWorld;
+    engine->placedBackWorld = placedBackWorld;
+    engine->placementThreads = placementThreadCount(engine, job);
+
+    runPostedWork(engine);
+
+    engine->currentPlacement = NULL;
+
+    pthread_mutex_unlock(&engine->lock);
+
+    freeMatrix((void **) &job->world);
+    freeMatrix((void **) &job->backWorld);
+
+    job->world = placedWorld;
+    job->backWorld = placedBackWorld;
+
+    reportJobPlacement(engine, job);
+}
+
+SimulationJob *loadSnapshotJobOnEngine(SimulationEngine *engine, FILE *inputFile) {
+
+    SimulationJob *job = loadSnapshotJob(inputFile);
+
+    placeJobOnEngine(engine, job);
+
+    return job;
+}
+
+SimulationJob *loadSimulationJobOnEngine(SimulationEngine *engine, FILE *inputFile) {
+
+    InputReader *reader = openInputReader(inputFile);
+
+    //Pipes can't be split in chunks, they are read by a single thread, and so are the inputs too small to gain from
+    //splitting them
+    if (!isInputMapped(reader) || engine->threadCount == 1 || mappedBytesLeft(reader) < PARALLEL_LOAD_MIN_BYTES) {
+        SimulationJob *job = readSimulationJob(reader);
+
+        if (PRINT_PARSE_THROUGHPUT) {
+            reportParseThroughput(stderr, reader);
+        }
+
+        closeInputReader(reader);
+
+        placeJobOnEngine(engine, job);
+
+        return job;
+    }
+
+    SimulationJob *job = malloc(sizeof(SimulationJob));
+
+    job->simulationData = parseSimulationParameters(reader);
+
+    job->world = initializeWorldMatrix(job->simulationData);
+
+    job->backWorld = initializeWorldMatrix(job->simulationData);
+
+    job->micros = 0;
+    job->finished = 0;
+    job->checkpoints = NULL;
+
+    printf("Initial population: %d\n", job->simulationData->initialPopulation);
+
+    //Every thread of the load needs at least one row
+    int loadThreads = engine->threadCount < job->simulationData->rows ? engine->threadCount : job->simulationData->rows;
+
+    startParsing(reader);
+
+    WorldLoad *load = createWorldLoad(reader, job->simulationData, job->world, job->backWorld, loadThreads);
+
+    pthread_mutex_lock(&engine->lock);
+
+    engine->currentLoad = load;
+
+    runPostedWork(engine);
+
+    engine->currentLoad = NULL;
+
+    pthread_mutex_unlock(&engine->lock);
+
+    int loaded = finishWorldLoad(load);
+
+    if (!loaded) {
+        //The entities are not one per line, the chunks could not be read on their own
+        readWorldEntities(reader, job->simulationData, job->world);
+
+        copyWorldMatrix(job->simulationData, job->world, job->backWorld);
+    }
+
+    stopParsing(reader);
+
+    job->parseNanos = reader->parseNanos;
+
+    if (PRINT_PARSE_THROUGHPUT) {
+        reportParseThroughput(stderr, reader);
+    }
+
+    closeInputReader(reader);
+
+    //The workers already touched their bands first while placing the entities
+    if (!loaded) {
+        placeJobOnEngine(engine, job);
+    } else if (engine->placement != NULL) {
+        reportJobPlacement(engine, job);
+    }
+
+    return job;
+}
+
+SimulationJob **loadSimulationJobStream(FILE *inputFile, int *jobCount) {
+
+    int capacity = 16, count = 0;
+
+    SimulationJob **jobs = malloc(sizeof(SimulationJob *) * capacity);
+
+    //The worlds are read one after the other from the same reader, the stream can't be rewound when it is a pipe
+    InputReader *reader = openInputReader(inputFile);
+
+    //Skip the whitespace between worlds to find out if there is another one
+    while (!readerAtEnd(reader)) {
+
+        if (count == capacity) {
+            capacity *= 2;
+            jobs = realloc(jobs, sizeof(SimulationJob *) * capacity);
+        }
+
+        jobs[ count++ ] = readSimulationJob(reader);
+    }
+
+    if (PRINT_PARSE_THROUGHPUT) {
+        reportParseThroughput(stderr, reader);
+    }
+
+    closeInputReader(reader);
+
+    *jobCount = count;
+
+    return jobs;
+}
+
+//Simulate generations of a job on at most maxThreads workers. The times of the threads are only reported when report
+//is set, the generations of a job run in parts would report every part
+static void runJobOnWorkers(SimulationEngine *engine, SimulationJob *job, int maxThreads, int firstGeneration,
+                            int endGeneration, int report) {
+
+    InputData *simulationData = job->simulationData;
+
+    int tiles = engine->threadedData->partitionMode == PARTITION_TILES,
+        stealing = engine->threadedData->partitionMode == PARTITION_STEALING;
+
+    if (tiles) {
+        //Every thread needs at least one slot, tiles can use more threads than there are rows
+        simulationData->threads = chooseTileLayout(maxThreads, simulationData, engine->threadedData);
+    } else if (stealing) {
+        //The threads don't own any part of the world, every thread just takes tasks
+        simulationData->threads = maxThreads;
+    } else {
+        //Every thread needs at least one row
+        simulationData->threads = maxThreads < simulationData->rows ? maxThreads : simulationData->rows;
+
+        if (!validateThreadConfiguration(simulationData)) {
+            exit(1);
+        }
+    }
+
+    prepareThreadingSystem(simulationData->threads, simulationData, engine->threadedData);
+
+    struct timeval start, end;
+
+    gettimeofday(&start, NULL);
+
+    if (tiles) {
+        distributeTilesAcrossThreads(engine->threadRowData, simulationData, job->world, engine->threadedData);
+    } else if (!stealing) {
+        distributeWorkloadAcrossThreads(simulationData->threads, engine->threadRowData, simulationData,
+                                        engine->threadedData);
+    }
+
+    pthread_mutex_lock(&engine->lock);
+
+    engine->currentJob = job;
+    engine->firstGeneration = firstGeneration;
+    engine->endGeneration = endGeneration;
+    engine->workersDone = 0;
+    engine->jobSequence++;
+
+    pthread_cond_broadcast(&engine->jobPosted);
+
+    while (engine->workersDone < engine->threadCount) {
+        pthread_cond_wait(&engine->jobDone, &engine->lock);
+    }
+
+    engine->currentJob = NULL;
+
+    pthread_mutex_unlock(&engine->lock);
+
+    gettimeofday(&end, NULL);
+
+    job->micros = elapsedMicros(&start, &end);
+
+    if (report && PRINT_REBALANCE_TIME) {
+        long totalNanos = 0;
+
+        for (int thread = 0; thread < simulationData->threads; thread++) {
+            totalNanos += engine->threadedData->workers[ thread ].rebalanceNanos;
+        }
+
+        fprintf(stderr, "Rebalancing took %ld microseconds per thread\n",
+                totalNanos / simulationData->threads / 1000);
+    }
+
+    if (report && stealing) {
+        reportTileSchedulerTimes(stderr, simulationData->threads, engine->threadedData->scheduler);
+    }
+}
+
+void runSimulationJob(SimulationEngine *engine, SimulationJob *job) {
+    runJobOnWorkers(engine, job, engine->threadCount, job->simulationData->firstGeneration, job->simulationData->n_gen,
+                    1);
+}
+
+//Simulate the generations of a job on the calling thread, the way runSequentialSimulation does
+static void runJobOnCallingThread(SimulationEngine *engine, SimulationJob *job, int firstGeneration,
+                                  int endGeneration) {
+
+    InputData *simulationData = job->simulationData;
+
+    if (engine->sequentialData == NULL) {
+        engine->sequentialData = malloc(sizeof(struct ThreadedData));
+
+        initializeThreadingSystem(1, NULL, engine->sequentialData);
+    }
+
+    setThreadAnalysis(engine->threadedData->analysisMode, engine->threadedData->bitboardKernel, engine->sequentialData);
+    setThreadTimers(engine->threadedData->timers, engine->sequentialData);
+
+    simulationData->threads = 1;
+
+    prepareThreadingSystem(1, simulationData, engine->sequentialData);
+
+    struct timeval start, end;
+
+    gettimeofday(&start, NULL);
+
+    for (int gen = firstGeneration; gen < endGeneration; gen++) {
+        executeSequentialGeneration(gen, simulationData, engine->sequentialData, job->world, job->backWorld);
+
+        if (job->checkpoints != NULL && isCheckpointDue(job->checkpoints, gen + 1)) {
+            takeCheckpoint(job->checkpoints, job->world, gen + 1);
+        }
+    }
+
+    gettimeofday(&end, NULL);
+
+    job->micros = elapsedMicros(&start, &end);
+}
+
+void runSimulationJobGenerations(SimulationEngine *engine, SimulationJob *job, int threads, int firstGeneration,
+                                 int endGeneration) {
+    if (threads <= 1) {
+        runJobOnCallingThread(engine, job, firstGeneration, endGeneration);
+    } else {
+        runJobOnWorkers(engine, job, threads < engine->threadCount ? threads : engine->threadCount, firstGeneration,
+                        endGeneration, 0);
+    }
+}
+
+void runSimulationBatch(SimulationEngine *engine, SimulationJob **jobs, int jobCount, FILE *outputFile) {
+
+    struct timeval start, end;
+
+    gettimeofday(&start, NULL);
+
+    pthread_mutex_lock(&engine->lock);
+
+    for (int job = 0; job < jobCount; job++) {
+        jobs[ job ]->finished = 0;
+    }
+
+    engine->batchJobs = jobs;
+    engine->batchJobCount = jobCount;
+    engine->nextBatchJob = 0;
+    engine->workersDone = 0;
+    engine->jobSequence++;
+
+    pthread_cond_broadcast(&engine->jobPosted);
+
+    for (int job = 0; job < jobCount; job++) {
+
+        while (!jobs[ job ]->finished) {
+            pthread_cond_wait(&engine->jobDone, &engine->lock);
+        }
+
+        //Write the results without holding the lock, so the workers can keep taking jobs
+        pthread_mutex_unlock(&engine->lock);
+
+        printf("RESULTS:\n");
+
+        outputSimulationJob(outputFile, jobs[ job ]);
+
+        destroySimulationJob(jobs[ job ]);
+
+        pthread_mutex_lock(&engine->lock);
+    }
+
+    while (engine->workersDone < engine->threadCount) {
+        pthread_cond_wait(&engine->jobDone, &engine->lock);
+    }
+
+    engine->batchJobs = NULL;
+
+    pthread_mutex_unlock(&engine->lock);
+
+    gettimeofday(&end, NULL);
+
+    printf("Took %ld microseconds\n", elapsedMicros(&start, &end));
+}
+
+void outputSimulationJob(FILE *outputFile, SimulationJob *job) {
+    outputSimulationResults(outputFile, job->simulationData, job->world);
+    fflush(outputFile);
+}
+
+void outputSimulationJobOnEngine(SimulationEngine *engine, FILE *outputFile, SimulationJob *job) {
+
+    //Every band needs at least one row
+    int writeThreads = engine->threadCount < job->simulationData->rows ? engine->threadCount : job->simulationData->rows;
+
+    ResultWrite *write = createResultWrite(job->simulationData, job->world, writeThreads);
+
+    pthread_mutex_lock(&engine->lock);
+
+    engine->currentWrite = write;
+
+    runPostedWork(engine);
+
+    engine->currentWrite = NULL;
+
+    pthread_mutex_unlock(&engine->lock);
+
+    finishResultWrite(outputFile, write);
+    fflush(outputFile);
+}
+
+void destroySimulationJob(SimulationJob *job) {
+    freeMatrix((void **) &job->backWorld);
+    deallocateWorldMatrix(job->simulationData, job->world);
+    free(job);
+}
+
+void runEngineSimulation(SimulationEngine *engine, FILE *inputFile, FILE *outputFile) {
+
+    SimulationJob *job = engine->snapshots.binaryInput ? loadSnapshotJobOnEngine(engine, inputFile) :
+                         loadSimulationJobOnEngine(engine, inputFile);
+
+    if (engine->snapshots.checkpointInterval > 0) {
+        job->checkpoints = createCheckpointWriter(engine->snapshots.checkpointPath,
+                                                  engine->snapshots.checkpointInterval, job->simulationData);
+    }
+
+    if (engine->autoThreads) {
+        runTunedSimulationJob(engine, job);
+    } else {
+        runSimulationJob(engine, job);
+    }
+
+    if (job->checkpoints != NULL) {
+        destroyCheckpointWriter(job->checkpoints);
+    }
+
+    printf("RESULTS:\n");
+
+    outputSimulationJobOnEngine(engine, outputFile, job);
+    printf("Took %ld microseconds\n", job->micros);
+
+    if (engine->snapshots.outputPath != NULL) {
+        saveWorldSnapshot(engine->snapshots.outputPath, job->simulationData, job->world, job->simulationData->n_gen);
+    }
+
+    destroySimulationJob(job);
+}
+
+void destroySimulationEngine(SimulationEngine *engine) {
+
+    pthread_mutex_lock(&engine->lock);
+
+    engine->shutdown = 1;
+
+    pthread_cond_broadcast(&engine->jobPosted);
+
+    pthread_mutex_unlock(&engine->lock);
+
+    for (int thread = 0; thread < engine->threadCount; thread++) {
+        pthread_join(engine->threadedData->threads[ thread ], NULL);
+    }
+
+    destroyThreadingSystem(engine->threadCount, engine->threadedData);
+
+    if (engine->placement != NULL) {
+        destroyThreadPlacement(engine->placement);
+    }
+
+    if (engine->sequentialData != NULL) {
+        destroyThreadingSystem(1, engine->sequentialData);
+    }
+
+    for (int thread = 0; thread < engine->threadCount; thread++) {
+        if (engine->workers[ thread ].sequentialData != NULL) {
+            destroyThreadingSystem(1, engine->workers[ thread ].sequentialData);
+        }
+    }
+
+    pthread_mutex_destroy(&engine->lock);
+    pthread_cond_destroy(&engine->jobPosted);
+    pthread_cond_destroy(&engine->jobDone);
+
+    free(engine->threadRowData);
+    free(engine->workers);
+    free(engine);
+}
@@ -0,0 +1,169 @@
+#ifndef TRABALHO_2_ENGINE_H
+#define TRABALHO_2_ENGINE_H
+
+#include <stdio.h>
+#include "rabbitsandfoxes.h"
+#include "threads.h"
+#include "snapshot.h"
+#include "placement.h"
+
+/**
+ * A pool of worker threads that is started once and reused by every simulation submitted to it.
+ * Between simulations the workers are parked on a condition variable, so running many small worlds
+ * does not pay for creating threads and setting up their synchronization every time.
+ */
+typedef struct SimulationEngine_ SimulationEngine;
+
+/**
+ * A loaded world, ready to be simulated
+ */
+typedef struct SimulationJob_ {
+
+    InputData *simulationData;
+
+    WorldSlot *world, *backWorld;
+
+    //Time the last run of this job took, in microseconds
+    long micros;
+
+    //Time spent parsing the world when it was loaded, 0 for snapshots
+    long parseNanos;
+
+    //Set once a batch worker is done simulating this job
+    int finished;
+
+    //When not NULL the world is checkpointed while it is simulated (see checkpoint.h). Not used in batch mode
+    struct CheckpointWriter_ *checkpoints;
+
+} SimulationJob;
+
+/**
+ * Start an engine with threadCount parked workers
+ * @param threadCount
+ * @return
+ */
+SimulationEngine *createSimulationEngine(int threadCount);
+
+/**
+ * Choose how the workers of the engine synchronize with each other for the next jobs (see SyncMode)
+ * @param engine
+ * @param syncMode
+ * @param rebalanceInterval Generations between workload rebalances in SYNC_NEIGHBOURS mode
+ */
+void setEngineSynchronization(SimulationEngine *engine, SyncMode syncMode, int rebalanceInterval);
+
+/**
+ * Choose how the worlds of the next jobs are split between the workers of the engine (see PartitionMode)
+ */
+void setEnginePartitioning(SimulationEngine *engine, PartitionMode partitionMode);
+
+/**
+ * Choose how the workers of the engine find the moves of the animals (see AnalysisMode)
+ */
+void setEngineAnalysis(SimulationEngine *engine, AnalysisMode analysisMode, BitboardKernel bitboardKernel);
+
+/**
+ * Choose the size of the side of the tiles the worlds are cut in when the engine uses PARTITION_STEALING
+ */
+void setEngineTaskTileSize(SimulationEngine *engine, int tileSize);
+
+/**
+ * Choose what runEngineSimulation reads and writes as snapshots (see snapshot.h)
+ */
+void setEngineSnapshots(SimulationEngine *engine, const SnapshotOptions *snapshots);
+
+/**
+ * Pin the workers of the engine to the cores or the NUMA nodes of the machine, and place the worlds of the next jobs
+ * loaded on the engine so every band of rows is on the node of its thread (see placement.h). Where the pages of the
+ * worlds ended up is written to stderr when they are loaded. With PIN_NONE the workers are left where they are
+ * pinned, the worlds are no longer placed
+ */
+void setEnginePlacement(SimulationEngine *engine, PinMode pinMode);
+
+/**
+ * Let runEngineSimulation pick how many of the workers of the engine simulate the world, and shrink them while it
+ * runs (see autotune.h), instead of always using every worker
+ */
+void setEngineAutoThreads(SimulationEngine *engine, int autoThreads);
+
+/**
+ * Time the phases of the next jobs with the given timers (see timers.h), or stop timing them with NULL
+ */
+void setEngineTimers(SimulationEngine *engine, struct PhaseTimers_ *timers);
+
+int getEngineThreadCount(SimulationEngine *engine);
+
+SimulationJob *loadSimulationJob(FILE *inputFile);
+
+/**
+ * Load a world from a snapshot, the simulation goes on from the generation the snapshot was taken at
+ */
+SimulationJob *loadSnapshotJob(FILE *inputFile);
+
+/**
+ * Load a world from a snapshot like loadSnapshotJob, placed for the workers of the engine (see setEnginePlacement)
+ */
+SimulationJob *loadSnapshotJobOnEngine(SimulationEngine *engine, FILE *inputFile);
+
+/**
+ * Load a world with the workers of the engine (see loader.h). The input must only hold this world, when it can't
+ * be mapped (a pipe) it is loaded by the calling thread like loadSimulationJob does
+ */
+SimulationJob *loadSimulationJobOnEngine(SimulationEngine *engine, FILE *inputFile);
+
+/**
+ * Simulate every generation of a job on the workers of the engine, returns when the simulation is done.
+ * Worlds with less rows than the engine has workers only use as many workers as they have rows, unless the
+ * engine splits them in tiles. With PARTITION_STEALING the time every worker was busy and idle is written to stderr
+ * @param engine
+ * @param job
+ */
+void runSimulationJob(SimulationEngine *engine, SimulationJob *job);
+
+/**
+ * Simulate the generations of a job from firstGeneration up to endGeneration (not included), with at most threads
+ * workers, so a job can be simulated in parts. With a single thread the generations are simulated by the calling
+ * thread, without waking the workers up. job->micros is set to the time the generations took, and nothing is reported
+ */
+void runSimulationJobGenerations(SimulationEngine *engine, SimulationJob *job, int threads, int firstGeneration,
+                                 int endGeneration);
+
+void outputSimulationJob(FILE *outputFile, SimulationJob *job);
+
+/**
+ * Write the results of a job like outputSimulationJob, with every worker of the engine formatting a band of rows
+ * (see writer.h). Must not be called while the engine is running a batch
+ */
+void outputSimulationJobOnEngine(SimulationEngine *engine, FILE *outputFile, SimulationJob *job);
+
+void destroySimulationJob(SimulationJob *job);
+
+/**
+ * Load every world of a stream of concatenated inputs
+ * @param inputFile
+ * @param jobCount Set to the number of worlds that were loaded
+ * @return
+ */
+SimulationJob **loadSimulationJobStream(FILE *inputFile, int *jobCount);
+
+/**
+ * Simulate many independent worlds at once. Instead of splitting a world across the workers, every worker takes
+ * whole worlds and simulates them sequentially, so small worlds scale with the number of worlds and the workers
+ * never have to synchronize with each other. The results are written to outputFile in the order of the jobs,
+ * as soon as each one (and every job before it) is done, and the jobs are destroyed after being written
+ * @param engine
+ * @param jobs
+ * @param jobCount
+ * @param outputFile
+ */
+void runSimulationBatch(SimulationEngine *engine, SimulationJob **jobs, int jobCount, FILE *outputFile);
+
+/**
+ * Load a world from inputFile, simulate it and write the results to outputFile. The world is read, written and
+ * checkpointed as snapshots as set with setEngineSnapshots
+ */
+void runEngineSimulation(SimulationEngine *engine, FILE *inputFile, FILE *outputFile);
+
+void destroySimulationEngine(SimulationEngine *engine);
+
+#endif //TRABALHO_2_ENGINE_H
@@ -2,47 +2,27 @@
 #include <stdlib.h>
 #include <stdio.h>
 
-FoxInfo* createFoxEntity(void) {
-    FoxInfo* newFox = malloc(sizeof(FoxInfo));
-    
-    if (newFox == NULL) {
-        return NULL;
-    }
-    
+void placeFoxEntity(WorldSlot* slot) {
+    FoxInfo* newFox = &slot->entityInfo.foxInfo;
+
+    slot->slotContent = FOX;
+
     // Initialize fox state - newborn fox
     newFox->currentGenFood = 0;     // Generations since last meal
     newFox->currentGenProc = 0;     // Generations since birth
     newFox->genUpdated = 0;         // Last generation updated
     newFox->prevGenProc = 0;        // Previous generation proc count
-    
-    return newFox;
 }
 
-RabbitInfo* createRabbitEntity(void) {
-    RabbitInfo* newRabbit = malloc(sizeof(RabbitInfo));
-    
-    if (newRabbit == NULL) {
-        return NULL;
-    }
-    
+void placeRabbitEntity(WorldSlot* slot) {
+    RabbitInfo* newRabbit = &slot->entityInfo.rabbitInfo;
+
+    slot->slotContent = RABBIT;
+
     // Initialize rabbit state - newborn rabbit
     newRabbit->currentGen = 0;      // Generations since birth
     newRabbit->genUpdated = 0;      // Last generation updated
     newRabbit->prevGen = 0;         // Previous generation count
-    
-    return newRabbit;
-}
-
-void destroyFoxEntity(FoxInfo* foxEntity) {
-    if (foxEntity != NULL) {
-        free(foxEntity);
-    }
-}
-
-void destroyRabbitEntity(RabbitInfo* rabbitEntity) {
-    if (rabbitEntity != NULL) {
-        free(rabbitEntity);
-    }
 }
 
 // Movement outcome constants
@@ -68,12 +48,12 @@ static int resolveFoxConflict(FoxInfo* movingFox, FoxInfo* occupyingFox) {
     int occupyingFoxAge = calculateFoxAge(occupyingFox, movingFox);
     
 #ifdef VERBOSE
-    printf("Fox conflict: moving fox %p vs occupying fox %p\n", movingFox, occupyingFox);
+    printf("Fox conflict: moving fox (age %d) vs occupying fox (age %d)\n", movingFoxAge, occupyingFoxAge);
 #endif
     
     if (movingFoxAge > occupyingFoxAge) {
 #ifdef VERBOSE
-        printf("Moving fox %p wins with age %d vs %d\n", movingFox, movingFoxAge, occupyingFoxAge);
+        printf("Moving fox wins with age %d vs %d\n", movingFoxAge, occupyingFoxAge);
 #endif
         return MOVEMENT_SUCCESS;
     }
@@ -81,14 +61,14 @@ static int resolveFoxConflict(FoxInfo* movingFox, FoxInfo* occupyingFox) {
         // Same age - resolve by food level (higher = less hungry = stronger)
         if (movingFox->currentGenFood < occupyingFox->currentGenFood) {
 #ifdef VERBOSE
-            printf("Moving fox %p wins with food level %d vs %d\n", movingFox, 
+            printf("Moving fox wins with food level %d vs %d\n",
                    movingFox->currentGenFood, occupyingFox->currentGenFood);
 #endif
             return MOVEMENT_SUCCESS;
         }
         else {
 #ifdef VERBOSE
-            printf("Occupying fox %p wins with food level %d vs %d\n", occupyingFox,
+            printf("Occupying fox wins with food level %d vs %d\n",
                    occupyingFox->currentGenFood, movingFox->currentGenFood);
 #endif
             return MOVEMENT_FAILED;
@@ -96,7 +76,7 @@ static int resolveFoxConflict(FoxInfo* movingFox, FoxInfo* occupyingFox) {
     }
     else {
 #ifdef VERBOSE
-        printf("Occupying fox %p wins with age %d vs %d\n", occupyingFox, occupyingFoxAge, movingFoxAge);
+        printf("Occupying fox wins with age %d vs %d\n", occupyingFoxAge, movingFoxAge);
 #endif
         return MOVEMENT_FAILED;
     }
@@ -107,12 +87,11 @@ int processFoxMovement(FoxInfo* foxEntity, WorldSlot* targetSlot) {
     
     switch (targetType) {
         case FOX: {
-            FoxInfo* occupyingFox = targetSlot->entityInfo.foxInfo;
+            FoxInfo* occupyingFox = &targetSlot->entityInfo.foxInfo;
             int conflictResult = resolveFoxConflict(foxEntity, occupyingFox);
             
             if (conflictResult == MOVEMENT_SUCCESS) {
-                destroyFoxEntity(occupyingFox);
-                targetSlot->entityInfo.foxInfo = foxEntity;
+                targetSlot->entityInfo.foxInfo = *foxEntity;
                 return MOVEMENT_SUCCESS;
             }
             return MOVEMENT_FAILED;
@@ -120,16 +99,15 @@ int processFoxMovement(FoxInfo* foxEntity, WorldSlot* targetSlot) {
         
         case RABBIT:
 #ifdef VERBOSE
-            printf("Fox %p killed rabbit %p\n", foxEntity, targetSlot->entityInfo.rabbitInfo);
+            printf("Fox killed rabbit (age %d)\n", targetSlot->entityInfo.rabbitInfo.currentGen);
 #endif
-            destroyRabbitEntity(targetSlot->entityInfo.rabbitInfo);
             targetSlot->slotContent = FOX;
-            targetSlot->entityInfo.foxInfo = foxEntity;
+            targetSlot->entityInfo.foxInfo = *foxEntity;
             return MOVEMENT_KILLED_PREY;
             
         case EMPTY:
             targetSlot->slotContent = FOX;
-            targetSlot->entityInfo.foxInfo = foxEntity;
+            targetSlot->entityInfo.foxInfo = *foxEntity;
             return MOVEMENT_SUCCESS;
             
         case ROCK:
@@ -156,8 +134,8 @@ static int resolveRabbitConflict(RabbitInfo* movingRabbit, RabbitInfo* occupying
     int occupyingRabbitAge = calculateRabbitAge(occupyingRabbit, movingRabbit);
     
 #ifdef VERBOSE
-    printf("Rabbit conflict: moving %p (age %d) vs occupying %p (age %d) - details: (%d %d %d) vs (%d %d %d)\n",
-           movingRabbit, movingRabbitAge, occupyingRabbit, occupyingRabbitAge,
+    printf("Rabbit conflict: moving (age %d) vs occupying (age %d) - details: (%d %d %d) vs (%d %d %d)\n",
+           movingRabbitAge, occupyingRabbitAge,
            movingRabbit->currentGen, movingRabbit->genUpdated, movingRabbit->prevGen,
            occupyingRabbit->currentGen, occupyingRabbit->genUpdated, occupyingRabbit->prevGen);
 #endif
@@ -171,12 +149,11 @@ int processRabbitMovement(RabbitInfo* rabbitEntity, WorldSlot* targetSlot) {
     
     switch (targetType) {
         case RABBIT: {
-            RabbitInfo* occupyingRabbit = targetSlot->entityInfo.rabbitInfo;
+            RabbitInfo* occupyingRabbit = &targetSlot->entityInfo.rabbitInfo;
             int conflictResult = resolveRabbitConflict(rabbitEntity, occupyingRabbit);
             
             if (conflictResult == MOVEMENT_SUCCESS) {
-                destroyRabbitEntity(occupyingRabbit);
-                targetSlot->entityInfo.rabbitInfo = rabbitEntity;
+                targetSlot->entityInfo.rabbitInfo = *rabbitEntity;
                 return MOVEMENT_SUCCESS;
             }
             return MOVEMENT_FAILED;
@@ -184,7 +161,7 @@ int processRabbitMovement(RabbitInfo* rabbitEntity, WorldSlot* targetSlot) {
         
         case EMPTY:
             targetSlot->slotContent = RABBIT;
-            targetSlot->entityInfo.rabbitInfo = rabbitEntity;
+            targetSlot->entityInfo.rabbitInfo = *rabbitEntity;
             return MOVEMENT_SUCCESS;
             
         case FOX:
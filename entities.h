@@ -3,13 +3,12 @@
 
 #include "rabbitsandfoxes.h"
 
-// Entity initialization and cleanup
-FoxInfo* createFoxEntity(void);
-RabbitInfo* createRabbitEntity(void);
-void destroyFoxEntity(FoxInfo* foxEntity);
-void destroyRabbitEntity(RabbitInfo* rabbitEntity);
+// Entity initialization, places a newborn entity in the given slot
+void placeFoxEntity(WorldSlot* slot);
+void placeRabbitEntity(WorldSlot* slot);
 
-// Entity movement handling
+// Entity movement handling. The entity state is copied into the target slot when the move succeeds,
+// a losing entity is simply not copied anywhere
 int processFoxMovement(FoxInfo* foxEntity, WorldSlot* targetSlot);
 int processRabbitMovement(RabbitInfo* rabbitEntity, WorldSlot* targetSlot);
 
@@ -0,0 +1,251 @@
+#include "loader.h"
+#include "output.h"
+#include "movements.h"
+#include "matrix_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//Entities a chunk list starts with room for
+#define INITIAL_CHUNK_CAPACITY 1024
+
+WorldLoad *createWorldLoad(InputReader *reader, InputData *simulationData, WorldSlot *world, WorldSlot *backWorld,
+                           int threadCount) {
+    WorldLoad *load = malloc(sizeof(WorldLoad));
+
+    load->reader = reader;
+    load->simulationData = simulationData;
+    load->world = world;
+    load->backWorld = backWorld;
+    load->threadCount = threadCount;
+    load->irregularInput = 0;
+
+    pthread_barrier_init(&load->barrier, NULL, threadCount);
+
+    load->chunkEntities = malloc(sizeof(ParsedEntity *) * threadCount);
+    load->chunkCounts = calloc(threadCount, sizeof(int));
+    load->chunkCapacities = calloc(threadCount, sizeof(int));
+    load->keptCounts = calloc(threadCount, sizeof(int));
+    load->bandCounts = calloc((size_t) threadCount * threadCount, sizeof(int));
+    load->bandEntities = calloc(threadCount, sizeof(int));
+    load->bandRocks = calloc(threadCount, sizeof(int));
+
+    for (int thread = 0; thread < threadCount; thread++) {
+        load->chunkEntities[thread] = NULL;
+    }
+
+    load->sortedEntities = malloc(sizeof(ParsedEntity) * (simulationData->initialPopulation > 0 ?
+                                                          simulationData->initialPopulation : 1));
+
+    return load;
+}
+
+static int bandStartRow(WorldLoad *load, int band) {
+    return (int) ((long) band * load->simulationData->rows / load->threadCount);
+}
+
+//The band whose rows include row, the inverse of bandStartRow
+static int bandOfRow(WorldLoad *load, int row) {
+    return (int) (((long) row + 1) * load->threadCount - 1) / load->simulationData->rows;
+}
+
+static void parseChunk(int threadNumber, WorldLoad *load) {
+    InputReader part;
+
+    splitInputReader(load->reader, load->threadCount, threadNumber, &part);
+
+    ParsedEntity entity;
+
+    int read;
+
+    while ((read = readEntityLine(&part, &entity.content, &entity.row, &entity.col)) > 0) {
+
+        if (load->chunkCounts[threadNumber] == load->chunkCapacities[threadNumber]) {
+            load->chunkCapacities[threadNumber] = load->chunkCapacities[threadNumber] > 0 ?
+                                                  load->chunkCapacities[threadNumber] * 2 : INITIAL_CHUNK_CAPACITY;
+
+            load->chunkEntities[threadNumber] = realloc(load->chunkEntities[threadNumber],
+                                                        sizeof(ParsedEntity) * load->chunkCapacities[threadNumber]);
+        }
+
+        load->chunkEntities[threadNumber][load->chunkCounts[threadNumber]++] = entity;
+    }
+
+    //Every chunk only ever sets it, and it is read after the barrier
+    if (read < 0) {
+        load->irregularInput = 1;
+    }
+}
+
+//Keep the entities of our chunk that are part of the initial population and count them per band
+static void countChunkBands(int threadNumber, WorldLoad *load) {
+    int firstEntity = 0;
+
+    for (int thread = 0; thread < threadNumber; thread++) {
+        firstEntity += load->chunkCounts[thread];
+    }
+
+    int kept = load->simulationData->initialPopulation - firstEntity;
+
+    if (kept > load->chunkCounts[threadNumber]) kept = load->chunkCounts[threadNumber];
+    if (kept < 0) kept = 0;
+
+    load->keptCounts[threadNumber] = kept;
+
+    int *bandCounts = &load->bandCounts[threadNumber * load->threadCount];
+
+    //The lines after the initial population are never read by the sequential loading, so they are not checked
+    for (int entity = 0; entity < kept; entity++) {
+        ParsedEntity *parsed = &load->chunkEntities[threadNumber][entity];
+
+        checkEntityPosition(load->simulationData, parsed->row, parsed->col);
+
+        bandCounts[bandOfRow(load, parsed->row)]++;
+    }
+}
+
+//Index of the first entity of a band in the sorted entities
+static int bandStartEntity(WorldLoad *load, int band) {
+    int start = 0;
+
+    for (int previousBand = 0; previousBand < band; previousBand++) {
+        for (int thread = 0; thread < load->threadCount; thread++) {
+            start += load->bandCounts[thread * load->threadCount + previousBand];
+        }
+    }
+
+    return start;
+}
+
+//Move the entities of our chunk to their place in the sorted entities, after the ones of the earlier chunks
+static void scatterChunk(int threadNumber, WorldLoad *load) {
+    int *positions = malloc(sizeof(int) * load->threadCount);
+
+    for (int band = 0; band < load->threadCount; band++) {
+        positions[band] = bandStartEntity(load, band);
+
+        for (int thread = 0; thread < threadNumber; thread++) {
+            positions[band] += load->bandCounts[thread * load->threadCount + band];
+        }
+    }
+
+    for (int entity = 0; entity < load->keptCounts[threadNumber]; entity++) {
+        ParsedEntity *parsed = &load->chunkEntities[threadNumber][entity];
+
+        load->sortedEntities[positions[bandOfRow(load, parsed->row)]++] = *parsed;
+    }
+
+    free(positions);
+}
+
+static void placeBand(int threadNumber, WorldLoad *load) {
+    InputData *simulationData = load->simulationData;
+
+    int startRow = bandStartRow(load, threadNumber), endRow = bandStartRow(load, threadNumber + 1) - 1;
+
+    int firstEntity = bandStartEntity(load, threadNumber), lastEntity = bandStartEntity(load, threadNumber + 1);
+
+    for (int entity = firstEntity; entity < lastEntity; entity++) {
+        ParsedEntity *parsed = &load->sortedEntities[entity];
+
+        placeWorldEntity(&load->world[PROJECT(simulationData->columns, parsed->row, parsed->col)], parsed->content);
+    }
+
+    load->bandRocks[threadNumber] = countRowEntities(simulationData, load->world, startRow, endRow);
+
+    int entities = 0;
+
+    for (int row = startRow; row <= endRow; row++) {
+        entities += simulationData->entitiesPerRow[row];
+    }
+
+    load->bandEntities[threadNumber] = entities;
+}
+
+static void finishBand(int threadNumber, WorldLoad *load) {
+    InputData *simulationData = load->simulationData;
+
+    int startRow = bandStartRow(load, threadNumber), endRow = bandStartRow(load, threadNumber + 1) - 1;
+
+    calculateTopologyRows(simulationData, load->world, startRow, endRow);
+
+    int accumulated = 0;
+
+    for (int band = 0; band < threadNumber; band++) {
+        accumulated += load->bandEntities[band];
+    }
+
+    for (int row = startRow; row <= endRow; row++) {
+        accumulated += simulationData->entitiesPerRow[row];
+
+        simulationData->entitiesAccumulatedPerRow[row] = accumulated;
+    }
+
+    //Rocks are never written again, so the back buffer has to start with them
+    copyWorldRows(simulationData, load->world, load->backWorld, startRow, endRow);
+}
+
+void loadWorldPart(int threadNumber, WorldLoad *load) {
+    parseChunk(threadNumber, load);
+
+    pthread_barrier_wait(&load->barrier);
+
+    if (load->irregularInput) {
+        return;
+    }
+
+    countChunkBands(threadNumber, load);
+
+    pthread_barrier_wait(&load->barrier);
+
+    scatterChunk(threadNumber, load);
+
+    pthread_barrier_wait(&load->barrier);
+
+    placeBand(threadNumber, load);
+
+    //The topology of the edge rows of the band needs the rocks of the bands next to it
+    pthread_barrier_wait(&load->barrier);
+
+    finishBand(threadNumber, load);
+}
+
+int finishWorldLoad(WorldLoad *load) {
+    int loaded = !load->irregularInput;
+
+    if (loaded) {
+        int entities = 0, rocks = 0;
+
+        for (int thread = 0; thread < load->threadCount; thread++) {
+            entities += load->keptCounts[thread];
+            rocks += load->bandRocks[thread];
+        }
+
+        if (entities < load->simulationData->initialPopulation) {
+            fprintf(stderr, "ERROR: Expected %d entities but the input only has %d\n",
+                    load->simulationData->initialPopulation, entities);
+            exit(EXIT_FAILURE);
+        }
+
+        load->simulationData->rocks = rocks;
+
+        skipInputReader(load->reader);
+    }
+
+    for (int thread = 0; thread < load->threadCount; thread++) {
+        free(load->chunkEntities[thread]);
+    }
+
+    pthread_barrier_destroy(&load->barrier);
+
+    free(load->chunkEntities);
+    free(load->chunkCounts);
+    free(load->chunkCapacities);
+    free(load->keptCounts);
+    free(load->bandCounts);
+    free(load->sortedEntities);
+    free(load->bandEntities);
+    free(load->bandRocks);
+    free(load);
+
+    return loaded;
+}
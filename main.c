@@ -1,24 +1,326 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include "rabbitsandfoxes.h"
+#include "engine.h"
+#include "scheduler.h"
+#include "bitboard.h"
+#include "snapshot.h"
+#include "checkpoint.h"
+#include "benchmark.h"
 
+//Whether an argument is a flag with an optional value, either the flag itself or the flag followed by =value
+static int isFlagWithValue(const char *argument, const char *flag) {
+    size_t length = strlen(flag);
+
+    return strcmp(argument, flag) == 0 || (strncmp(argument, flag, length) == 0 && argument[ length ] == '=');
+}
+
+static BitboardKernel parseBitboardKernel(const char *name) {
+    BitboardKernel kernels[] = { BITBOARD_AUTO, BITBOARD_AVX2, BITBOARD_SSE2, BITBOARD_WORDS };
+
+    for (int kernel = 0; kernel < sizeof(kernels) / sizeof(kernels[ 0 ]); kernel++) {
+        if (strcmp(name, bitboardKernelName(kernels[ kernel ])) == 0) {
+            return kernels[ kernel ];
+        }
+    }
+
+    fprintf(stderr, "Unknown bitboard kernel %s\n", name);
+    exit(EXIT_FAILURE);
+}
+
+static PinMode parsePinMode(const char *name) {
+    if (strcmp(name, "cores") == 0) {
+        return PIN_CORES;
+    }
+
+    if (strcmp(name, "nodes") == 0) {
+        return PIN_NODES;
+    }
+
+    fprintf(stderr, "Unknown pin mode %s, the threads can be pinned to cores or nodes\n", name);
+    exit(EXIT_FAILURE);
+}
+
+/*
+ * Usage: ecosystem <threads|auto[=max]> [--neighbour-sync[=K]] [--tiles] [--work-stealing[=N]] [--bitboard[=kernel]]
+ *                  [--binary-input] [--binary-output=file] [--checkpoint=K] [--checkpoint-file=file]
+ *                  [--resume[=file]] [--benchmark[=warmup,repeats]] [--benchmark-output=file]
+ *                  [--benchmark-counters] [--pin=cores|nodes] [--batch [input files...]]
+ *
+ * With auto the number of threads is picked from the size and the population of the world and the time of its first
+ * generations, and lowered while it runs when the threads left out no longer make the generations faster. Small
+ * worlds are simulated sequentially. At most max threads are used, as many as there are cores unless given (see
+ * autotune.h).
+ *
+ * With --batch every thread simulates whole worlds instead of splitting a single one. The worlds are read from
+ * the given input files or, if there are none, from a stream of concatenated inputs on stdin.
+ *
+ * With --neighbour-sync the threads only wait for the threads next to them instead of all the threads, and the
+ * rows are only rebalanced every K generations.
+ *
+ * With --tiles the world is split in a grid of tiles instead of bands of rows, so more threads than rows can be used.
+ *
+ * With --work-stealing the world is cut in NxN tiles that the threads take as tasks, stealing them from each other
+ * when they run out, and the time each thread was busy and idle is written to stderr.
+ *
+ * With --bitboard the moves of the animals are found from bitmaps of whole rows instead of looking at the slots next
+ * to every animal. The kernel can be auto (the default), avx2, sse2 or words (no vector instructions).
+ *
+ * With --binary-input the input is a world snapshot (see snapshot.h) instead of a text world, and the simulation
+ * goes on from the generation it was taken at. With --binary-output the simulated world is also written to the
+ * given file as a snapshot. worldconvert turns text worlds into snapshots and back.
+ *
+ * With --checkpoint the world is saved every K generations, by a background thread, to the checkpoint file
+ * (ecosystem.checkpoint unless --checkpoint-file is given). --resume continues an interrupted simulation from the
+ * given checkpoint file, or the default one, instead of reading stdin.
+ *
+ * With --benchmark the world is simulated warmup + repeats times (1 and 3 unless given) with every phase of every
+ * thread timed, and the times are written as JSON to benchmark.json, or the --benchmark-output file (see benchmark.h).
+ * With --benchmark-counters the cycles, instructions, last level cache misses and context switches of every phase are
+ * counted too, when the kernel lets us (see counters.h).
+ *
+ * With --pin every thread is pinned to a core, or to the cores of a NUMA node, the threads are spread over the nodes
+ * in contiguous blocks, every thread first touches its band of the world so its pages are on its node, and the rows
+ * are only rebalanced between the threads of the same node. Where the pages of the world ended up is written to
+ * stderr (see placement.h).
+ */
 int main(int argc, char **argv) {
 
-    int sequential = 0, threads = 1;
+    int sequential = 0, threads = 1, batch = 0, autoThreads = 0;
+
+    int inputFileCount = 0;
+
+    SyncMode syncMode = SYNC_BARRIER;
+
+    PartitionMode partitionMode = PARTITION_BANDS;
+
+    int rebalanceInterval = DEFAULT_REBALANCE_INTERVAL;
+
+    int taskTileSize = DEFAULT_TASK_TILE_SIZE;
+
+    AnalysisMode analysisMode = ANALYSIS_SCALAR;
+
+    BitboardKernel bitboardKernel = BITBOARD_AUTO;
+
+    SnapshotOptions snapshots = { .binaryInput = 0, .outputPath = NULL, .checkpointPath = DEFAULT_CHECKPOINT_PATH,
+                                  .checkpointInterval = 0 };
+
+    const char *resumePath = NULL;
+
+    int benchmark = 0;
+
+    PinMode pinMode = PIN_NONE;
+
+    BenchmarkOptions benchmarkOptions = { .warmup = DEFAULT_BENCHMARK_WARMUP, .repeats = DEFAULT_BENCHMARK_REPEATS,
+                                          .outputPath = DEFAULT_BENCHMARK_OUTPUT };
+
+    char **inputFiles = malloc(sizeof(char *) * argc);
+
+    for (int arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[ arg ], "--batch") == 0) {
+            batch = 1;
+        } else if (strcmp(argv[ arg ], "--tiles") == 0) {
+            partitionMode = PARTITION_TILES;
+        } else if (isFlagWithValue(argv[ arg ], "--work-stealing")) {
+            partitionMode = PARTITION_STEALING;
+
+            char *tileSize = strchr(argv[ arg ], '=');
+
+            if (tileSize != NULL) {
+                taskTileSize = atoi(tileSize + 1);
+
+                if (taskTileSize <= 0) {
+                    fprintf(stderr, "The tile size must be a positive number of slots\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+        } else if (isFlagWithValue(argv[ arg ], "--bitboard")) {
+            analysisMode = ANALYSIS_BITBOARD;
+
+            char *kernel = strchr(argv[ arg ], '=');
+
+            if (kernel != NULL) {
+                bitboardKernel = parseBitboardKernel(kernel + 1);
+            }
+        } else if (strcmp(argv[ arg ], "--binary-input") == 0) {
+            snapshots.binaryInput = 1;
+        } else if (strncmp(argv[ arg ], "--binary-output=", strlen("--binary-output=")) == 0) {
+            snapshots.outputPath = argv[ arg ] + strlen("--binary-output=");
+        } else if (strncmp(argv[ arg ], "--checkpoint-file=", strlen("--checkpoint-file=")) == 0) {
+            snapshots.checkpointPath = argv[ arg ] + strlen("--checkpoint-file=");
+        } else if (strncmp(argv[ arg ], "--checkpoint=", strlen("--checkpoint=")) == 0) {
+            snapshots.checkpointInterval = atoi(argv[ arg ] + strlen("--checkpoint="));
+
+            if (snapshots.checkpointInterval <= 0) {
+                fprintf(stderr, "The checkpoint interval must be a positive number of generations\n");
+                exit(EXIT_FAILURE);
+            }
+        } else if (isFlagWithValue(argv[ arg ], "--resume")) {
+            char *path = strchr(argv[ arg ], '=');
+
+            resumePath = path != NULL ? path + 1 : DEFAULT_CHECKPOINT_PATH;
+
+            snapshots.binaryInput = 1;
+        } else if (strncmp(argv[ arg ], "--benchmark-output=", strlen("--benchmark-output=")) == 0) {
+            benchmarkOptions.outputPath = argv[ arg ] + strlen("--benchmark-output=");
+        } else if (strcmp(argv[ arg ], "--benchmark-counters") == 0) {
+            benchmarkOptions.counters = 1;
+        } else if (isFlagWithValue(argv[ arg ], "--benchmark")) {
+            benchmark = 1;
+
+            char *counts = strchr(argv[ arg ], '=');
+
+            if (counts != NULL) {
+                char *repeats = strchr(counts, ',');
+
+                benchmarkOptions.warmup = atoi(counts + 1);
 
-    if (argc > 1) {
-        threads = atoi(argv[1]);
+                if (repeats != NULL) {
+                    benchmarkOptions.repeats = atoi(repeats + 1);
+                }
 
-        if (threads <= 0) {
-            sequential = 1;
+                if (benchmarkOptions.warmup < 0 || benchmarkOptions.repeats <= 0) {
+                    fprintf(stderr, "The benchmark needs a warmup of zero or more runs and at least one repeat\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+        } else if (strncmp(argv[ arg ], "--pin=", strlen("--pin=")) == 0) {
+            pinMode = parsePinMode(argv[ arg ] + strlen("--pin="));
+        } else if (isFlagWithValue(argv[ arg ], "--neighbour-sync")) {
+            syncMode = SYNC_NEIGHBOURS;
+
+            char *interval = strchr(argv[ arg ], '=');
+
+            if (interval != NULL) {
+                rebalanceInterval = atoi(interval + 1);
+
+                if (rebalanceInterval <= 0) {
+                    fprintf(stderr, "The rebalance interval must be a positive number of generations\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+        } else if (arg == 1 && isFlagWithValue(argv[ arg ], "auto")) {
+            autoThreads = 1;
+
+            char *maxThreads = strchr(argv[ arg ], '=');
+
+            threads = maxThreads != NULL ? atoi(maxThreads + 1) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+            if (threads <= 0) {
+                fprintf(stderr, "The most threads auto can use must be a positive number\n");
+                exit(EXIT_FAILURE);
+            }
+        } else if (arg == 1) {
+            threads = atoi(argv[ arg ]);
+
+            if (threads <= 0) {
+                sequential = 1;
+            }
+        } else if (batch) {
+            inputFiles[ inputFileCount++ ] = argv[ arg ];
+        } else {
+            fprintf(stderr, "Unknown argument %s\n", argv[ arg ]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (batch && (snapshots.binaryInput || snapshots.outputPath != NULL || snapshots.checkpointInterval > 0)) {
+        fprintf(stderr, "Snapshots can't be used in batch mode\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (batch && benchmark) {
+        fprintf(stderr, "The benchmark can't be used in batch mode\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (autoThreads && (batch || benchmark)) {
+        fprintf(stderr, "The threads can't be picked automatically in batch mode or for the benchmark\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (pinMode != PIN_NONE && (batch || sequential)) {
+        fprintf(stderr, "The threads can only be pinned when they split a world between them\n");
+        exit(EXIT_FAILURE);
+    }
+
+    FILE *inputFile = stdin;
+
+    if (resumePath != NULL) {
+        inputFile = fopen(resumePath, "rb");
+
+        if (inputFile == NULL) {
+            fprintf(stderr, "Failed to open checkpoint file %s\n", resumePath);
+            exit(EXIT_FAILURE);
         }
     }
 
-    if (!sequential) {
-        runParallelSimulation(threads, stdin, stdout);
+    if (batch) {
+        //A sequential batch still needs a worker to run the worlds on
+        SimulationEngine *engine = createSimulationEngine(sequential ? 1 : threads);
+
+        setEngineAnalysis(engine, analysisMode, bitboardKernel);
+
+        int jobCount = 0;
+
+        SimulationJob **jobs;
+
+        if (inputFileCount > 0) {
+            jobs = malloc(sizeof(SimulationJob *) * inputFileCount);
+
+            for (int file = 0; file < inputFileCount; file++) {
+                FILE *inputFile = fopen(inputFiles[ file ], "r");
+
+                if (inputFile == NULL) {
+                    fprintf(stderr, "Failed to open input file %s\n", inputFiles[ file ]);
+                    exit(EXIT_FAILURE);
+                }
+
+                jobs[ jobCount++ ] = loadSimulationJobOnEngine(engine, inputFile);
+
+                fclose(inputFile);
+            }
+        } else {
+            jobs = loadSimulationJobStream(stdin, &jobCount);
+        }
+
+        runSimulationBatch(engine, jobs, jobCount, stdout);
+
+        free(jobs);
+
+        destroySimulationEngine(engine);
+    } else if (!sequential) {
+        SimulationEngine *engine = createSimulationEngine(threads);
+
+        setEngineSynchronization(engine, syncMode, rebalanceInterval);
+        setEnginePartitioning(engine, partitionMode);
+        setEngineTaskTileSize(engine, taskTileSize);
+        setEngineAnalysis(engine, analysisMode, bitboardKernel);
+        setEngineSnapshots(engine, &snapshots);
+        setEnginePlacement(engine, pinMode);
+        setEngineAutoThreads(engine, autoThreads);
+
+        if (benchmark) {
+            runSimulationBenchmark(engine, analysisMode, bitboardKernel, &snapshots, inputFile, stdout,
+                                   &benchmarkOptions);
+        } else {
+            runEngineSimulation(engine, inputFile, stdout);
+        }
+
+        destroySimulationEngine(engine);
+    } else if (benchmark) {
+        runSimulationBenchmark(NULL, analysisMode, bitboardKernel, &snapshots, inputFile, stdout, &benchmarkOptions);
     } else {
-        runSequentialSimulation(stdin, stdout);
+        runSequentialSimulation(inputFile, stdout, analysisMode, bitboardKernel, &snapshots);
+    }
+
+    if (inputFile != stdin) {
+        fclose(inputFile);
     }
 
+    free(inputFiles);
+
     return 0;
 }
@@ -0,0 +1,209 @@
+/*
+ * Movement selection microbenchmark
+ *
+ * Usage: movement_benchmark [side] [rounds], e.g. movement_benchmark 512 50
+ *
+ * Analyzes the moves of every animal of a random world and picks the one it takes, the way the generations do,
+ * comparing:
+ *  - the filtered arrays the analysis used to build (a branch per direction and per slot content, the options
+ *    listed in an array, indexed with (genNumber + row + col) % count and the move looked up with a switch)
+ *  - the option masks of analyze*MovementOptions, picked with the MOVE_SELECTION table and MOVE_DELTAS
+ *
+ * Both must take the same moves, the sum of the destinations is printed to check it.
+ */
+
+#include "movements.h"
+#include "matrix_utils.h"
+#include "occupancy.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DIRECTIONS 4
+
+//Share of the slots holding rocks, rabbits and foxes, in percent
+#define ROCK_SHARE 5
+#define RABBIT_SHARE 25
+#define FOX_SHARE 15
+
+static const Move LEGACY_MOVES[DIRECTIONS] = {{-1, 0}, {0, 1}, {1, 0}, {0, -1}};
+
+static const Move *legacyMoveDirection(MoveDirection direction) {
+    switch (direction) {
+        case NORTH:
+            return &LEGACY_MOVES[0];
+        case EAST:
+            return &LEGACY_MOVES[1];
+        case SOUTH:
+            return &LEGACY_MOVES[2];
+        case WEST:
+            return &LEGACY_MOVES[3];
+        default:
+            return &LEGACY_MOVES[0];
+    }
+}
+
+//The moves of the animal at row, col with the filtered arrays, returns the destination as row * columns + col
+static long legacyMove(int genNumber, int row, int col, InputData *worldData, WorldSlot *world) {
+    WorldSlot *currentSlot = &world[PROJECT(worldData->columns, row, col)];
+
+    unsigned char validMoves = worldData->topology[PROJECT(worldData->columns, row, col)];
+
+    MoveDirection preyDirections[DIRECTIONS], emptyDirections[DIRECTIONS];
+
+    int preyMovements = 0, emptyMovements = 0;
+
+    for (int direction = 0; direction < DIRECTIONS; direction++) {
+        if (!(validMoves & (1 << direction))) {
+            continue;
+        }
+
+        const Move *moveVector = legacyMoveDirection(direction);
+
+        SlotContent targetContent = world[PROJECT(worldData->columns, row + moveVector->x, col + moveVector->y)].slotContent;
+
+        if (targetContent == RABBIT && currentSlot->slotContent == FOX) {
+            preyDirections[preyMovements++] = direction;
+        } else if (targetContent == EMPTY) {
+            emptyDirections[emptyMovements++] = direction;
+        }
+    }
+
+    MoveDirection direction;
+
+    if (preyMovements > 0) {
+        direction = preyDirections[(genNumber + row + col) % preyMovements];
+    } else if (emptyMovements > 0) {
+        direction = emptyDirections[(genNumber + row + col) % emptyMovements];
+    } else {
+        return PROJECT(worldData->columns, row, col);
+    }
+
+    const Move *move = legacyMoveDirection(direction);
+
+    return PROJECT(worldData->columns, row + move->x, col + move->y);
+}
+
+static long tableMove(int genNumber, int row, int col, InputData *worldData, WorldSlot *world,
+                      struct RabbitMovements *rabbitMovements, struct FoxMovements *foxMovements) {
+    unsigned char directions;
+
+    if (world[PROJECT(worldData->columns, row, col)].slotContent == FOX) {
+        analyzeFoxMovementOptions(row, col, worldData, world, foxMovements);
+
+        directions = foxMovements->rabbitMovements > 0 ? foxMovements->rabbitDirections : foxMovements->emptyDirections;
+    } else {
+        analyzeRabbitMovementOptions(row, col, worldData, world, rabbitMovements);
+
+        directions = rabbitMovements->emptyDirections;
+    }
+
+    if (directions == 0) {
+        return PROJECT(worldData->columns, row, col);
+    }
+
+    const Move *move = getMoveDirection(chooseMoveDirection(directions, genNumber + row + col));
+
+    return PROJECT(worldData->columns, row + move->x, col + move->y);
+}
+
+static double elapsedSeconds(struct timespec *start, struct timespec *end) {
+    return (double) (end->tv_sec - start->tv_sec) + (double) (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv) {
+    int side = argc > 1 ? atoi(argv[1]) : 512, rounds = argc > 2 ? atoi(argv[2]) : 50;
+
+    if (side <= 0 || rounds <= 0) {
+        fprintf(stderr, "Usage: %s [side] [rounds]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    InputData worldData = {.rows = side, .columns = side};
+
+    WorldSlot *world = calloc(1, WORLD_MATRIX_SIZE(side, side));
+
+    worldData.topology = malloc((size_t) side * side);
+
+    srand(42);
+
+    for (int slot = 0; slot < side * side; slot++) {
+        int roll = rand() % 100;
+
+        world[slot].slotContent = roll < ROCK_SHARE ? ROCK :
+                                  roll < ROCK_SHARE + RABBIT_SHARE ? RABBIT :
+                                  roll < ROCK_SHARE + RABBIT_SHARE + FOX_SHARE ? FOX : EMPTY;
+    }
+
+    int animals = 0;
+
+    for (int row = 0; row < side; row++) {
+        for (int col = 0; col < side; col++) {
+            SlotContent content = world[PROJECT(side, row, col)].slotContent;
+
+            if (content == ROCK) rockRow(&worldData, world, row)[col / 64] |= 1ULL << (col % 64);
+
+            if (content >= RABBIT) animals++;
+        }
+    }
+
+    calculateWorldTopology(&worldData, world);
+
+    struct RabbitMovements *rabbitMovements = createRabbitMovementContext();
+    struct FoxMovements *foxMovements = createFoxMovementContext();
+
+    struct timespec start, end;
+
+    long legacyChecksum = 0, tableChecksum = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int genNumber = 0; genNumber < rounds; genNumber++) {
+        for (int row = 0; row < side; row++) {
+            for (int col = 0; col < side; col++) {
+                if (world[PROJECT(side, row, col)].slotContent < RABBIT) continue;
+
+                legacyChecksum += legacyMove(genNumber, row, col, &worldData, world);
+            }
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double legacySeconds = elapsedSeconds(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (int genNumber = 0; genNumber < rounds; genNumber++) {
+        for (int row = 0; row < side; row++) {
+            for (int col = 0; col < side; col++) {
+                if (world[PROJECT(side, row, col)].slotContent < RABBIT) continue;
+
+                tableChecksum += tableMove(genNumber, row, col, &worldData, world, rabbitMovements, foxMovements);
+            }
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double tableSeconds = elapsedSeconds(&start, &end);
+
+    double selections = (double) animals * rounds;
+
+    printf("Movement selection on a %dx%d world, %d animals, %d rounds\n", side, side, animals, rounds);
+    printf("%16s %12s %14s\n", "variant", "time (s)", "ns per animal");
+    printf("%16s %12.3f %14.2f\n", "filtered arrays", legacySeconds, legacySeconds * 1e9 / selections);
+    printf("%16s %12.3f %14.2f\n", "mask tables", tableSeconds, tableSeconds * 1e9 / selections);
+
+    destroyRabbitMovementContext(rabbitMovements);
+    destroyFoxMovementContext(foxMovements);
+    free(worldData.topology);
+    free(world);
+
+    if (legacyChecksum != tableChecksum) {
+        fprintf(stderr, "ERROR: The variants took different moves (%ld and %ld)\n", legacyChecksum, tableChecksum);
+        exit(EXIT_FAILURE);
+    }
+
+    return 0;
+}
@@ -1,134 +1,74 @@
 
 #include "movements.h"
 #include "matrix_utils.h"
+#include "occupancy.h"
 #include <stdlib.h>
 
 #define DIRECTIONS 4
 
-static Move *NORTH_MOVE = NULL;
-static Move *EAST_MOVE = NULL;
-static Move *SOUTH_MOVE = NULL;
-static Move *WEST_MOVE = NULL;
-
-static MoveDirection *defaultDirections = NULL;
-
-static void initializeMovementVectors() {
-    // Initialize directional movement vectors
-    NORTH_MOVE = malloc(sizeof(Move));
-    NORTH_MOVE->x = -1;  // Up (negative row)
-    NORTH_MOVE->y = 0;
-
-    EAST_MOVE = malloc(sizeof(Move));
-    EAST_MOVE->x = 0;
-    EAST_MOVE->y = 1;    // Right (positive column)
-
-    SOUTH_MOVE = malloc(sizeof(Move));
-    SOUTH_MOVE->x = 1;   // Down (positive row)
-    SOUTH_MOVE->y = 0;
-
-    WEST_MOVE = malloc(sizeof(Move));
-    WEST_MOVE->x = 0;
-    WEST_MOVE->y = -1;   // Left (negative column)
+const Move MOVE_DELTAS[DIRECTIONS] = {
+        [NORTH] = {.x = -1, .y = 0},  // Up (negative row)
+        [EAST] = {.x = 0, .y = 1},    // Right (positive column)
+        [SOUTH] = {.x = 1, .y = 0},   // Down (positive row)
+        [WEST] = {.x = 0, .y = -1}    // Left (negative column)
+};
+
+//Entry [mask][selector] is direction number selector % count of the count directions set in mask
+const unsigned char MOVE_SELECTION[16][MOVE_SELECTORS] = {
+        /*  0 */ {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+        /*  1 */ {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+        /*  2 */ {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1},
+        /*  3 */ {0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1},
+        /*  4 */ {2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2},
+        /*  5 */ {0, 2, 0, 2, 0, 2, 0, 2, 0, 2, 0, 2},
+        /*  6 */ {1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2},
+        /*  7 */ {0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2},
+        /*  8 */ {3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3},
+        /*  9 */ {0, 3, 0, 3, 0, 3, 0, 3, 0, 3, 0, 3},
+        /* 10 */ {1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3},
+        /* 11 */ {0, 1, 3, 0, 1, 3, 0, 1, 3, 0, 1, 3},
+        /* 12 */ {2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3},
+        /* 13 */ {0, 2, 3, 0, 2, 3, 0, 2, 3, 0, 2, 3},
+        /* 14 */ {1, 2, 3, 1, 2, 3, 1, 2, 3, 1, 2, 3},
+        /* 15 */ {0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3},
+};
+
+//1 when the slot at col of a row of the rock plane is not a rock
+static inline unsigned int isOpen(const uint64_t *rocks, int col) {
+    return (unsigned int) (~rocks[col / 64] >> (col % 64)) & 1;
 }
 
-static void initializeAllDirectionsArray() {
-    // Create array with all possible directions for memory optimization
-    defaultDirections = malloc(sizeof(MoveDirection) * DIRECTIONS);
-    
-    defaultDirections[0] = NORTH;
-    defaultDirections[1] = EAST;
-    defaultDirections[2] = SOUTH;
-    defaultDirections[3] = WEST;
+void calculateWorldTopology(InputData *worldData, WorldSlot *world) {
+    calculateTopologyRows(worldData, world, 0, worldData->rows - 1);
 }
 
-Move *getMoveDirection(MoveDirection direction) {
+void calculateTopologyRows(InputData *worldData, WorldSlot *world, int startRow, int endRow) {
+    int columns = worldData->columns;
 
-    if (NORTH_MOVE == NULL || EAST_MOVE == NULL || SOUTH_MOVE == NULL || WEST_MOVE == NULL) {
+    for (int row = startRow; row <= endRow; row++) {
+        //Outside the world behaves like a row of rocks
+        const uint64_t *rocks = rockRow(worldData, world, row),
+                *rocksAbove = row > 0 ? rockRow(worldData, world, row - 1) : NULL,
+                *rocksBelow = row < worldData->rows - 1 ? rockRow(worldData, world, row + 1) : NULL;
 
-        initializeMovementVectors();
+        unsigned char *topology = &worldData->topology[PROJECT(columns, row, 0)];
 
-    }
+        unsigned int northMask = rocksAbove != NULL, southMask = rocksBelow != NULL;
 
-    switch (direction) {
-        case NORTH: {
-            return NORTH_MOVE;
-        }
-        case EAST: {
-            return EAST_MOVE;
-        }
-        case SOUTH: {
-            return SOUTH_MOVE;
-        }
-        case WEST: {
-            return WEST_MOVE;
-        }
-
-        default:
-            return NORTH_MOVE;
-    }
-
-}
-
-static int isValidPosition(int row, int col, InputData *worldData) {
-    return (row >= 0 && col >= 0 && row < worldData->rows && col < worldData->columns);
-}
+        if (rocksAbove == NULL) rocksAbove = rocks;
+        if (rocksBelow == NULL) rocksBelow = rocks;
 
-static int isMovementBlocked(int fromRow, int fromCol, MoveDirection direction, 
-                             InputData *worldData, WorldSlot *world) {
-    Move *moveVector = getMoveDirection(direction);
-    int targetRow = fromRow + moveVector->x;
-    int targetCol = fromCol + moveVector->y;
-    
-    // Check world boundaries
-    if (!isValidPosition(targetRow, targetCol, worldData)) {
-        return 1;  // Movement blocked by world boundary
-    }
-    
-    // Check for permanent obstacles (rocks)
-    WorldSlot *targetSlot = &world[PROJECT(worldData->columns, targetRow, targetCol)];
-    if (targetSlot->slotContent == ROCK) {
-        return 1;  // Movement blocked by rock
-    }
-    
-    return 0;  // Movement is valid
-}
-
-struct DefaultMovements calculateValidMovements(int row, int col, InputData *worldData, WorldSlot *world) {
-    int validDirections[DIRECTIONS] = {1, 1, 1, 1};  // Initially assume all directions valid
-    int validMovementCount = 0;
-    
-    // Check each direction for validity
-    for (int direction = 0; direction < DIRECTIONS; direction++) {
-        if (isMovementBlocked(row, col, direction, worldData, world)) {
-            validDirections[direction] = 0;
-        } else {
-            validMovementCount++;
+        for (int col = 0; col < columns; col++) {
+            topology[col] = (unsigned char) (((isOpen(rocksAbove, col) & northMask) << NORTH) |
+                                             ((isOpen(rocksBelow, col) & southMask) << SOUTH));
         }
-    }
-    
-    // Allocate directions array
-    MoveDirection *availableDirections;
-    
-    if (validMovementCount == DIRECTIONS) {
-        // All directions valid - use shared array for memory efficiency
-        if (defaultDirections == NULL) {
-            initializeAllDirectionsArray();
-        }
-        availableDirections = defaultDirections;
-    } else {
-        // Some directions blocked - create custom array
-        availableDirections = malloc(sizeof(MoveDirection) * validMovementCount);
-        int arrayIndex = 0;
-        
-        for (int direction = 0; direction < DIRECTIONS; direction++) {
-            if (validDirections[direction]) {
-                availableDirections[arrayIndex++] = direction;
-            }
+
+        //The east and west neighbours are the slots next to us in the same row
+        for (int col = 0; col < columns - 1; col++) {
+            topology[col] |= (unsigned char) (isOpen(rocks, col + 1) << EAST);
+            topology[col + 1] |= (unsigned char) (isOpen(rocks, col) << WEST);
         }
     }
-    
-    struct DefaultMovements result = {validMovementCount, availableDirections};
-    return result;
 }
 
 struct FoxMovements *createFoxMovementContext() {
@@ -138,20 +78,11 @@ struct FoxMovements *createFoxMovementContext() {
         return NULL;
     }
     
-    // Initialize movement counters
+    // Initialize movement options
     context->emptyMovements = 0;
+    context->emptyDirections = 0;
     context->rabbitMovements = 0;
-    
-    // Allocate direction arrays (maximum possible directions)
-    context->rabbitDirections = malloc(sizeof(MoveDirection) * DIRECTIONS);
-    context->emptyDirections = malloc(sizeof(MoveDirection) * DIRECTIONS);
-    
-    if (context->rabbitDirections == NULL || context->emptyDirections == NULL) {
-        free(context->rabbitDirections);
-        free(context->emptyDirections);
-        free(context);
-        return NULL;
-    }
+    context->rabbitDirections = 0;
     
     return context;
 }
@@ -163,140 +94,64 @@ struct RabbitMovements *createRabbitMovementContext() {
         return NULL;
     }
     
-    // Initialize movement counter
+    // Initialize movement options
     context->emptyMovements = 0;
-    
-    // Allocate direction array (maximum possible directions)
-    context->emptyDirections = malloc(sizeof(MoveDirection) * DIRECTIONS);
-    
-    if (context->emptyDirections == NULL) {
-        free(context);
-        return NULL;
-    }
+    context->emptyDirections = 0;
     
     return context;
 }
 
 void analyzeFoxMovementOptions(int row, int col, InputData *worldData, WorldSlot *world, struct FoxMovements *result) {
-    WorldSlot *currentSlot = &world[PROJECT(worldData->columns, row, col)];
+    unsigned char preyDirections = 0, emptyDirections = 0;
     
-    int preyMovements = 0, emptyMovements = 0;
-    int preyDirectionsFlags[currentSlot->defaultP];
-    int emptyDirectionsFlags[currentSlot->defaultP];
-    
-    // Analyze each possible direction
-    for (int dirIndex = 0; dirIndex < currentSlot->defaultP; dirIndex++) {
-        MoveDirection direction = currentSlot->defaultPossibleMoveDirections[dirIndex];
-        Move *moveVector = getMoveDirection(direction);
-        
-        int targetRow = row + moveVector->x;
-        int targetCol = col + moveVector->y;
-        WorldSlot *targetSlot = &world[PROJECT(worldData->columns, targetRow, targetCol)];
+    // Only look at the directions that are inside the world and not a rock
+    unsigned int directions = worldData->topology[PROJECT(worldData->columns, row, col)];
+
+    for (; directions != 0; directions &= directions - 1) {
+        int direction = __builtin_ctz(directions);
+
+        const Move *moveVector = getMoveDirection(direction);
         
-        SlotContent targetContent = targetSlot->slotContent;
+        SlotContent targetContent = world[PROJECT(worldData->columns, row + moveVector->x, col + moveVector->y)].slotContent;
         
-        if (targetContent == RABBIT) {
-            // Fox can hunt prey
-            preyMovements++;
-            preyDirectionsFlags[dirIndex] = 1;
-            emptyDirectionsFlags[dirIndex] = 0;
-        } else if (targetContent == EMPTY) {
-            // Fox can move to empty space
-            emptyMovements++;
-            emptyDirectionsFlags[dirIndex] = 1;
-            preyDirectionsFlags[dirIndex] = 0;
-        } else {
-            // Fox cannot move here (fox or rock)
-            emptyDirectionsFlags[dirIndex] = 0;
-            preyDirectionsFlags[dirIndex] = 0;
-        }
+        // Fox can hunt prey or move to empty space, but not onto another fox
+        preyDirections |= (targetContent == RABBIT) << direction;
+        emptyDirections |= (targetContent == EMPTY) << direction;
     }
     
-    // Store results
-    result->rabbitMovements = preyMovements;
-    result->emptyMovements = emptyMovements;
-    
-    // Populate direction arrays based on priority (prey first, then empty spaces)
-    if (preyMovements > 0) {
-        int arrayIndex = 0;
-        for (int dirIndex = 0; dirIndex < currentSlot->defaultP; dirIndex++) {
-            if (preyDirectionsFlags[dirIndex]) {
-                result->rabbitDirections[arrayIndex++] = currentSlot->defaultPossibleMoveDirections[dirIndex];
-            }
-        }
-    } else if (emptyMovements > 0) {
-        int arrayIndex = 0;
-        for (int dirIndex = 0; dirIndex < currentSlot->defaultP; dirIndex++) {
-            if (emptyDirectionsFlags[dirIndex]) {
-                result->emptyDirections[arrayIndex++] = currentSlot->defaultPossibleMoveDirections[dirIndex];
-            }
-        }
-    }
+    // Store results, the prey directions take priority over the empty ones when choosing the move
+    result->rabbitDirections = preyDirections;
+    result->rabbitMovements = __builtin_popcount(preyDirections);
+    result->emptyDirections = emptyDirections;
+    result->emptyMovements = __builtin_popcount(emptyDirections);
 }
 
 void analyzeRabbitMovementOptions(int row, int col, InputData *worldData, WorldSlot *world,
                                    struct RabbitMovements *result) {
-    WorldSlot *currentSlot = &world[PROJECT(worldData->columns, row, col)];
+    unsigned char safeDirections = 0;
     
-    int safeMovements = 0;
-    int safeDirectionsFlags[currentSlot->defaultP];
-    
-    // Analyze each possible direction for safe movement
-    for (int dirIndex = 0; dirIndex < currentSlot->defaultP; dirIndex++) {
-        MoveDirection direction = currentSlot->defaultPossibleMoveDirections[dirIndex];
-        Move *moveVector = getMoveDirection(direction);
+    // Rabbit can only safely move to empty space (not a fox, a rabbit or a rock)
+    unsigned int directions = worldData->topology[PROJECT(worldData->columns, row, col)];
+
+    for (; directions != 0; directions &= directions - 1) {
+        int direction = __builtin_ctz(directions);
+
+        const Move *moveVector = getMoveDirection(direction);
         
-        int targetRow = row + moveVector->x;
-        int targetCol = col + moveVector->y;
-        WorldSlot *targetSlot = &world[PROJECT(worldData->columns, targetRow, targetCol)];
+        SlotContent targetContent = world[PROJECT(worldData->columns, row + moveVector->x, col + moveVector->y)].slotContent;
         
-        if (targetSlot->slotContent == EMPTY) {
-            // Rabbit can safely move to empty space
-            safeMovements++;
-            safeDirectionsFlags[dirIndex] = 1;
-        } else {
-            // Rabbit cannot move here (occupied by fox, rabbit, or rock)
-            safeDirectionsFlags[dirIndex] = 0;
-        }
+        safeDirections |= (targetContent == EMPTY) << direction;
     }
     
     // Store results
-    result->emptyMovements = safeMovements;
-    
-    // Populate direction array with safe movement options
-    if (safeMovements > 0) {
-        int arrayIndex = 0;
-        for (int dirIndex = 0; dirIndex < currentSlot->defaultP; dirIndex++) {
-            if (safeDirectionsFlags[dirIndex]) {
-                result->emptyDirections[arrayIndex++] = currentSlot->defaultPossibleMoveDirections[dirIndex];
-            }
-        }
-    }
-}
-
-void releaseMovementDirections(MoveDirection *directions) {
-    if (directions != NULL && directions != defaultDirections) {
-        free(directions);
-    }
-}
-
-void releaseDefaultMovements(struct DefaultMovements *movements) {
-    if (movements != NULL) {
-        releaseMovementDirections(movements->directions);
-    }
+    result->emptyDirections = safeDirections;
+    result->emptyMovements = __builtin_popcount(safeDirections);
 }
 
 void destroyFoxMovementContext(struct FoxMovements *context) {
-    if (context != NULL) {
-        free(context->rabbitDirections);
-        free(context->emptyDirections);
-        free(context);
-    }
+    free(context);
 }
 
 void destroyRabbitMovementContext(struct RabbitMovements *context) {
-    if (context != NULL) {
-        free(context->emptyDirections);
-        free(context);
-    }
-}
\ No newline at end of file
+    free(context);
+}
@@ -10,25 +10,59 @@ typedef enum MoveDirection_ {
     WEST = 3
 } MoveDirection;
 
+//How the threads find the moves of the animals
+typedef enum AnalysisMode_ {
+
+    //Look at the slots next to every animal (analyze*MovementOptions)
+    ANALYSIS_SCALAR,
+
+    //Classify the neighbours of whole rows at once with the occupancy bitmaps (see bitboard.h)
+    ANALYSIS_BITBOARD
+
+} AnalysisMode;
+
+//Instructions the bitboard classification uses
+typedef enum BitboardKernel_ {
+
+    //The widest the CPU supports
+    BITBOARD_AUTO,
+
+    //64 slots at a time in plain 64 bit words
+    BITBOARD_WORDS,
+
+    BITBOARD_SSE2,
+
+    BITBOARD_AVX2
+
+} BitboardKernel;
+
 typedef struct Move_ {
     int x, y;
 } Move;
 
-struct DefaultMovements {
-    int movementCount;
+/*
+ * The options of an animal are masks where bit d is set when the animal can move in MoveDirection d. The animal
+ * takes option (genNumber + row + col) % count of the options in direction order, which MOVE_SELECTION gives
+ * straight from the mask: the count is at most 4, so the selector only matters modulo 12 (the least common multiple
+ * of 1, 2, 3 and 4).
+ */
+#define MOVE_SELECTORS 12
 
-    MoveDirection *directions;
-};
+//Row mask holds the direction to take for every selector % MOVE_SELECTORS (row 0 has no options and is never used)
+extern const unsigned char MOVE_SELECTION[16][MOVE_SELECTORS];
+
+//The offset of a move in every MoveDirection
+extern const Move MOVE_DELTAS[4];
 
 struct FoxMovements {
     //Movements that lead to a rabbit
     int rabbitMovements;
 
-    MoveDirection *rabbitDirections;
+    unsigned char rabbitDirections;
 
     int emptyMovements;
 
-    MoveDirection *emptyDirections;
+    unsigned char emptyDirections;
 
 };
 
@@ -36,13 +70,26 @@ struct RabbitMovements {
 
     int emptyMovements;
 
-    MoveDirection *emptyDirections;
+    unsigned char emptyDirections;
 
 };
 
-Move *getMoveDirection(MoveDirection direction);
+static inline const Move *getMoveDirection(MoveDirection direction) {
+    return &MOVE_DELTAS[ direction ];
+}
 
-struct DefaultMovements calculateValidMovements(int row, int col, InputData *worldData, WorldSlot *world);
+//The direction an animal with the given (non empty) options takes, selector is genNumber + row + col
+static inline MoveDirection chooseMoveDirection(unsigned char directions, int selector) {
+    return (MoveDirection) MOVE_SELECTION[ directions ][ selector % MOVE_SELECTORS ];
+}
+
+/**
+ * Fill the topology of the world (see InputData) from its rock plane, which must already be set
+ */
+void calculateWorldTopology(InputData *worldData, WorldSlot *world);
+
+//The same for the rows startRow to endRow, the rock plane of the rows next to them must be set as well
+void calculateTopologyRows(InputData *worldData, WorldSlot *world, int startRow, int endRow);
 
 struct FoxMovements *createFoxMovementContext();
 
@@ -52,10 +99,6 @@ void analyzeFoxMovementOptions(int row, int col, InputData *worldData, WorldSlot
 
 void analyzeRabbitMovementOptions(int row, int col, InputData *worldData, WorldSlot *world, struct RabbitMovements *result);
 
-void releaseMovementDirections(MoveDirection *directions);
-
-void releaseDefaultMovements(struct DefaultMovements *movements);
-
 void destroyFoxMovementContext(struct FoxMovements *context);
 
 void destroyRabbitMovementContext(struct RabbitMovements *context);
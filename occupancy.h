@@ -0,0 +1,91 @@
+#ifndef TRABALHO_2_OCCUPANCY_H
+#define TRABALHO_2_OCCUPANCY_H
+
+#include <stdint.h>
+#include "rabbitsandfoxes.h"
+
+/*
+ * Occupancy bitmaps of a world buffer: bit col % 64 of word col / 64 of a row of the occupancy plane is set when the
+ * slot holds a rabbit or a fox, and the same bit of the fox plane when it holds a fox. Every row starts on a new
+ * word, so a phase can skip the empty stretches of its rows a word at a time and only visit the occupied slots.
+ * The rock plane never changes after the world is loaded (see bitboard.h for what the planes are used for).
+ *
+ * The planes live right after the slots, in the same allocation (see initializeWorldMatrix), so they follow the
+ * buffer around. Tiles can share a word with the tiles next to them, so while the world is split in tiles the bits
+ * of the buffer being written are only changed with atomic operations. Bands of whole rows never share a word.
+ */
+
+#define OCCUPANCY_WORDS(columns) (((columns) + 63) / 64)
+
+//Occupancy, fox and rock planes
+#define OCCUPANCY_PLANES 3
+
+//Bytes a world buffer needs for its slots and its bitmaps
+#define WORLD_MATRIX_SIZE(rows, columns) \
+    ((size_t) (rows) * (columns) * sizeof(WorldSlot) + \
+     (size_t) OCCUPANCY_PLANES * (rows) * OCCUPANCY_WORDS(columns) * sizeof(uint64_t))
+
+static inline uint64_t *occupancyPlaneRow(InputData *data, WorldSlot *world, int plane, int row) {
+    uint64_t *bitmap = (uint64_t *) &world[ (size_t) data->rows * data->columns ];
+
+    return &bitmap[ ((size_t) plane * data->rows + row) * OCCUPANCY_WORDS(data->columns) ];
+}
+
+static inline uint64_t *occupancyRow(InputData *data, WorldSlot *world, int row) {
+    return occupancyPlaneRow(data, world, 0, row);
+}
+
+static inline uint64_t *foxRow(InputData *data, WorldSlot *world, int row) {
+    return occupancyPlaneRow(data, world, 1, row);
+}
+
+static inline uint64_t *rockRow(InputData *data, WorldSlot *world, int row) {
+    return occupancyPlaneRow(data, world, 2, row);
+}
+
+static inline void setBit(uint64_t *word, uint64_t bit, int shared) {
+    if (shared) {
+        __atomic_fetch_or(word, bit, __ATOMIC_RELAXED);
+    } else {
+        *word |= bit;
+    }
+}
+
+static inline void clearBit(uint64_t *word, uint64_t bit, int shared) {
+    if (shared) {
+        __atomic_fetch_and(word, ~bit, __ATOMIC_RELAXED);
+    } else {
+        *word &= ~bit;
+    }
+}
+
+//An entity with the given content now holds the slot. shared must be set when other threads might be changing
+//the other bits of the word at the same time
+static inline void markOccupied(InputData *data, WorldSlot *world, int row, int col, SlotContent content, int shared) {
+    uint64_t bit = 1ULL << (col % 64);
+
+    setBit(&occupancyRow(data, world, row)[ col / 64 ], bit, shared);
+
+    if (content == FOX) {
+        setBit(&foxRow(data, world, row)[ col / 64 ], bit, shared);
+    }
+}
+
+static inline void markEmpty(InputData *data, WorldSlot *world, int row, int col, int shared) {
+    uint64_t bit = 1ULL << (col % 64);
+
+    clearBit(&occupancyRow(data, world, row)[ col / 64 ], bit, shared);
+    clearBit(&foxRow(data, world, row)[ col / 64 ], bit, shared);
+}
+
+//The bits of a word that fall in [startCol, endCol]
+static inline uint64_t occupancyMask(int word, int startCol, int endCol) {
+    uint64_t mask = ~0ULL;
+
+    if (word == startCol / 64) mask &= ~0ULL << (startCol % 64);
+    if (word == endCol / 64) mask &= ~0ULL >> (63 - endCol % 64);
+
+    return mask;
+}
+
+#endif //TRABALHO_2_OCCUPANCY_H
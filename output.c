@@ -2,70 +2,112 @@
 #include "entities.h"
 #include "matrix_utils.h"
 #include "movements.h"
+#include "occupancy.h"
+#include "reader.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <limits.h>
 
-#define MAX_NAME_LENGTH 6
-
-void calculateEntityDistribution(InputData* inputData, WorldSlot* world) {
-    int totalEntitiesProcessed = 0;
+int countRowEntities(InputData* inputData, WorldSlot* world, int startRow, int endRow) {
     int totalRocks = 0;
 
-    for (int row = 0; row < inputData->rows; row++) {
+    for (int row = startRow; row <= endRow; row++) {
         int entitiesInCurrentRow = 0;
 
         for (int col = 0; col < inputData->columns; col++) {
             WorldSlot* currentSlot = &world[PROJECT(inputData->columns, row, col)];
 
-            struct DefaultMovements movementOptions = calculateValidMovements(row, col, inputData, world);
-            currentSlot->defaultP = movementOptions.movementCount;
-            currentSlot->defaultPossibleMoveDirections = movementOptions.directions;
-
             SlotContent slotType = currentSlot->slotContent;
             if (slotType == RABBIT || slotType == FOX) {
-                totalEntitiesProcessed++;
                 entitiesInCurrentRow++;
+
+                markOccupied(inputData, world, row, col, slotType, 0);
             }
             else if (slotType == ROCK) {
                 totalRocks++;
+
+                rockRow(inputData, world, row)[ col / 64 ] |= 1ULL << (col % 64);
             }
         }
 
         inputData->entitiesPerRow[row] = entitiesInCurrentRow;
+    }
+
+    return totalRocks;
+}
+
+void calculateEntityDistribution(InputData* inputData, WorldSlot* world) {
+    inputData->rocks = countRowEntities(inputData, world, 0, inputData->rows - 1);
+
+    int totalEntitiesProcessed = 0;
+
+    for (int row = 0; row < inputData->rows; row++) {
+        totalEntitiesProcessed += inputData->entitiesPerRow[row];
+
         inputData->entitiesAccumulatedPerRow[row] = totalEntitiesProcessed;
     }
 
-    inputData->rocks = totalRocks;
+    calculateWorldTopology(inputData, world);
 }
 
-InputData* parseSimulationParameters(FILE* file) {
+InputData* parseSimulationParameters(InputReader* reader) {
+    InputData parameters;
+
+    startParsing(reader);
+
+    // Parse reproduction parameters
+    parameters.gen_proc_rabbits = readInteger(reader);
+    parameters.gen_proc_foxes = readInteger(reader);
+    parameters.gen_food_foxes = readInteger(reader);
+    
+    // Parse simulation dimensions
+    parameters.n_gen = readInteger(reader);
+    parameters.rows = readInteger(reader);
+    parameters.columns = readInteger(reader);
+    parameters.initialPopulation = readInteger(reader);
+
+    stopParsing(reader);
+
+    return createSimulationData(&parameters);
+}
+
+InputData* createSimulationData(const InputData* parameters) {
     InputData* simulationConfig = malloc(sizeof(InputData));
     
     if (simulationConfig == NULL) {
         return NULL;
     }
 
-    // Parse reproduction parameters
-    fscanf(file, "%d", &simulationConfig->gen_proc_rabbits);
-    fscanf(file, "%d", &simulationConfig->gen_proc_foxes);
-    fscanf(file, "%d", &simulationConfig->gen_food_foxes);
-    
-    // Parse simulation dimensions
-    fscanf(file, "%d", &simulationConfig->n_gen);
-    fscanf(file, "%d", &simulationConfig->rows);
-    fscanf(file, "%d", &simulationConfig->columns);
-    fscanf(file, "%d", &simulationConfig->initialPopulation);
+    simulationConfig->gen_proc_rabbits = parameters->gen_proc_rabbits;
+    simulationConfig->gen_proc_foxes = parameters->gen_proc_foxes;
+    simulationConfig->gen_food_foxes = parameters->gen_food_foxes;
+    simulationConfig->n_gen = parameters->n_gen;
+    simulationConfig->rows = parameters->rows;
+    simulationConfig->columns = parameters->columns;
+    simulationConfig->initialPopulation = parameters->initialPopulation;
+    simulationConfig->firstGeneration = 0;
+
+    // Fox counters are stored in 16 bits inside the world slots (see FoxInfo)
+    if (simulationConfig->gen_proc_foxes + simulationConfig->gen_food_foxes > USHRT_MAX) {
+        fprintf(stderr, "ERROR: Fox generation limits (%d + %d) cannot exceed %d\n",
+                simulationConfig->gen_proc_foxes, simulationConfig->gen_food_foxes, USHRT_MAX);
+        exit(EXIT_FAILURE);
+    }
 
     // Allocate memory for entity tracking arrays
     size_t rowArraySize = sizeof(int) * simulationConfig->rows;
     simulationConfig->entitiesAccumulatedPerRow = malloc(rowArraySize);
     simulationConfig->entitiesPerRow = malloc(rowArraySize);
+
+    // One byte per slot for the moves the rocks and the edges of the world allow
+    simulationConfig->topology = malloc((size_t) simulationConfig->rows * simulationConfig->columns);
     
     if (simulationConfig->entitiesAccumulatedPerRow == NULL || 
-        simulationConfig->entitiesPerRow == NULL) {
+        simulationConfig->entitiesPerRow == NULL || simulationConfig->topology == NULL) {
         free(simulationConfig->entitiesAccumulatedPerRow);
         free(simulationConfig->entitiesPerRow);
+        free(simulationConfig->topology);
         free(simulationConfig);
         return NULL;
     }
@@ -74,30 +116,47 @@ InputData* parseSimulationParameters(FILE* file) {
 }
 
 WorldSlot* initializeWorldMatrix(InputData* data) {
-    WorldSlot* worldMatrix = (WorldSlot*)initMatrix(data->rows, data->columns, sizeof(WorldSlot));
+    //The occupancy bitmap of the world is stored after its slots (see occupancy.h)
+    WorldSlot* worldMatrix = (WorldSlot*)calloc(1, WORLD_MATRIX_SIZE(data->rows, data->columns));
     return worldMatrix;
 }
 
-static SlotContent parseEntityType(const char* entityName) {
-    if (strcmp("ROCK", entityName) == 0) {
-        return ROCK;
-    }
-    else if (strcmp("FOX", entityName) == 0) {
-        return FOX;
+void copyWorldMatrix(InputData* data, WorldSlot* sourceWorld, WorldSlot* destinationWorld) {
+    memcpy(destinationWorld, sourceWorld, WORLD_MATRIX_SIZE(data->rows, data->columns));
+}
+
+void copyWorldRows(InputData* data, WorldSlot* sourceWorld, WorldSlot* destinationWorld, int startRow, int endRow) {
+    size_t rowSlots = (size_t) (endRow - startRow + 1) * data->columns;
+
+    memcpy(&destinationWorld[PROJECT(data->columns, startRow, 0)], &sourceWorld[PROJECT(data->columns, startRow, 0)],
+           rowSlots * sizeof(WorldSlot));
+
+    // The rows of every plane are contiguous
+    size_t rowWords = (size_t) (endRow - startRow + 1) * OCCUPANCY_WORDS(data->columns);
+
+    for (int plane = 0; plane < OCCUPANCY_PLANES; plane++) {
+        memcpy(occupancyPlaneRow(data, destinationWorld, plane, startRow),
+               occupancyPlaneRow(data, sourceWorld, plane, startRow), rowWords * sizeof(uint64_t));
     }
-    else if (strcmp("RABBIT", entityName) == 0) {
-        return RABBIT;
+}
+
+void checkEntityPosition(InputData* simulationData, int row, int column) {
+    if (row < 0 || row >= simulationData->rows || column < 0 || column >= simulationData->columns) {
+        fprintf(stderr, "ERROR: Entity at %d %d is outside the %dx%d world\n", row, column, simulationData->rows,
+                simulationData->columns);
+        exit(EXIT_FAILURE);
     }
-    return EMPTY;
 }
 
-static void initializeEntityInfo(WorldSlot* slot) {
+void placeWorldEntity(WorldSlot* slot, SlotContent content) {
+    slot->slotContent = content;
+
     switch (slot->slotContent) {
         case FOX:
-            slot->entityInfo.foxInfo = createFoxEntity();
+            placeFoxEntity(slot);
             break;
         case RABBIT:
-            slot->entityInfo.rabbitInfo = createRabbitEntity();
+            placeRabbitEntity(slot);
             break;
         case ROCK:
         case EMPTY:
@@ -106,29 +165,32 @@ static void initializeEntityInfo(WorldSlot* slot) {
     }
 }
 
-void loadWorldEntities(FILE* file, InputData* simulationData, WorldSlot* world) {
+void loadWorldEntities(InputReader* reader, InputData* simulationData, WorldSlot* world) {
     printf("Initial population: %d\n", simulationData->initialPopulation);
 
+    readWorldEntities(reader, simulationData, world);
+}
+
+void readWorldEntities(InputReader* reader, InputData* simulationData, WorldSlot* world) {
+    startParsing(reader);
+
     for (int entityIndex = 0; entityIndex < simulationData->initialPopulation; entityIndex++) {
-        char entityName[MAX_NAME_LENGTH + 1];
-        int row, column;
-        
-        // Clear the entity name buffer
-        memset(entityName, 0, sizeof(entityName));
-        
-        // Read entity data from file
-        fscanf(file, "%s", entityName);
-        fscanf(file, "%d", &row);
-        fscanf(file, "%d", &column);
+        // Read entity data from the input
+        SlotContent entityType = readEntityType(reader);
+        int row = readInteger(reader);
+        int column = readInteger(reader);
+
+        checkEntityPosition(simulationData, row, column);
 
         // Get the target world slot
         WorldSlot* targetSlot = &world[PROJECT(simulationData->columns, row, column)];
         
         // Set entity type and initialize entity-specific information
-        targetSlot->slotContent = parseEntityType(entityName);
-        initializeEntityInfo(targetSlot);
+        placeWorldEntity(targetSlot, entityType);
     }
 
+    stopParsing(reader);
+
     // Calculate entity distribution across the world
     calculateEntityDistribution(simulationData, world);
 }
\ No newline at end of file
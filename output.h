@@ -3,12 +3,27 @@
 
 #include "rabbitsandfoxes.h"
 #include <stdio.h>
+#include "reader.h"
 
 // Input functions
-InputData* parseSimulationParameters(FILE* file);
+InputData* parseSimulationParameters(InputReader* reader);
+// Allocate the data of a world with the parameters (the fields up to initialPopulation) of the given one
+InputData* createSimulationData(const InputData* parameters);
 WorldSlot* initializeWorldMatrix(InputData* data);
-void loadWorldEntities(FILE* file, InputData* simulationData, WorldSlot* world);
+// Copy the slots and the occupancy bitmap of a world, the back buffer has to start as a copy of the world
+void copyWorldMatrix(InputData* data, WorldSlot* sourceWorld, WorldSlot* destinationWorld);
+// Copy the slots and the bitmaps of the rows startRow to endRow of a world
+void copyWorldRows(InputData* data, WorldSlot* sourceWorld, WorldSlot* destinationWorld, int startRow, int endRow);
+void loadWorldEntities(InputReader* reader, InputData* simulationData, WorldSlot* world);
+// Same as loadWorldEntities, without writing the initial population to stdout
+void readWorldEntities(InputReader* reader, InputData* simulationData, WorldSlot* world);
+// Exits when an entity read from the input is outside the world
+void checkEntityPosition(InputData* simulationData, int row, int column);
+// Put a new entity of the given content in a slot
+void placeWorldEntity(WorldSlot* slot, SlotContent content);
 void calculateEntityDistribution(InputData* inputData, WorldSlot* world);
+// Set the entity counts (but not the accumulated ones) and the bitmaps of the rows startRow to endRow, returns the rocks
+int countRowEntities(InputData* inputData, WorldSlot* world, int startRow, int endRow);
 
 // Output functions  
 void outputSimulationResults(FILE* outputFile, InputData* simulationData, WorldSlot* worldMatrix);
@@ -0,0 +1,381 @@
+#define _GNU_SOURCE
+
+#include "placement.h"
+#include "occupancy.h"
+#include <errno.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+//Pages whose node is asked for in every move_pages call
+#define QUERIED_PAGES 1024
+
+struct ThreadPlacement_ {
+
+    PinMode pinMode;
+
+    int threadCount, nodeCount;
+
+    //Number of every node in the system, and the cores of it we may run on
+    int *nodeIds;
+
+    cpu_set_t *nodeCpus;
+
+    //The first thread of every node, nodeCount + 1 entries
+    int *nodeFirstThreads;
+
+    //PIN_CORES: the core of every thread
+    int *threadCpus;
+
+    //Set once a thread could not be pinned, so we only warn once
+    int pinFailed;
+
+};
+
+//Read a list like "0-3,8,10-11" into a set. 0 when the list can't be read
+static int readCpuList(const char *path, cpu_set_t *set) {
+    CPU_ZERO(set);
+
+    FILE *file = fopen(path, "r");
+
+    if (file == NULL) {
+        return 0;
+    }
+
+    char line[4096];
+
+    int read = fgets(line, sizeof(line), file) != NULL;
+
+    fclose(file);
+
+    if (!read) {
+        return 0;
+    }
+
+    char *position = line;
+
+    while (*position != '\0' && *position != '\n') {
+        char *end;
+
+        long first = strtol(position, &end, 10), last = first;
+
+        if (end == position) {
+            return 0;
+        }
+
+        if (*end == '-') {
+            position = end + 1;
+            last = strtol(position, &end, 10);
+        }
+
+        for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET((int) cpu, set);
+        }
+
+        position = *end == ',' ? end + 1 : end;
+    }
+
+    return 1;
+}
+
+//Write a set the way the kernel lists it, "0-3,8"
+static void formatCpuList(cpu_set_t *set, char *buffer, size_t size) {
+    size_t length = 0;
+
+    buffer[0] = '\0';
+
+    for (int cpu = 0; cpu < CPU_SETSIZE && length < size; cpu++) {
+        if (!CPU_ISSET(cpu, set) || (cpu > 0 && CPU_ISSET(cpu - 1, set))) {
+            continue;
+        }
+
+        int last = cpu;
+
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, set)) {
+            last++;
+        }
+
+        if (last == cpu) {
+            length += snprintf(&buffer[length], size - length, "%s%d", length > 0 ? "," : "", cpu);
+        } else {
+            length += snprintf(&buffer[length], size - length, "%s%d-%d", length > 0 ? "," : "", cpu, last);
+        }
+    }
+}
+
+//The nodes with cores we may run on. Without the nodes in sysfs every core is on node 0
+static void findPlacementNodes(ThreadPlacement *placement) {
+    cpu_set_t allowed, online;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        fprintf(stderr, "ERROR: Failed to read the cores we may run on\n");
+        exit(EXIT_FAILURE);
+    }
+
+    placement->nodeCount = 0;
+
+    if (readCpuList("/sys/devices/system/node/online", &online)) {
+        int onlineCount = CPU_COUNT(&online);
+
+        placement->nodeIds = malloc(sizeof(int) * onlineCount);
+        placement->nodeCpus = malloc(sizeof(cpu_set_t) * onlineCount);
+
+        for (int node = 0; node < CPU_SETSIZE; node++) {
+            if (!CPU_ISSET(node, &online)) {
+                continue;
+            }
+
+            char path[64];
+
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+
+            cpu_set_t *cpus = &placement->nodeCpus[ placement->nodeCount ];
+
+            if (!readCpuList(path, cpus)) {
+                continue;
+            }
+
+            CPU_AND(cpus, cpus, &allowed);
+
+            //Nodes with memory only, or with none of our cores
+            if (CPU_COUNT(cpus) > 0) {
+                placement->nodeIds[ placement->nodeCount++ ] = node;
+            }
+        }
+    }
+
+    if (placement->nodeCount == 0) {
+        free(placement->nodeIds);
+        free(placement->nodeCpus);
+
+        placement->nodeCount = 1;
+        placement->nodeIds = malloc(sizeof(int));
+        placement->nodeCpus = malloc(sizeof(cpu_set_t));
+
+        placement->nodeIds[ 0 ] = 0;
+        placement->nodeCpus[ 0 ] = allowed;
+    }
+}
+
+//The nth core of a set
+static int nthCpu(cpu_set_t *set, int n) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, set) && n-- == 0) {
+            return cpu;
+        }
+    }
+
+    return -1;
+}
+
+ThreadPlacement *createThreadPlacement(PinMode pinMode, int threadCount) {
+    ThreadPlacement *placement = malloc(sizeof(ThreadPlacement));
+
+    placement->pinMode = pinMode;
+    placement->threadCount = threadCount;
+    placement->pinFailed = 0;
+    placement->nodeIds = NULL;
+    placement->nodeCpus = NULL;
+
+    findPlacementNodes(placement);
+
+    int totalCpus = 0;
+
+    for (int node = 0; node < placement->nodeCount; node++) {
+        totalCpus += CPU_COUNT(&placement->nodeCpus[ node ]);
+    }
+
+    //Contiguous blocks of threads, as many as the node has of the cores
+    placement->nodeFirstThreads = malloc(sizeof(int) * (placement->nodeCount + 1));
+
+    int cpusBefore = 0;
+
+    for (int node = 0; node < placement->nodeCount; node++) {
+        placement->nodeFirstThreads[ node ] = (int) ((long) threadCount * cpusBefore / totalCpus);
+
+        cpusBefore += CPU_COUNT(&placement->nodeCpus[ node ]);
+    }
+
+    placement->nodeFirstThreads[ placement->nodeCount ] = threadCount;
+
+    placement->threadCpus = malloc(sizeof(int) * threadCount);
+
+    for (int node = 0; node < placement->nodeCount; node++) {
+        int cpus = CPU_COUNT(&placement->nodeCpus[ node ]);
+
+        for (int thread = placement->nodeFirstThreads[ node ]; thread < placement->nodeFirstThreads[ node + 1 ];
+             thread++) {
+            placement->threadCpus[ thread ] = nthCpu(&placement->nodeCpus[ node ],
+                                                     (thread - placement->nodeFirstThreads[ node ]) % cpus);
+        }
+    }
+
+    return placement;
+}
+
+static int nodeOfThread(ThreadPlacement *placement, int thread) {
+    int node = 0;
+
+    while (node < placement->nodeCount - 1 && thread >= placement->nodeFirstThreads[ node + 1 ]) {
+        node++;
+    }
+
+    return node;
+}
+
+void pinPlacedThread(ThreadPlacement *placement, int thread, pthread_t handle) {
+    if (placement->pinMode == PIN_NONE) {
+        return;
+    }
+
+    cpu_set_t cpus;
+
+    if (placement->pinMode == PIN_CORES) {
+        CPU_ZERO(&cpus);
+        CPU_SET(placement->threadCpus[ thread ], &cpus);
+    } else {
+        cpus = placement->nodeCpus[ nodeOfThread(placement, thread) ];
+    }
+
+    int error = pthread_setaffinity_np(handle, sizeof(cpus), &cpus);
+
+    if (error != 0 && !placement->pinFailed) {
+        placement->pinFailed = 1;
+
+        fprintf(stderr, "WARNING: Failed to pin thread %d (%s), it runs wherever the scheduler puts it\n", thread,
+                strerror(error));
+    }
+}
+
+int getPlacementNodeCount(ThreadPlacement *placement) {
+    return placement->nodeCount;
+}
+
+const int *getPlacementNodeThreads(ThreadPlacement *placement) {
+    return placement->nodeFirstThreads;
+}
+
+/*
+ * Count the pages of a buffer on every node of the placement. pagesPerNode has nodeCount + 2 entries, the pages on
+ * nodes we don't run on and the ones nobody touched yet go in the last two. 0 when the kernel can't tell us (no
+ * NUMA support), with errno set
+ */
+static int countBufferPages(ThreadPlacement *placement, void *buffer, size_t size, long *pagesPerNode) {
+    memset(pagesPerNode, 0, sizeof(long) * (placement->nodeCount + 2));
+
+#ifdef SYS_move_pages
+    size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+
+    uintptr_t first = (uintptr_t) buffer & ~(pageSize - 1), end = (uintptr_t) buffer + size;
+
+    void *pages[QUERIED_PAGES];
+
+    int status[QUERIED_PAGES];
+
+    for (uintptr_t page = first; page < end;) {
+        unsigned long count = 0;
+
+        for (; count < QUERIED_PAGES && page < end; count++, page += pageSize) {
+            pages[ count ] = (void *) page;
+        }
+
+        //Without nodes to move to, move_pages only tells where the pages are
+        if (syscall(SYS_move_pages, 0, count, pages, NULL, status, 0) != 0) {
+            return 0;
+        }
+
+        for (unsigned long queried = 0; queried < count; queried++) {
+            int node = placement->nodeCount;
+
+            if (status[ queried ] == -ENOENT) {
+                node = placement->nodeCount + 1;
+            } else {
+                for (int known = 0; known < placement->nodeCount; known++) {
+                    if (placement->nodeIds[ known ] == status[ queried ]) {
+                        node = known;
+                    }
+                }
+            }
+
+            pagesPerNode[ node ]++;
+        }
+    }
+
+    return 1;
+#else
+    errno = ENOSYS;
+
+    return 0;
+#endif
+}
+
+void reportWorldPlacement(FILE *file, ThreadPlacement *placement, InputData *simulationData, int threads,
+                          WorldSlot *world, WorldSlot *backWorld) {
+
+    static const char *const PIN_MODE_NAMES[] = {[PIN_NONE] = "not pinned", [PIN_CORES] = "pinned to cores",
+            [PIN_NODES] = "pinned to nodes"};
+
+    size_t size = WORLD_MATRIX_SIZE(simulationData->rows, simulationData->columns);
+
+    long *worldPages = malloc(sizeof(long) * (placement->nodeCount + 2)),
+            *backPages = malloc(sizeof(long) * (placement->nodeCount + 2));
+
+    int counted = countBufferPages(placement, world, size, worldPages) &&
+                  countBufferPages(placement, backWorld, size, backPages);
+
+    int error = errno;
+
+    fprintf(file, "Placement of %d threads on %d nodes (%s)\n", threads, placement->nodeCount,
+            PIN_MODE_NAMES[ placement->pinMode ]);
+
+    for (int node = 0; node < placement->nodeCount; node++) {
+        //The threads of the simulation are the first threads of the placement
+        int firstThread = placement->nodeFirstThreads[ node ], endThread = placement->nodeFirstThreads[ node + 1 ];
+
+        firstThread = firstThread < threads ? firstThread : threads;
+        endThread = endThread < threads ? endThread : threads;
+
+        char cpus[256];
+
+        formatCpuList(&placement->nodeCpus[ node ], cpus, sizeof(cpus));
+
+        fprintf(file, "  node %d (cpus %s): ", placement->nodeIds[ node ], cpus);
+
+        if (firstThread == endThread) {
+            fprintf(file, "no threads");
+        } else {
+            fprintf(file, "threads %d-%d, rows %d-%d", firstThread, endThread - 1,
+                    (int) ((long) firstThread * simulationData->rows / threads),
+                    (int) ((long) endThread * simulationData->rows / threads) - 1);
+        }
+
+        if (counted) {
+            fprintf(file, ", pages of the world %ld, of the back buffer %ld", worldPages[ node ], backPages[ node ]);
+        }
+
+        fprintf(file, "\n");
+    }
+
+    if (counted) {
+        fprintf(file, "  pages on other nodes: world %ld, back buffer %ld; not touched yet: world %ld, "
+                      "back buffer %ld\n",
+                worldPages[ placement->nodeCount ], backPages[ placement->nodeCount ],
+                worldPages[ placement->nodeCount + 1 ], backPages[ placement->nodeCount + 1 ]);
+    } else {
+        fprintf(file, "  the nodes of the pages can't be queried (%s)\n", strerror(error));
+    }
+
+    free(worldPages);
+    free(backPages);
+}
+
+void destroyThreadPlacement(ThreadPlacement *placement) {
+    free(placement->nodeIds);
+    free(placement->nodeCpus);
+    free(placement->nodeFirstThreads);
+    free(placement->threadCpus);
+    free(placement);
+}
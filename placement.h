@@ -0,0 +1,63 @@
+#ifndef TRABALHO_2_PLACEMENT_H
+#define TRABALHO_2_PLACEMENT_H
+
+#include <pthread.h>
+#include <stdio.h>
+#include "rabbitsandfoxes.h"
+
+/*
+ * Placement of the workers of an engine on the cores and NUMA nodes of the machine (--pin).
+ *
+ * The threads are handed out to the nodes in contiguous blocks, in proportion to the cores we may run on in every
+ * node, so the bands of rows next to each other (which share their edge rows) are on the same node, and only the
+ * bands at the edges of a block talk to another node. Every worker first touches the rows of its band of the world
+ * buffers (the even split of the rows between the threads), so the pages of a band are on the node of its thread,
+ * and the rows stay with the node: the bands are only rebalanced between the threads of the same node
+ * (see setThreadRowGroups).
+ *
+ * The nodes are read from /sys/devices/system/node. Without it, or on a machine with a single node, every thread is
+ * on node 0 and only the pinning changes.
+ */
+
+typedef enum PinMode_ {
+
+    //The workers run wherever the scheduler puts them
+    PIN_NONE,
+
+    //Every worker is pinned to a core of its node, round robin when there are more workers than cores
+    PIN_CORES,
+
+    //Every worker may run on any core of its node
+    PIN_NODES
+
+} PinMode;
+
+typedef struct ThreadPlacement_ ThreadPlacement;
+
+/**
+ * Find the nodes and cores we may run on and hand them out to threadCount threads
+ */
+ThreadPlacement *createThreadPlacement(PinMode pinMode, int threadCount);
+
+/**
+ * Pin a thread, by its number in the placement. Warns (once) when the thread can't be pinned
+ */
+void pinPlacedThread(ThreadPlacement *placement, int thread, pthread_t handle);
+
+int getPlacementNodeCount(ThreadPlacement *placement);
+
+/**
+ * The first thread of every node, and the number of threads after the last node (nodeCount + 1 entries)
+ */
+const int *getPlacementNodeThreads(ThreadPlacement *placement);
+
+/**
+ * Write where the threads run and on which node the pages of the world buffers are, for a simulation with the given
+ * number of threads (the first threads of the placement)
+ */
+void reportWorldPlacement(FILE *file, ThreadPlacement *placement, InputData *simulationData, int threads,
+                          WorldSlot *world, WorldSlot *backWorld);
+
+void destroyThreadPlacement(ThreadPlacement *placement);
+
+#endif //TRABALHO_2_PLACEMENT_H
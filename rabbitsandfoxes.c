@@ -6,206 +6,264 @@
 #include <string.h>
 #include "movements.h"
 #include "threads.h"
-#include <sys/time.h>
+#include "engine.h"
+#include "occupancy.h"
+#include "bitboard.h"
+#include "writer.h"
+#include "snapshot.h"
+#include "checkpoint.h"
+#include "timers.h"
 
 #define MAX_NAME_LENGTH 6
-#define PRINT_ALL_GEN 0
-
-struct InitialInputData {
-    int threadNumber;
-
-    InputData* simulationData;
-
-    WorldSlot* world;
-
-    struct ThreadedData* threadedData;
-
-    ThreadRowData* threadRowData;
-
-    int printOutput;
-};
 
+//Entities in a word of the occupancy bitmap past which prepareBackRow copies the whole word instead of each entity
+#define DENSE_WORD_SLOTS 16
 
 void displayGenerationState(FILE*, InputData*, WorldSlot*);
 
-void executeSequentialGeneration(int genNumber, InputData* simulationData, WorldSlot* world);
-
 
-static void
-copyWorldRegionToBuffer(int threadNumber, InputData* simulationData, struct ThreadedData* threadedData, WorldSlot* sourceWorld,
-    WorldSlot* destinationBuffer,
-    int copyStartRow, int copyEndRow) {
+/*
+ * The world is double buffered. Each phase reads the front buffer, which is never modified during
+ * that phase (so every thread can read the rows of its neighbours directly, no snapshot copy is needed),
+ * and writes the back buffer. The rabbit phase goes from world to backWorld and the fox phase back
+ * from backWorld to world, so at the end of a generation the state is always in world.
+ *
+ * Before the entities of a row are moved, the row of the back buffer has to hold everything that does not
+ * move in this phase. We carry the row over: entities only ever move into slots that are empty in
+ * the front buffer, and the turn of every moving entity rewrites its own slot (empty, newborn or the entity
+ * itself when it can't move), so the stale copies are replaced before anything can look at them.
+ *
+ * Rocks never move and both buffers start as copies of each other, so only the entities have to be carried
+ * over. The occupancy bitmaps tell us which slots of the back buffer still hold the entities of two phases ago
+ * and which slots of the front buffer hold an entity now, so the cost of a row is its words and its entities,
+ * not its slots.
+ */
+static void prepareBackRow(InputData* simulationData, WorldSlot* frontWorld, WorldSlot* backWorld, int row,
+    int startCol, int endCol, int shared) {
 
-    //    pthread_barrier_wait(&threadedData->barrier);
+    uint64_t* frontBits = occupancyRow(simulationData, frontWorld, row),
+        * backBits = occupancyRow(simulationData, backWorld, row);
 
-        //synchronizeWithAdjacentThreads(threadNumber, simulationData, threadedData);
+    uint64_t* frontFoxes = foxRow(simulationData, frontWorld, row),
+        * backFoxes = foxRow(simulationData, backWorld, row);
 
-    int rowCount = (copyEndRow - copyStartRow) + 1;
+    WorldSlot* frontRow = &frontWorld[ PROJECT(simulationData->columns, row, 0) ],
+        * backRow = &backWorld[ PROJECT(simulationData->columns, row, 0) ];
 
-    memcpy(destinationBuffer, &sourceWorld[ PROJECT(simulationData->columns, copyStartRow, 0) ],
-        (rowCount * simulationData->columns * sizeof(WorldSlot)));
+    for (int word = startCol / 64; word <= endCol / 64; word++) {
 
-    if (threadedData != NULL) {
-        //wait for surrounding threads to also complete their copy to allow changes to the tray
-        pthread_barrier_wait(&threadedData->barrier);
-    }
-}
+        uint64_t mask = occupancyMask(word, startCol, endCol);
 
+        uint64_t occupied = frontBits[ word ] & mask,
+            stale = __atomic_load_n(&backBits[ word ], __ATOMIC_RELAXED) & mask & ~occupied;
 
+        uint64_t foxes = frontFoxes[ word ] & mask;
 
-void runSequentialSimulation(FILE* inputFile, FILE* outputFile) {
+        if (__builtin_popcountll(occupied | stale) > DENSE_WORD_SLOTS) {
+            //Crowded stretch, copying it whole is cheaper than going slot by slot (the slots without entities are
+            //the same in both buffers or empty in the front one, so copying them is harmless)
+            int firstCol = word * 64 + __builtin_ctzll(mask), lastCol = word * 64 + 63 - __builtin_clzll(mask);
 
-    InputData* simulationData = parseSimulationParameters(inputFile);
+            memcpy(&backRow[ firstCol ], &frontRow[ firstCol ], (lastCol - firstCol + 1) * sizeof(WorldSlot));
+        }
+        else {
+            for (uint64_t bits = stale; bits != 0; bits &= bits - 1) {
+                backRow[ word * 64 + __builtin_ctzll(bits) ].slotContent = EMPTY;
+            }
 
-    simulationData->threads = 1;
+            for (uint64_t bits = occupied; bits != 0; bits &= bits - 1) {
+                int col = word * 64 + __builtin_ctzll(bits);
 
-    struct ThreadedData* threadedData = malloc(sizeof(struct ThreadedData));
+                backRow[ col ] = frontRow[ col ];
+            }
+        }
 
-    initializeThreadingSystem(simulationData->threads, simulationData, threadedData);
+        if (shared) {
+            //Other tiles might be changing the other bits of the words
+            uint64_t staleFoxes = __atomic_load_n(&backFoxes[ word ], __ATOMIC_RELAXED) & mask & ~foxes;
 
-    WorldSlot* world = initializeWorldMatrix(simulationData);
+            if (stale != 0) {
+                __atomic_fetch_and(&backBits[ word ], ~stale, __ATOMIC_RELAXED);
+            }
 
-    loadWorldEntities(inputFile, simulationData, world);
+            if (staleFoxes != 0) {
+                __atomic_fetch_and(&backFoxes[ word ], ~staleFoxes, __ATOMIC_RELAXED);
+            }
 
-    if (PRINT_ALL_GEN) {
-        outputFile = fopen("allgen.txt", "w");
+            __atomic_fetch_or(&backBits[ word ], occupied, __ATOMIC_RELAXED);
+            __atomic_fetch_or(&backFoxes[ word ], foxes, __ATOMIC_RELAXED);
+        }
+        else {
+            backBits[ word ] = (backBits[ word ] & ~mask) | occupied;
+            backFoxes[ word ] = (backFoxes[ word ] & ~mask) | foxes;
+        }
     }
+}
 
-    for (int gen = 0; gen < simulationData->n_gen; gen++) {
+//Count an entity that ends the phase in a slot of our region. Nothing is counted when the region has no counts,
+//which is the case for the tiles of the task scheduler (it does not rebalance)
+static inline void countEntity(struct ThreadConflictData* region, int row, int col) {
+    if (region->entitiesPerRow == NULL) return;
 
-        if (PRINT_ALL_GEN) {
-            fprintf(outputFile, "Generation %d\n", gen);
-            printf("Generation %d\n", gen);
-            displayGenerationState(outputFile, simulationData, world);
-            fprintf(outputFile, "\n");
-        }
+    region->entitiesPerRow[ row ]++;
 
-        executeSequentialGeneration(gen, simulationData, world);
+    if (region->entitiesPerColumn != NULL) {
+        region->entitiesPerColumn[ col ]++;
     }
+}
 
-    printf("RESULTS:\n");
+static int isOutsideRegion(struct ThreadConflictData* region, int row, int col) {
+    return row < region->startRow || row > region->endRow || col < region->startCol || col > region->endCol;
+}
 
-    outputSimulationResults(outputFile, simulationData, world);
-    fflush(outputFile);
-    deallocateWorldMatrix(simulationData, world);
+//Whether other regions can have slots in the same words of the occupancy bitmap as ours
+static int sharesOccupancyWords(struct ThreadConflictData* region) {
+    return region->startCol > 0 || region->endCol < region->inputData->columns - 1;
 }
 
-static void executeWorkerThread(struct InitialInputData* args) {
+//The neighbour masks the thread of the region classifies its rows with, NULL when it looks at the slots instead
+static NeighbourMasks* regionNeighbourMasks(struct ThreadConflictData* region) {
+    struct ThreadedData* threadedData = region->threadedData;
 
-    FILE* outputFile;
+    return threadedData->analysisMode == ANALYSIS_BITBOARD ? threadedData->neighbourMasksPerThread[ region->threadNum ] : NULL;
+}
 
-    if (args->threadNumber == 0 && args->printOutput) {
-        outputFile = fopen("allgen.txt", "w");
-    }
+/*
+ * Set up the region a thread works on in a phase, and where it counts its entities. With several threads every thread
+ * counts in its own arrays (see threadRowCounts)
+ */
+static void initializeThreadRegion(struct ThreadConflictData* region, int threadNumber, InputData* simulationData,
+    struct ThreadedData* threadedData, WorldSlot* backWorld, ThreadRowData* threadRows) {
+
+    region->threadNum = threadNumber;
+    region->startRow = threadRows->startRow;
+    region->endRow = threadRows->endRow;
+    region->startCol = threadRows->startCol;
+    region->endCol = threadRows->endCol;
+    region->inputData = simulationData;
+    region->world = backWorld;
+    region->threadedData = threadedData;
+
+    region->entitiesPerRow = threadRowCounts(threadNumber, simulationData, threadedData);
+    region->entitiesPerColumn = threadedData->partitionMode == PARTITION_TILES ?
+                                threadedData->entitiesPerColumnPerThread[ threadNumber ] : NULL;
+}
 
-    ThreadRowData* threadRowData = args->threadRowData;
+void runSequentialSimulation(FILE* inputFile, FILE* outputFile, AnalysisMode analysisMode, BitboardKernel bitboardKernel,
+                             const SnapshotOptions* snapshots) {
 
-    for (int gen = 0; gen < args->simulationData->n_gen; gen++) {
+    InputReader* reader = NULL;
 
-        if (args->printOutput) {
-            pthread_barrier_wait(&args->threadedData->barrier);
+    WorldSlot* world = NULL;
 
-            if (args->threadNumber == 0) {
-                fprintf(outputFile, "Generation %d\n", gen);
-                printf("Generation %d\n", gen);
-                displayGenerationState(outputFile, args->simulationData, args->world);
-                fprintf(outputFile, "\n");
-            }
+    InputData* simulationData;
 
-            pthread_barrier_wait(&args->threadedData->barrier);
-        }
+    if (snapshots->binaryInput) {
+        simulationData = readWorldSnapshot(inputFile, &world);
 
-        executeParallelGeneration(args->threadNumber, gen, args->simulationData,
-            args->threadedData, args->world, threadRowData);
-    }
+        printf("Initial population: %d\n", simulationData->initialPopulation);
+    } else {
+        reader = openInputReader(inputFile);
 
-    if (args->printOutput && args->threadNumber == 0) {
-        fflush(outputFile);
+        simulationData = parseSimulationParameters(reader);
     }
 
-}
-
-void runParallelSimulation(int threadCount, FILE* inputFile, FILE* outputFile) {
-
-    InputData* simulationData = parseSimulationParameters(inputFile);
-
-    simulationData->threads = threadCount;
+    simulationData->threads = 1;
 
     struct ThreadedData* threadedData = malloc(sizeof(struct ThreadedData));
 
     initializeThreadingSystem(simulationData->threads, simulationData, threadedData);
 
-    WorldSlot* world = initializeWorldMatrix(simulationData);
-
-    loadWorldEntities(inputFile, simulationData, world);
-
-    if (!validateThreadConfiguration(simulationData)) {
-        exit(1);
-    }
-
-    ThreadRowData* threadRowData = malloc(sizeof(ThreadRowData) * threadCount);
+    setThreadAnalysis(analysisMode, bitboardKernel, threadedData);
 
-    struct InitialInputData** simulationDataList = malloc(sizeof(struct InitialInputData*) * threadCount);
+    prepareThreadingSystem(simulationData->threads, simulationData, threadedData);
 
-    struct timeval start, end;
+    WorldSlot* backWorld = initializeWorldMatrix(simulationData);
 
-    gettimeofday(&start, NULL);
+    if (reader != NULL) {
+        world = initializeWorldMatrix(simulationData);
 
-    distributeWorkloadAcrossThreads(threadCount, threadRowData, simulationData);
+        loadWorldEntities(reader, simulationData, world);
 
-    for (int thread = 0; thread < threadCount; thread++) {
-
-        struct InitialInputData* threadInput = malloc(sizeof(struct InitialInputData));
+        if (PRINT_PARSE_THROUGHPUT) {
+            reportParseThroughput(stderr, reader);
+        }
 
-        threadInput->simulationData = simulationData;
-        threadInput->threadNumber = thread;
-        threadInput->world = world;
-        threadInput->threadedData = threadedData;
-        threadInput->printOutput = PRINT_ALL_GEN;
-        threadInput->threadRowData = threadRowData;
+        closeInputReader(reader);
+    }
 
-        simulationDataList[ thread ] = threadInput;
+    copyWorldMatrix(simulationData, world, backWorld);
 
-        printf("Initializing thread %d \n", thread);
+    CheckpointWriter* checkpoints = NULL;
 
-        pthread_create(&threadedData->threads[ thread ], NULL, (void* (*)(void*)) executeWorkerThread, threadInput);
-        //        executeThread(simulationData);
+    if (snapshots->checkpointInterval > 0) {
+        checkpoints = createCheckpointWriter(snapshots->checkpointPath, snapshots->checkpointInterval, simulationData);
     }
 
-    for (int thread = 0; thread < simulationData->threads; thread++) {
-        pthread_join(threadedData->threads[ thread ], NULL);
+    if (PRINT_ALL_GEN) {
+        outputFile = fopen("allgen.txt", "w");
     }
 
-    gettimeofday(&end, NULL);
+    for (int gen = simulationData->firstGeneration; gen < simulationData->n_gen; gen++) {
 
-    long seconds = (end.tv_sec - start.tv_sec);
-    long micros = ((seconds * 1000000) + end.tv_usec) - (start.tv_usec);
+        if (PRINT_ALL_GEN) {
+            fprintf(outputFile, "Generation %d\n", gen);
+            printf("Generation %d\n", gen);
+            displayGenerationState(outputFile, simulationData, world);
+            fprintf(outputFile, "\n");
+        }
+
+        executeSequentialGeneration(gen, simulationData, threadedData, world, backWorld);
 
-    for (int thread = 0; thread < simulationData->threads; thread++) {
-        free(simulationDataList[ thread ]);
+        if (checkpoints != NULL && isCheckpointDue(checkpoints, gen + 1)) {
+            takeCheckpoint(checkpoints, world, gen + 1);
+        }
     }
 
-    free(simulationDataList);
+    if (checkpoints != NULL) {
+        destroyCheckpointWriter(checkpoints);
+    }
 
     printf("RESULTS:\n");
 
     outputSimulationResults(outputFile, simulationData, world);
     fflush(outputFile);
-    printf("Took %ld microseconds\n", micros);
+
+    if (snapshots->outputPath != NULL) {
+        saveWorldSnapshot(snapshots->outputPath, simulationData, world, simulationData->n_gen);
+    }
+
+    freeMatrix((void**)&backWorld);
     deallocateWorldMatrix(simulationData, world);
-    destroyThreadingSystem(threadCount, threadedData);
+    destroyThreadingSystem(1, threadedData);
+}
+
+void runParallelSimulation(int threadCount, FILE* inputFile, FILE* outputFile) {
+
+    //A single simulation on an engine that is only used once
+    SimulationEngine* engine = createSimulationEngine(threadCount);
 
+    runEngineSimulation(engine, inputFile, outputFile);
+
+    destroySimulationEngine(engine);
 }
 
-static void processRabbitTurn(int genNumber, int threadStartRow, int threadEndRow, int currentRow, int currentCol, WorldSlot* currentSlot,
-    InputData* simulationData,
-    WorldSlot* world,
+static void processRabbitTurn(int genNumber, int currentRow, int currentCol, WorldSlot* currentSlot,
+    InputData* simulationData, struct ThreadConflictData* region,
     struct RabbitMovements* movementOptions, Conflicts* threadConflicts) {
 
-    RabbitInfo* rabbitInfo = currentSlot->entityInfo.rabbitInfo;
+    WorldSlot* world = region->world;
+
+    //Work on a copy of the rabbit, it gets copied into the slot it moves to
+    WorldSlot movingRabbit = *currentSlot;
+
+    RabbitInfo* rabbitInfo = &movingRabbit.entityInfo.rabbitInfo;
+
+    WorldSlot* realSlot = &world[ PROJECT(simulationData->columns, currentRow, currentCol) ];
 
-    //If there is no moves then the move is successful
-    int movementResult = 1, procriated = 0;
+    int procriated = 0, newRow = currentRow, newCol = currentCol;
+
+    MoveDirection direction = NORTH;
 
 #ifdef VERBOSE
     printf("Checking rabbit (%d, %d)\n", currentRow, currentCol);
@@ -213,187 +271,223 @@ static void processRabbitTurn(int genNumber, int threadStartRow, int threadEndRo
 
     if (movementOptions->emptyMovements > 0) {
 
-        int nextPosition = (genNumber + currentRow + currentCol) % movementOptions->emptyMovements;
-
-        MoveDirection direction = movementOptions->emptyDirections[ nextPosition ];
-        Move* move = getMoveDirection(direction);
+        direction = chooseMoveDirection(movementOptions->emptyDirections, genNumber + currentRow + currentCol);
+        const Move* move = getMoveDirection(direction);
 
-        int newRow = currentRow + move->x, newCol = currentCol + move->y;
+        newRow = currentRow + move->x;
+        newCol = currentCol + move->y;
 
 #ifdef VERBOSE
-        printf("Moving rabbit (%d, %d) with direction %d (Index: %d, Possible: %d) to location %d %d age %d \n", currentRow, currentCol, direction,
-            nextPosition, movementOptions->emptyMovements,
+        printf("Moving rabbit (%d, %d) with direction %d (Options: %#x, Possible: %d) to location %d %d age %d \n", currentRow, currentCol, direction,
+            movementOptions->emptyDirections, movementOptions->emptyMovements,
             newRow, newCol, rabbitInfo->currentGen);
 #endif
 
-        WorldSlot* realSlot = &world[ PROJECT(simulationData->columns, currentRow, currentCol) ];
-
         if (rabbitInfo->currentGen >= simulationData->gen_proc_rabbits) {
             //If the rabbit is old enough to procriate we need to leave a rabbit at that location
 
             //Initialize a new rabbit for that position
-            realSlot->entityInfo.rabbitInfo = createRabbitEntity();
-            realSlot->entityInfo.rabbitInfo->genUpdated = genNumber;
+            placeRabbitEntity(realSlot);
+            realSlot->entityInfo.rabbitInfo.genUpdated = genNumber;
             rabbitInfo->genUpdated = genNumber;
             rabbitInfo->prevGen = 0;
             rabbitInfo->currentGen = 0;
 
-            simulationData->entitiesPerRow[ currentRow ]++;
+            countEntity(region, currentRow, currentCol);
 
             procriated = 1;
         }
         else {
             realSlot->slotContent = EMPTY;
-            realSlot->entityInfo.rabbitInfo = NULL;
+
+            markEmpty(simulationData, world, currentRow, currentCol, sharesOccupancyWords(region));
         }
+    }
 
-        if (newRow < threadStartRow || newRow > threadEndRow) {
+    //Increment the current gen after checking for procriation, so that we only generate children in
+    //the next generation, but before performing the move, since the rabbit is copied to its new slot
+    //(or into the conflictArray) with the age it ends the generation with
+    if (!procriated) {
+        //Only increment if we did not procriate
+        rabbitInfo->prevGen = rabbitInfo->currentGen;
+        rabbitInfo->genUpdated = genNumber;
+        rabbitInfo->currentGen++;
+    }
+
+    if (movementOptions->emptyMovements > 0) {
+
+        if (isOutsideRegion(region, newRow, newCol)) {
             //Conflict, we have to access another thread's memory space, create a conflict
             //And store it in our conflict list
-            createAndStoreConflict(threadConflicts, newRow < threadStartRow, newRow, newCol, currentSlot);
+            createAndStoreConflict(threadConflicts, direction, newRow, newCol, &movingRabbit);
 
         }
         else {
             WorldSlot* newSlot = &world[ PROJECT(simulationData->columns, newRow, newCol) ];
 
-            movementResult = processRabbitMovement(rabbitInfo, newSlot);
+            //If the move fails the rabbit is not copied anywhere, so it dies
+            if (processRabbitMovement(rabbitInfo, newSlot) == 1) {
+                markOccupied(simulationData, world, newRow, newCol, RABBIT, sharesOccupancyWords(region));
 
-            if (movementResult == 1) {
-                simulationData->entitiesPerRow[ newRow ]++;
+                countEntity(region, newRow, newCol);
             }
         }
     }
     else {
-        //No possible movements for the rabbit
-        simulationData->entitiesPerRow[ currentRow ]++;
+        //No possible movements for the rabbit, it stays in place
+        *realSlot = movingRabbit;
 
+        countEntity(region, currentRow, currentCol);
     }
+}
 
-    //Increment the current after performing the move, but before the conflict resolution, so that
-    //we only generate children in the next generation, but we still have the correct
-    //Number to handle the conflictArray
-    if (!procriated) {
-        //Only increment if we did not procriate
-        rabbitInfo->prevGen = rabbitInfo->currentGen;
-        rabbitInfo->genUpdated = genNumber;
-        rabbitInfo->currentGen++;
-    }
+void moveRabbitsInRegion(int genNumber, struct ThreadConflictData* region, WorldSlot* frontWorld,
+    struct RabbitMovements* movementOptions, Conflicts* regionConflicts) {
 
-    if (!movementResult) {
-        destroyRabbitEntity(rabbitInfo);
-    }
-}
+    InputData* simulationData = region->inputData;
 
-static void
-executeRabbitGeneration(int threadNumber, int genNumber, InputData* simulationData, struct ThreadedData* threadedData,
-    WorldSlot* world, WorldSlot* worldSnapshot, int threadStartRow, int threadEndRow) {
+    WorldSlot* backWorld = region->world;
 
-    int storagePaddingTop = threadStartRow > 0 ? 1 : 0;
+    int startRow = region->startRow, endRow = region->endRow,
+        startCol = region->startCol, endCol = region->endCol;
 
-#ifdef VERBOSE
-    printf("End Row: %d, start row: %d, storage padding top %d\n", threadEndRow, threadStartRow, storagePaddingTop);
-#endif
-    int trueRowCount = (threadEndRow - threadStartRow);
+    int shared = sharesOccupancyWords(region);
 
-    Conflicts* threadConflicts;
+    NeighbourMasks* masks = regionNeighbourMasks(region);
 
-    if (threadedData != NULL)
-        threadConflicts = threadedData->conflictPerThreads[ threadNumber ];
+    prepareBackRow(simulationData, frontWorld, backWorld, startRow, startCol, endCol, shared);
 
-    //First move the rabbits
+    for (int row = startRow; row <= endRow; row++) {
 
-    struct RabbitMovements* movementOptions = createRabbitMovementContext();
+        //Rabbits of this row can move into the next one, so it has to be ready before we move them
+        if (row < endRow) {
+            prepareBackRow(simulationData, frontWorld, backWorld, row + 1, startCol, endCol, shared);
+        }
 
-    for (int copyRow = 0; copyRow <= trueRowCount; copyRow++) {
-        int row = copyRow + threadStartRow;
-        simulationData->entitiesPerRow[ row ] = 0;
-    }
+        const uint64_t* rowBits = occupancyRow(simulationData, frontWorld, row);
+
+        //Last word of the row the neighbour masks were computed for
+        int classifiedWord = -1;
 
-    for (int copyRow = 0; copyRow <= trueRowCount; copyRow++) {
-        int row = copyRow + threadStartRow;
+        //Only visit the slots that hold an entity
+        for (int word = startCol / 64; word <= endCol / 64; word++) {
 
-        for (int col = 0; col < simulationData->columns; col++) {
+            uint64_t bits = rowBits[ word ] & occupancyMask(word, startCol, endCol);
 
-            WorldSlot* currentSlot = &worldSnapshot[ PROJECT(simulationData->columns, copyRow + storagePaddingTop, col) ];
+            if (masks != NULL && bits != 0 && word > classifiedWord) {
+                classifiedWord = classifyOccupiedWords(simulationData, frontWorld, row, word, endCol / 64, 0, masks);
+            }
 
-            if (currentSlot->slotContent == RABBIT) {
+            for (; bits != 0; bits &= bits - 1) {
 
-                analyzeRabbitMovementOptions(copyRow + storagePaddingTop, col, simulationData, worldSnapshot,
-                    movementOptions);
+                int col = word * 64 + __builtin_ctzll(bits);
 
-                processRabbitTurn(genNumber, threadStartRow, threadEndRow, row, col, currentSlot,
-                    simulationData, world, movementOptions, threadConflicts);
+                WorldSlot* currentSlot = &frontWorld[ PROJECT(simulationData->columns, row, col) ];
 
-                //Even though we get passed the struct by value, we have to free it,as there's some arrays
-                //Contained in it
+                if (currentSlot->slotContent == RABBIT) {
+
+                    if (masks != NULL) {
+                        bitboardRabbitMovementOptions(masks, col, movementOptions);
+#ifdef VALIDATE_BITBOARD
+                        validateRabbitMovementOptions(row, col, simulationData, frontWorld, movementOptions);
+#endif
+                    }
+                    else {
+                        analyzeRabbitMovementOptions(row, col, simulationData, frontWorld, movementOptions);
+                    }
+
+                    processRabbitTurn(genNumber, row, col, currentSlot, simulationData, region,
+                        movementOptions, regionConflicts);
+                }
             }
         }
     }
+}
+
+static void
+executeRabbitGeneration(int threadNumber, int genNumber, InputData* simulationData, struct ThreadedData* threadedData,
+    WorldSlot* frontWorld, WorldSlot* backWorld, ThreadRowData* threadRows) {
+
+    struct ThreadConflictData region;
+
+    initializeThreadRegion(&region, threadNumber, simulationData, threadedData, backWorld, threadRows);
+
+#ifdef VERBOSE
+    printf("End Row: %d, start row: %d\n", region.endRow, region.startRow);
+#endif
+
+    for (int row = region.startRow; row <= region.endRow; row++) {
+        region.entitiesPerRow[ row ] = 0;
+    }
+
+    if (region.entitiesPerColumn != NULL) {
+        for (int col = region.startCol; col <= region.endCol; col++) {
+            region.entitiesPerColumn[ col ] = 0;
+        }
+    }
+
+    long phaseStart = readPhaseClock(threadedData->timers, threadNumber);
 
-    destroyRabbitMovementContext(movementOptions);
+    //First move the rabbits
+    moveRabbitsInRegion(genNumber, &region, frontWorld, threadedData->rabbitMovementsPerThread[ threadNumber ],
+        &threadedData->workers[ threadNumber ].conflicts);
+
+    phaseStart = markPhase(threadedData->timers, threadNumber, genNumber, PHASE_RABBITS, phaseStart);
 
-    //Initialize with the conflictArray at null because we don't want to access the memory
-    //Until we know it's safe to do so
-    struct ThreadConflictData conflictData = { threadNumber, threadStartRow, threadEndRow, simulationData,
-                                              world, threadedData };
+    synchronizeAndResolveThreadConflicts(&region);
 
-    synchronizeAndResolveThreadConflicts(&conflictData);
+    markPhase(threadedData->timers, threadNumber, genNumber, PHASE_CONFLICTS, phaseStart);
 }
 
 
-static void processFoxTurn(int genNumber, int threadStartRow, int threadEndRow, int currentRow, int currentCol, WorldSlot* currentSlot,
-    InputData* simulationData, WorldSlot* world,
+static void processFoxTurn(int genNumber, int currentRow, int currentCol, WorldSlot* currentSlot,
+    InputData* simulationData, struct ThreadConflictData* region,
     struct FoxMovements* foxMovements, Conflicts* threadConflicts) {
 
-    FoxInfo* foxInfo = currentSlot->entityInfo.foxInfo;
+    WorldSlot* world = region->world;
 
-    //If there is no move, the result is positive, as no other animal should try to eat us
-    int foxMovementResult = 1;
+    //Work on a copy of the fox, it gets copied into the slot it moves to
+    WorldSlot movingFox = *currentSlot;
 
-    //Since we store the row that's above, we have to compensate with the storagePadding
+    FoxInfo* foxInfo = &movingFox.entityInfo.foxInfo;
+
+    WorldSlot* realSlot = &world[ PROJECT(simulationData->columns, currentRow, currentCol) ];
 
     //Increment the gen food so the fox dies before moving and after not finding a rabbit to eat
     foxInfo->currentGenFood++;
 
 #ifdef VERBOSE
-    printf("Checking fox %p (%d %d) food %d\n", foxInfo, currentRow, currentCol, foxInfo->currentGenFood);
+    printf("Checking fox (%d %d) food %d\n", currentRow, currentCol, foxInfo->currentGenFood);
 #endif
 
     if (foxMovements->rabbitMovements <= 0) {
         if (foxInfo->currentGenFood >= simulationData->gen_food_foxes) {
             //If the fox gen food reaches the limit, kill it before it moves.
-            WorldSlot* realSlot = &world[ PROJECT(simulationData->columns, currentRow, currentCol) ];
-
             realSlot->slotContent = EMPTY;
 
-            realSlot->entityInfo.foxInfo = NULL;
+            markEmpty(simulationData, world, currentRow, currentCol, sharesOccupancyWords(region));
 
 #ifdef VERBOSE
-            printf("Fox %p on %d %d Starved to death\n", foxInfo, currentRow, currentCol);
+            printf("Fox on %d %d Starved to death\n", currentRow, currentCol);
 #endif
 
-            destroyFoxEntity(foxInfo);
-
             return;
         }
     }
 
-    int nextPosition;
-
-    MoveDirection direction;
+    MoveDirection direction = NORTH;
     int procriated = 0;
 
+    int canMove = foxMovements->emptyMovements > 0 || foxMovements->rabbitMovements > 0;
+
     //Can only breed a fox when we are capable of moving
-    if ((foxMovements->emptyMovements > 0 || foxMovements->rabbitMovements > 0)) {
-        WorldSlot* realSlot = &world[ PROJECT(simulationData->columns, currentRow, currentCol) ];
+    if (canMove) {
 
         if (foxInfo->currentGenProc >= simulationData->gen_proc_foxes) {
-            realSlot->slotContent = FOX;
-
-            realSlot->entityInfo.foxInfo = createFoxEntity();
-            realSlot->entityInfo.foxInfo->genUpdated = genNumber;
+            placeFoxEntity(realSlot);
+            realSlot->entityInfo.foxInfo.genUpdated = genNumber;
 
-            simulationData->entitiesPerRow[ currentRow ]++;
+            countEntity(region, currentRow, currentCol);
 
             foxInfo->genUpdated = genNumber;
             foxInfo->prevGenProc = foxInfo->currentGenProc;
@@ -404,192 +498,207 @@ static void processFoxTurn(int genNumber, int threadStartRow, int threadEndRow,
             //Clear the currentSlot
             realSlot->slotContent = EMPTY;
 
-            realSlot->entityInfo.foxInfo = NULL;
+            markEmpty(simulationData, world, currentRow, currentCol, sharesOccupancyWords(region));
         }
     }
 
-    if (foxMovements->rabbitMovements > 0) {
-        nextPosition = (genNumber + currentRow + currentCol) % foxMovements->rabbitMovements;
-
-        direction = foxMovements->rabbitDirections[ nextPosition ];
+    if (!procriated) {
+        //Only increment the procriated when the fox did not replicate
+        //(Or else it would start with 1 extra gen). If the move fails the fox dies, so we
+        //can increment it before moving (the fox is copied with the age it ends the generation with)
+        foxInfo->genUpdated = genNumber;
+        foxInfo->prevGenProc = foxInfo->currentGenProc;
+        foxInfo->currentGenProc++;
     }
-    else if (foxMovements->emptyMovements > 0) {
-        nextPosition = (genNumber + currentRow + currentCol) % foxMovements->emptyMovements;
 
-        direction = foxMovements->emptyDirections[ nextPosition ];
-    }
+    if (canMove) {
+        //The prey directions take priority over the empty ones
+        direction = chooseMoveDirection(foxMovements->rabbitMovements > 0 ? foxMovements->rabbitDirections
+                                                                          : foxMovements->emptyDirections,
+                                        genNumber + currentRow + currentCol);
 
-    if (foxMovements->rabbitMovements > 0 || foxMovements->emptyMovements > 0) {
-        Move* move = getMoveDirection(direction);
+        const Move* move = getMoveDirection(direction);
 
         int newRow = currentRow + move->x, newCol = currentCol + move->y;
 
-        if (newRow < threadStartRow || newRow > threadEndRow) {
+        if (isOutsideRegion(region, newRow, newCol)) {
             //Conflict, we have to access another thread's memory space, create a conflict
             //And store it in our conflict list
-            createAndStoreConflict(threadConflicts, newRow < threadStartRow, newRow, newCol, currentSlot);
+            createAndStoreConflict(threadConflicts, direction, newRow, newCol, &movingFox);
         }
         else {
             WorldSlot* newSlot = &world[ PROJECT(simulationData->columns, newRow, newCol) ];
 
-            foxMovementResult = processFoxMovement(foxInfo, newSlot);
+            int foxMovementResult = processFoxMovement(foxInfo, newSlot);
+
             //We only increment the rows under our control, to avoid concurrency issues
             if (foxMovementResult == 1) {
-                simulationData->entitiesPerRow[ newRow ]++;
+                markOccupied(simulationData, world, newRow, newCol, FOX, sharesOccupancyWords(region));
+
+                countEntity(region, newRow, newCol);
             }
+            else if (foxMovementResult == 2) {
+                //If the fox eats a rabbit, reset it's current gen food
+                newSlot->entityInfo.foxInfo.currentGenFood = 0;
+
+                markOccupied(simulationData, world, newRow, newCol, FOX, sharesOccupancyWords(region));
+            }
+            //If the move failed the fox is not copied anywhere, so it dies
         }
     }
     else {
-        simulationData->entitiesPerRow[ currentRow ]++;
+        //No possible movements for the fox, it stays in place
+        *realSlot = movingFox;
+
+        countEntity(region, currentRow, currentCol);
 #ifdef VERBOSE
         printf("FOX at %d %d has no possible movements\n", currentRow, currentCol);
 #endif
     }
+}
 
-    if (!procriated) {
-        foxInfo->genUpdated = genNumber;
-        foxInfo->prevGenProc = foxInfo->currentGenProc;
-    }
+void moveFoxesInRegion(int genNumber, struct ThreadConflictData* region, WorldSlot* frontWorld,
+    struct FoxMovements* foxMovements, Conflicts* regionConflicts) {
 
-    if (foxMovementResult == 1 || foxMovementResult == 2) {
+    InputData* simulationData = region->inputData;
 
-        if (!procriated) {
-            //Only increment the procriated when the fox did not replicate
-            //(Or else it would start with 1 extra gen)
-            foxInfo->currentGenProc++;
-        }
+    WorldSlot* backWorld = region->world;
 
-        //If the fox eats a rabbit, reset it's current gen food
-        if (foxMovementResult == 2) {
-            foxInfo->currentGenFood = 0;
-        }
+    int startRow = region->startRow, endRow = region->endRow,
+        startCol = region->startCol, endCol = region->endCol;
 
-    }
-    else if (foxMovementResult == 0) {
-        //If the move failed kill the fox
-        destroyFoxEntity(foxInfo);
-    }
-}
+    int shared = sharesOccupancyWords(region);
 
-static void
-executeFoxGeneration(int threadNumber, int genNumber, InputData* simulationData, struct ThreadedData* threadedData,
-    WorldSlot* world, WorldSlot* worldSnapshot, int threadStartRow, int threadEndRow) {
+    NeighbourMasks* masks = regionNeighbourMasks(region);
 
-    int storagePaddingTop = threadStartRow > 0 ? 1 : 0;
+    prepareBackRow(simulationData, frontWorld, backWorld, startRow, startCol, endCol, shared);
 
-    int trueRowCount = threadEndRow - threadStartRow;
+    for (int row = startRow; row <= endRow; row++) {
 
-    Conflicts* threadConflicts;
-    if (threadedData != NULL)
-        threadConflicts = threadedData->conflictPerThreads[ threadNumber ];
+        //Foxes of this row can move into the next one, so it has to be ready before we move them
+        if (row < endRow) {
+            prepareBackRow(simulationData, frontWorld, backWorld, row + 1, startCol, endCol, shared);
+        }
 
-    struct FoxMovements* foxMovements = createFoxMovementContext();
+        const uint64_t* rowBits = occupancyRow(simulationData, frontWorld, row);
 
-    for (int copyRow = 0; copyRow <= trueRowCount; copyRow++) {
-        for (int col = 0; col < simulationData->columns; col++) {
+        //Last word of the row the neighbour masks were computed for
+        int classifiedWord = -1;
 
-            int row = copyRow + threadStartRow;
+        for (int word = startCol / 64; word <= endCol / 64; word++) {
 
-            WorldSlot* currentSlot = &worldSnapshot[ PROJECT(simulationData->columns, copyRow + storagePaddingTop, col) ];
+            uint64_t bits = rowBits[ word ] & occupancyMask(word, startCol, endCol);
 
-            if (currentSlot->slotContent == FOX) {
+            if (masks != NULL && bits != 0 && word > classifiedWord) {
+                classifiedWord = classifyOccupiedWords(simulationData, frontWorld, row, word, endCol / 64, 1, masks);
+            }
 
-                analyzeFoxMovementOptions(copyRow + storagePaddingTop, col, simulationData,
-                    worldSnapshot, foxMovements);
+            for (; bits != 0; bits &= bits - 1) {
 
-                processFoxTurn(genNumber, threadStartRow, threadEndRow, row, col, currentSlot,
-                    simulationData, world, foxMovements, threadConflicts);
+                int col = word * 64 + __builtin_ctzll(bits);
 
-            }
-        }
-    }
+                WorldSlot* currentSlot = &frontWorld[ PROJECT(simulationData->columns, row, col) ];
 
-    destroyFoxMovementContext(foxMovements);
+                if (currentSlot->slotContent == FOX) {
 
-    struct ThreadConflictData conflictData = { threadNumber, threadStartRow, threadEndRow, simulationData,
-                                              world, threadedData };
+                    if (masks != NULL) {
+                        bitboardFoxMovementOptions(masks, col, foxMovements);
+#ifdef VALIDATE_BITBOARD
+                        validateFoxMovementOptions(row, col, simulationData, frontWorld, foxMovements);
+#endif
+                    }
+                    else {
+                        analyzeFoxMovementOptions(row, col, simulationData, frontWorld, foxMovements);
+                    }
 
-    synchronizeAndResolveThreadConflicts(&conflictData);
+                    processFoxTurn(genNumber, row, col, currentSlot, simulationData, region,
+                        foxMovements, regionConflicts);
+                }
+            }
+        }
+    }
 }
 
-void executeSequentialGeneration(int genNumber, InputData* simulationData, WorldSlot* world) {
-
-    int threadStartRow = 0, threadEndRow = simulationData->rows - 1;
+static void
+executeFoxGeneration(int threadNumber, int genNumber, InputData* simulationData, struct ThreadedData* threadedData,
+    WorldSlot* frontWorld, WorldSlot* backWorld, ThreadRowData* threadRows) {
 
-    int copyStartRow = threadStartRow, copyEndRow = threadEndRow;
+    struct ThreadConflictData region;
 
-    int rowCount = (copyEndRow - copyStartRow) + 1;
+    initializeThreadRegion(&region, threadNumber, simulationData, threadedData, backWorld, threadRows);
 
-    /**
- * A copy of our area of the tray. This copy will not be modified
- */
-    WorldSlot* worldSnapshot = malloc(sizeof(WorldSlot) * rowCount * simulationData->columns);
+    long phaseStart = readPhaseClock(threadedData->timers, threadNumber);
 
-#ifdef VERBOSE
-    printf("Doing copy of world Row: %d to %d (Initial: %d %d, %d)\n", copyStartRow, copyEndRow, threadStartRow, threadEndRow,
-        simulationData->rows);
-#endif
+    moveFoxesInRegion(genNumber, &region, frontWorld, threadedData->foxMovementsPerThread[ threadNumber ],
+        &threadedData->workers[ threadNumber ].conflicts);
 
-    copyWorldRegionToBuffer(0, simulationData, NULL, world, worldSnapshot, copyStartRow, copyEndRow);
+    phaseStart = markPhase(threadedData->timers, threadNumber, genNumber, PHASE_FOXES, phaseStart);
 
-#ifdef VERBOSE
-    printf("Done copy on thread %d\n", threadNumber);
-#endif
+    synchronizeAndResolveThreadConflicts(&region);
 
-    executeRabbitGeneration(0, genNumber, simulationData, NULL, world, worldSnapshot, threadStartRow, threadEndRow);
+    markPhase(threadedData->timers, threadNumber, genNumber, PHASE_CONFLICTS, phaseStart);
+}
 
-    copyWorldRegionToBuffer(0, simulationData, NULL, world, worldSnapshot, copyStartRow, copyEndRow);
+void executeSequentialGeneration(int genNumber, InputData* simulationData, struct ThreadedData* threadedData,
+    WorldSlot* world, WorldSlot* backWorld) {
 
-    executeFoxGeneration(0, genNumber, simulationData, NULL, world, worldSnapshot, threadStartRow, threadEndRow);
+    ThreadRowData wholeWorld = { 0, simulationData->rows - 1, 0, simulationData->columns - 1 };
 
-    free(worldSnapshot);
+    //With a single thread covering the whole world no conflicts are ever created
+    executeRabbitGeneration(0, genNumber, simulationData, threadedData, world, backWorld, &wholeWorld);
 
+    executeFoxGeneration(0, genNumber, simulationData, threadedData, backWorld, world, &wholeWorld);
 }
 
 void executeParallelGeneration(int threadNumber, int genNumber,
-    InputData* simulationData, struct ThreadedData* threadedData, WorldSlot* world,
+    InputData* simulationData, struct ThreadedData* threadedData, WorldSlot* world, WorldSlot* backWorld,
     ThreadRowData* threadRowData) {
     ThreadRowData* ourData = &threadRowData[ threadNumber ];
 
-    //printf("Thread %d has start row %d and end row %d\n", threadNumber, ourData->threadStartRow, ourData->threadEndRow);
+    resetThreadConflicts(threadNumber, threadedData);
 
-    int threadStartRow = ourData->startRow,
-        threadEndRow = ourData->endRow;
+    executeRabbitGeneration(threadNumber, genNumber, simulationData, threadedData, world, backWorld, ourData);
 
-    int copyStartRow = threadStartRow > 0 ? threadStartRow - 1 : threadStartRow,
-        copyEndRow = threadEndRow < (simulationData->rows - 1) ? threadEndRow + 1 : threadEndRow;
+    int neighbourSync = threadedData->syncMode == SYNC_NEIGHBOURS;
 
-    int rowCount = ((copyEndRow - copyStartRow) + 1);
+    PhaseTimers* timers = threadedData->timers;
 
-    /**
-     * A copy of our area of the tray. This copy will not be modified
-     */
-    WorldSlot worldSnapshot[ rowCount * simulationData->columns ];
+    long phaseStart = readPhaseClock(timers, threadNumber);
 
-#ifdef VERBOSE
-    printf("Doing copy of world Row: %d to %d (Initial: %d %d, %d)\n", copyStartRow, copyEndRow, threadStartRow, threadEndRow,
-        simulationData->rows);
-#endif
-
-    copyWorldRegionToBuffer(threadNumber, simulationData, threadedData, world, worldSnapshot, copyStartRow, copyEndRow);
+    //The fox phase reads the rows our neighbours wrote (and resolved the conflicts into) during the rabbit phase,
+    //and writes the rows they were reading from. Only the neighbours touch the rows next to ours, so in neighbour
+    //sync mode we don't have to wait for the rest of the threads
+    if (neighbourSync) {
+        waitForNeighbourThreads(threadNumber, simulationData, threadedData);
+    } else {
+        pthread_barrier_wait(&threadedData->barrier);
+    }
 
-#ifdef VERBOSE
-    printf("Done copy on thread %d\n", threadNumber);
-#endif
+    markPhase(timers, threadNumber, genNumber, PHASE_WAITS, phaseStart);
 
     resetThreadConflicts(threadNumber, threadedData);
 
-    executeRabbitGeneration(threadNumber, genNumber, simulationData, threadedData, world, worldSnapshot, threadStartRow, threadEndRow);
+    executeFoxGeneration(threadNumber, genNumber, simulationData, threadedData, backWorld, world, ourData);
 
-    pthread_barrier_wait(&threadedData->barrier);
+    phaseStart = readPhaseClock(timers, threadNumber);
 
-    copyWorldRegionToBuffer(threadNumber, simulationData, threadedData, world, worldSnapshot, copyStartRow, copyEndRow);
+    if (neighbourSync) {
+        //The next generation reads the rows the neighbours wrote and writes the ones they were reading
+        waitForNeighbourThreads(threadNumber, simulationData, threadedData);
 
-    resetThreadConflicts(threadNumber, threadedData);
+        phaseStart = markPhase(timers, threadNumber, genNumber, PHASE_WAITS, phaseStart);
+
+        //Moving the rows between threads needs every thread to be done, so only do it every few generations
+        if ((genNumber + 1) % threadedData->rebalanceInterval == 0) {
+            updateCumulativeEntityCounts(threadNumber, simulationData, threadRowData, threadedData);
 
-    executeFoxGeneration(threadNumber, genNumber, simulationData, threadedData, world, worldSnapshot, threadStartRow, threadEndRow);
+            markPhase(timers, threadNumber, genNumber, PHASE_REBALANCE, phaseStart);
+        }
+    } else {
+        updateCumulativeEntityCounts(threadNumber, simulationData, threadRowData, threadedData);
 
-    updateCumulativeEntityCounts(threadNumber, simulationData, threadRowData, threadedData);
+        markPhase(timers, threadNumber, genNumber, PHASE_REBALANCE, phaseStart);
+    }
 }
 
 
@@ -614,11 +723,11 @@ void resolveThreadConflicts(struct ThreadConflictData* conflictContext, int conf
 
         int movementResult = -1;
 
-        if (row < conflictContext->startRow || row > conflictContext->endRow) {
+        if (isOutsideRegion(conflictContext, row, column)) {
             fprintf(stderr,
-                "ERROR: ATTEMPTING TO RESOLVE CONFLICT WITH ROW OUTSIDE SCOPE\n Row: %d, Start Row: %d End Row: %d\n",
-                row,
-                conflictContext->startRow, conflictContext->endRow);
+                "ERROR: ATTEMPTING TO RESOLVE CONFLICT OUTSIDE SCOPE\n Row: %d, Col: %d, Start Row: %d End Row: %d, Start Col: %d End Col: %d\n",
+                row, column,
+                conflictContext->startRow, conflictContext->endRow, conflictContext->startCol, conflictContext->endCol);
             continue;
         }
 
@@ -628,30 +737,29 @@ void resolveThreadConflicts(struct ThreadConflictData* conflictContext, int conf
         //Both entities are the same, so we have to follow the rules for eating rabbits.
         if (conflict->slotContent == RABBIT) {
 
-            movementResult = processRabbitMovement((RabbitInfo*)conflict->data, currentEntityInSlot);
-
-            if (movementResult == 0) {
-                destroyRabbitEntity(conflict->data);
-            }
+            movementResult = processRabbitMovement(&conflict->entityInfo.rabbitInfo, currentEntityInSlot);
 
         }
         else if (conflict->slotContent == FOX) {
 
-            movementResult = processFoxMovement(conflict->data, currentEntityInSlot);
+            movementResult = processFoxMovement(&conflict->entityInfo.foxInfo, currentEntityInSlot);
 
             if (movementResult == 2) {
                 //This happens after the gen food has been incremented, so if we set it to 0 here
                 //It should produce the desired output
-                ((FoxInfo*)conflict->data)->currentGenFood = 0;
-            }
-            else if (movementResult == 0) {
-                destroyFoxEntity(conflict->data);
+                currentEntityInSlot->entityInfo.foxInfo.currentGenFood = 0;
+
+                //The rabbit was counted in the slot already, only the fox plane changes
+                markOccupied(conflictContext->inputData, world, row, column, FOX, sharesOccupancyWords(conflictContext));
             }
 
         }
 
         if (movementResult == 1) {
-            conflictContext->inputData->entitiesPerRow[ row ]++;
+            markOccupied(conflictContext->inputData, world, row, column, conflict->slotContent,
+                sharesOccupancyWords(conflictContext));
+
+            countEntity(conflictContext, row, column);
         }
     }
 }
@@ -704,13 +812,13 @@ void displayGenerationState(FILE* outputFile, InputData* simulationData, WorldSl
                     if (i == 0)
                         fprintf(outputFile, "F");
                     else if (i == 1)
-                        fprintf(outputFile, "%d", currentSlot->entityInfo.foxInfo->currentGenProc);
+                        fprintf(outputFile, "%d", currentSlot->entityInfo.foxInfo.currentGenProc);
                     else if (i == 2)
-                        fprintf(outputFile, "%d", currentSlot->entityInfo.foxInfo->currentGenFood);
+                        fprintf(outputFile, "%d", currentSlot->entityInfo.foxInfo.currentGenFood);
                     break;
                 case RABBIT:
                     if (i == 1)
-                        fprintf(outputFile, "%d", currentSlot->entityInfo.rabbitInfo->currentGen);
+                        fprintf(outputFile, "%d", currentSlot->entityInfo.rabbitInfo.currentGen);
                     else
                         fprintf(outputFile, "R");
                     break;
@@ -749,68 +857,20 @@ void displayGenerationState(FILE* outputFile, InputData* simulationData, WorldSl
 
 void outputSimulationResults(FILE* outputFile, InputData* simulationData, WorldSlot* worldMatrix) {
 
-    int totalEntities = 0;
-    for (int row = 0; row < simulationData->rows; row++) {
-        for (int col = 0; col < simulationData->columns; col++) {
-            WorldSlot* currentSlot = &worldMatrix[ PROJECT(simulationData->columns, row, col) ];
-            if (currentSlot->slotContent != EMPTY) {
-                totalEntities++;
-            }
-        }
-    }
+    //The whole world in a single band
+    ResultWrite* write = createResultWrite(simulationData, worldMatrix, 1);
 
-    fprintf(outputFile, "%d %d %d %d %d %d %d\n", simulationData->gen_proc_rabbits, simulationData->gen_proc_foxes,
-        simulationData->gen_food_foxes,
-        0, simulationData->rows, simulationData->columns, totalEntities);
-
-    for (int row = 0; row < simulationData->rows; row++) {
-        for (int col = 0; col < simulationData->columns; col++) {
-
-            WorldSlot* currentSlot = &worldMatrix[ PROJECT(simulationData->columns, row, col) ];
-
-            if (currentSlot->slotContent != EMPTY) {
-
-                switch (currentSlot->slotContent) {
-                case RABBIT:
-                    fprintf(outputFile, "RABBIT");
-                    break;
-                case FOX:
-                    fprintf(outputFile, "FOX");
-                    break;
-                case ROCK:
-                    fprintf(outputFile, "ROCK");
-                    break;
-                default:
-                    break;
-                }
-
-                fprintf(outputFile, " %d %d\n", row, col);
-
-            }
-        }
-    }
+    formatResultBand(0, write);
 
+    finishResultWrite(outputFile, write);
 }
 
 void deallocateWorldMatrix(InputData* simulationData, WorldSlot* worldMatrix) {
-    for (int row = 0; row < simulationData->rows; row++) {
-        for (int col = 0; col < simulationData->columns; col++) {
-            WorldSlot* currentSlot = &worldMatrix[ PROJECT(simulationData->columns, row, col) ];
-            if (currentSlot->slotContent == RABBIT) {
-                destroyRabbitEntity(currentSlot->entityInfo.rabbitInfo);
-            }
-            else if (currentSlot->slotContent == FOX) {
-                destroyFoxEntity(currentSlot->entityInfo.foxInfo);
-            }
-
-            releaseMovementDirections(currentSlot->defaultPossibleMoveDirections);
-
-        }
-    }
-
+    //The entities live inside the world slots, so there is nothing to release per slot
     free(simulationData->entitiesPerRow);
     free(simulationData->entitiesAccumulatedPerRow);
+    free(simulationData->topology);
 
     free(simulationData);
     freeMatrix((void**)&worldMatrix);
-}
\ No newline at end of file
+}
@@ -3,10 +3,23 @@
 
 #include <stdio.h>
 
+//Write the state of every generation to allgen.txt
+#define PRINT_ALL_GEN 0
+
 typedef enum MoveDirection_ MoveDirection;
 
+typedef enum AnalysisMode_ AnalysisMode;
+
+typedef enum BitboardKernel_ BitboardKernel;
+
 typedef struct Conflict_ Conflict;
 
+typedef struct Conflicts_ Conflicts;
+
+struct RabbitMovements;
+
+struct FoxMovements;
+
 struct ThreadedData;
 
 struct ThreadConflictData;
@@ -18,6 +31,9 @@ typedef struct InputData_ {
     int gen_proc_rabbits, gen_proc_foxes, gen_food_foxes;
     int n_gen;
 
+    //Generations simulated before the world was loaded, the first one left to run (see snapshot.h)
+    int firstGeneration;
+
     int rows, columns;
 
     int initialPopulation;
@@ -30,6 +46,10 @@ typedef struct InputData_ {
 
     int *entitiesPerRow;
 
+    //Bit d of the byte of a slot is set when moving in MoveDirection d from it stays inside the world and does
+    //not hit a rock. Rocks never move, so it is computed once when the world is loaded and shared by every thread
+    unsigned char *topology;
+
 } InputData;
 
 typedef enum SlotContent_ {
@@ -52,36 +72,31 @@ typedef struct RabbitInfo_ {
 typedef struct FoxInfo_ {
     int genUpdated, prevGenProc;
 
-    int currentGenProc;
+    //A fox can only go past gen_proc_foxes while it is unable to move, and it starves within
+    //gen_food_foxes generations when that happens, so both counters fit in 16 bits
+    //(checked in parseSimulationParameters). This keeps a fox as small as a rabbit
+    unsigned short currentGenProc;
 
     //Generations since the fox has eaten a rabbit
-    int currentGenFood;
+    unsigned short currentGenFood;
 } FoxInfo;
 
 typedef struct WorldSlot_ {
 
-    SlotContent slotContent;
-
-    //Store the default possible movement rabbitDirections
-    //so we don't have to calculate them every time
-    //This way, we only have to check the move rabbitDirections that are here
-    //For empty slots
-    int defaultP;
-
-    MoveDirection *defaultPossibleMoveDirections;
+    //The SlotContent of this slot, stored in a single byte to keep the slot packed
+    unsigned char slotContent;
 
+    //The entity state lives in the slot itself, moving an entity copies it into its new slot
     union {
 
-        FoxInfo *foxInfo;
+        FoxInfo foxInfo;
 
-        RabbitInfo *rabbitInfo;
+        RabbitInfo rabbitInfo;
 
     } entityInfo;
 
 } WorldSlot;
 
-InputData *parseSimulationParameters(FILE *file);
-
 /**
  * Initialize the tray of data, returns a matrix where each position is a WorldSlot
  * @param data
@@ -89,25 +104,53 @@ InputData *parseSimulationParameters(FILE *file);
  */
 WorldSlot *initializeWorldMatrix(InputData *data);
 
-void runSequentialSimulation(FILE *inputFile, FILE *outputFile);
+typedef struct SnapshotOptions_ SnapshotOptions;
+
+void runSequentialSimulation(FILE *inputFile, FILE *outputFile, AnalysisMode analysisMode, BitboardKernel bitboardKernel,
+                             const SnapshotOptions *snapshots);
 
+/**
+ * Run a single simulation on a thread pool that is created and destroyed for it.
+ * To run many simulations on the same threads see engine.h
+ */
 void runParallelSimulation(int threadCount, FILE *inputFile, FILE *outputFile);
 
-void loadWorldEntities(FILE *inputFile, InputData *inputData, WorldSlot *world);
+/**
+ * Perform a generation of the whole world on the calling thread, using the back buffer the same way
+ * executeParallelGeneration does. threadedData must be a threading system prepared for a single thread
+ */
+void executeSequentialGeneration(int genNumber, InputData *simulationData, struct ThreadedData *threadedData,
+                                 WorldSlot *world, WorldSlot *backWorld);
 
 /**
- * Perform a generation of a world, within the bounds given by start of startRow and end of endRow
+ * Perform a generation of a world, within the rows given to the thread in threadRowData.
  *
- * Returns a linked list
- * @param inputData
+ * The rabbit phase reads world and writes backWorld, the fox phase reads backWorld and writes world,
+ * so when the generation ends the new state is in world
+ * @param threadNumber
+ * @param genNumber
+ * @param simulationData
+ * @param threadedData
  * @param world
- * @param startRow
- * @param endRow
- * @return
+ * @param backWorld
+ * @param threadRowData
  */
 void
 executeParallelGeneration(int threadNumber, int genNumber, InputData *simulationData,
-                  struct ThreadedData *threadedData, WorldSlot *world, ThreadRowData *threadRowData);
+                  struct ThreadedData *threadedData, WorldSlot *world, WorldSlot *backWorld, ThreadRowData *threadRowData);
+
+/**
+ * Move the rabbits of a region, reading frontWorld and writing the region of region->world. The moves that leave
+ * the region are stored in regionConflicts, to be resolved by the owner of the target slot
+ */
+void moveRabbitsInRegion(int genNumber, struct ThreadConflictData *region, WorldSlot *frontWorld,
+                         struct RabbitMovements *movementOptions, Conflicts *regionConflicts);
+
+/**
+ * Same as moveRabbitsInRegion, for the foxes
+ */
+void moveFoxesInRegion(int genNumber, struct ThreadConflictData *region, WorldSlot *frontWorld,
+                       struct FoxMovements *foxMovements, Conflicts *regionConflicts);
 
 void resolveThreadConflicts(struct ThreadConflictData *conflictContext, int conflictCount, Conflict *conflictArray);
 
@@ -0,0 +1,307 @@
+#include "reader.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+InputReader *openInputReader(FILE *file) {
+    InputReader *reader = malloc(sizeof(InputReader));
+
+    reader->file = file;
+    reader->mapping = NULL;
+    reader->buffer = NULL;
+    reader->parseNanos = 0;
+
+    struct stat fileStatus;
+
+    //Where the file is at, stdio might have already read some of it
+    long offset = ftell(file);
+
+    if (offset >= 0 && fstat(fileno(file), &fileStatus) == 0 && S_ISREG(fileStatus.st_mode) &&
+        fileStatus.st_size > 0) {
+
+        void *mapping = mmap(NULL, fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, fileStatus.st_size, MADV_SEQUENTIAL);
+
+            reader->mapping = mapping;
+            reader->mappingSize = fileStatus.st_size;
+            reader->bufferOffset = 0;
+            reader->position = reader->mapping + offset;
+            reader->end = reader->mapping + reader->mappingSize;
+            reader->startOffset = offset;
+
+            return reader;
+        }
+    }
+
+    //Pipes (or a mapping that failed), stream the input through our buffer
+    reader->buffer = malloc(READER_BUFFER_SIZE);
+    reader->bufferOffset = 0;
+    reader->position = reader->buffer;
+    reader->end = reader->buffer;
+    reader->startOffset = 0;
+
+    return reader;
+}
+
+static long currentOffset(InputReader *reader) {
+    const char *start = reader->mapping != NULL ? reader->mapping : reader->buffer;
+
+    return reader->bufferOffset + (reader->position - start);
+}
+
+//Get the next bytes of a streamed input, 0 when there are none left
+static int refillBuffer(InputReader *reader) {
+    if (reader->mapping != NULL) {
+        return 0;
+    }
+
+    reader->bufferOffset += reader->end - reader->buffer;
+
+    size_t bytes = fread(reader->buffer, 1, READER_BUFFER_SIZE, reader->file);
+
+    reader->position = reader->buffer;
+    reader->end = reader->buffer + bytes;
+
+    return bytes > 0;
+}
+
+static inline int peekCharacter(InputReader *reader) {
+    if (reader->position == reader->end && !refillBuffer(reader)) {
+        return EOF;
+    }
+
+    return (unsigned char) *reader->position;
+}
+
+//The same characters isspace accepts in the C locale
+static inline int isBlank(int character) {
+    return character == ' ' || (character >= '\t' && character <= '\r');
+}
+
+static void skipWhitespace(InputReader *reader) {
+    int character;
+
+    while ((character = peekCharacter(reader)) != EOF && isBlank(character)) {
+        reader->position++;
+    }
+}
+
+int readerAtEnd(InputReader *reader) {
+    skipWhitespace(reader);
+
+    return peekCharacter(reader) == EOF;
+}
+
+int readInteger(InputReader *reader) {
+    skipWhitespace(reader);
+
+    int character = peekCharacter(reader), negative = 0;
+
+    if (character == '-' || character == '+') {
+        negative = character == '-';
+
+        reader->position++;
+
+        character = peekCharacter(reader);
+    }
+
+    if (character < '0' || character > '9') {
+        fprintf(stderr, "ERROR: Expected a number at byte %ld of the input\n", currentOffset(reader));
+        exit(EXIT_FAILURE);
+    }
+
+    long value = 0;
+
+    for (; character >= '0' && character <= '9'; character = peekCharacter(reader)) {
+        value = value * 10 + (character - '0');
+
+        //Checked every digit, so the value never gets past a long
+        if (value > INT_MAX) {
+            fprintf(stderr, "ERROR: Number too large at byte %ld of the input\n", currentOffset(reader));
+            exit(EXIT_FAILURE);
+        }
+
+        reader->position++;
+    }
+
+    return (int) (negative ? -value : value);
+}
+
+SlotContent readEntityType(InputReader *reader) {
+    skipWhitespace(reader);
+
+    int first = peekCharacter(reader);
+
+    if (first == EOF) {
+        fprintf(stderr, "ERROR: Expected an entity at byte %ld of the input\n", currentOffset(reader));
+        exit(EXIT_FAILURE);
+    }
+
+    reader->position++;
+
+    //ROCK and RABBIT share their first letter
+    int second = peekCharacter(reader);
+
+    SlotContent content = EMPTY;
+
+    if (first == 'F') {
+        content = FOX;
+    } else if (first == 'R' && second == 'O') {
+        content = ROCK;
+    } else if (first == 'R' && second == 'A') {
+        content = RABBIT;
+    }
+
+    //Skip the rest of the name
+    int character;
+
+    while ((character = peekCharacter(reader)) != EOF && !isBlank(character)) {
+        reader->position++;
+    }
+
+    return content;
+}
+
+//Skip the blanks up to the end of the line
+static void skipLineBlanks(InputReader *reader) {
+    while (reader->position < reader->end && *reader->position != '\n' && isBlank(*reader->position)) {
+        reader->position++;
+    }
+}
+
+//Read an integer on the current line, 0 when there is none or it does not fit in an int. Only for mapped inputs
+static int readLineInteger(InputReader *reader, int *value) {
+    skipLineBlanks(reader);
+
+    const char *position = reader->position;
+
+    int negative = position < reader->end && *position == '-';
+
+    if (position < reader->end && (*position == '-' || *position == '+')) {
+        position++;
+    }
+
+    if (position == reader->end || *position < '0' || *position > '9') {
+        return 0;
+    }
+
+    long number = 0;
+
+    for (; position < reader->end && *position >= '0' && *position <= '9'; position++) {
+        number = number * 10 + (*position - '0');
+
+        if (number > INT_MAX) {
+            return 0;
+        }
+    }
+
+    reader->position = position;
+
+    *value = (int) (negative ? -number : number);
+
+    return 1;
+}
+
+int readEntityLine(InputReader *reader, SlotContent *content, int *row, int *col) {
+    skipWhitespace(reader);
+
+    int first = peekCharacter(reader);
+
+    if (first == EOF) {
+        return 0;
+    }
+
+    const char *lineStart = reader->position;
+
+    if (first >= 'A' && first <= 'Z') {
+        *content = readEntityType(reader);
+
+        if (readLineInteger(reader, row) && readLineInteger(reader, col)) {
+            skipLineBlanks(reader);
+
+            if (reader->position == reader->end || *reader->position == '\n') {
+                return 1;
+            }
+        }
+    }
+
+    reader->position = lineStart;
+
+    return -1;
+}
+
+int isInputMapped(InputReader *reader) {
+    return reader->mapping != NULL;
+}
+
+long mappedBytesLeft(InputReader *reader) {
+    return reader->end - reader->position;
+}
+
+//The start of the first line at or after position
+static const char *lineStart(InputReader *reader, const char *position) {
+    if (position == reader->position) {
+        return position;
+    }
+
+    const char *newline = memchr(position - 1, '\n', reader->end - (position - 1));
+
+    return newline != NULL ? newline + 1 : reader->end;
+}
+
+void splitInputReader(InputReader *reader, int chunks, int chunk, InputReader *part) {
+    long length = reader->end - reader->position;
+
+    //Parts are never refilled or closed, they only read from the mapping
+    *part = *reader;
+
+    part->file = NULL;
+    part->buffer = NULL;
+    part->position = lineStart(reader, reader->position + length * chunk / chunks);
+    part->end = lineStart(reader, reader->position + length * (chunk + 1) / chunks);
+}
+
+void skipInputReader(InputReader *reader) {
+    while (refillBuffer(reader)) {
+    }
+
+    reader->position = reader->end;
+}
+
+void startParsing(InputReader *reader) {
+    clock_gettime(CLOCK_MONOTONIC, &reader->parseStart);
+}
+
+void stopParsing(InputReader *reader) {
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    reader->parseNanos += (end.tv_sec - reader->parseStart.tv_sec) * 1000000000L +
+                          (end.tv_nsec - reader->parseStart.tv_nsec);
+}
+
+void reportParseThroughput(FILE *outputFile, InputReader *reader) {
+    double megabytes = (double) (currentOffset(reader) - reader->startOffset) / 1e6,
+            seconds = (double) reader->parseNanos / 1e9;
+
+    fprintf(outputFile, "Parsed %.2f MB of input in %ld microseconds (%.1f MB/s, %s)\n", megabytes,
+            reader->parseNanos / 1000, seconds > 0 ? megabytes / seconds : 0.0,
+            reader->mapping != NULL ? "mapped" : "streamed");
+}
+
+void closeInputReader(InputReader *reader) {
+    if (reader->mapping != NULL) {
+        //Leave the file where we stopped reading, as if it had been read through stdio
+        fseek(reader->file, currentOffset(reader), SEEK_SET);
+
+        munmap(reader->mapping, reader->mappingSize);
+    }
+
+    free(reader->buffer);
+    free(reader);
+}
@@ -0,0 +1,102 @@
+#ifndef TRABALHO_2_READER_H
+#define TRABALHO_2_READER_H
+
+#include <stdio.h>
+#include <time.h>
+#include "rabbitsandfoxes.h"
+
+//Bytes the reader takes from the file at a time when the input can't be mapped
+#define READER_BUFFER_SIZE (1 << 20)
+
+//Write how fast the input was parsed to stderr once it is loaded
+#ifndef PRINT_PARSE_THROUGHPUT
+#define PRINT_PARSE_THROUGHPUT 0
+#endif
+
+/*
+ * Tokenizer for the input worlds.
+ *
+ * When the input is a regular file (including stdin redirected from a file) it is mapped in memory and the tokens
+ * are read straight from the mapping. Pipes can't be mapped, so they are read through a large buffer instead.
+ * Numbers are parsed by hand (no locale, no format strings) and the entity names are told apart by their first
+ * letters, so loading a world never goes through scanf.
+ *
+ * A reader can read several worlds one after the other (see loadSimulationJobStream). Once it is closed a mapped
+ * file is left positioned right after the last token that was read.
+ */
+typedef struct InputReader_ {
+
+    FILE *file;
+
+    //The bytes left to read are [position, end)
+    const char *position, *end;
+
+    //The mapping of the whole file, NULL when streaming
+    char *mapping;
+
+    size_t mappingSize;
+
+    //Offset of the start of the mapping, or of the buffer, in the file
+    long bufferOffset;
+
+    char *buffer;
+
+    //Offset in the file the reader started at, and time spent parsing since
+    long startOffset;
+
+    long parseNanos;
+
+    struct timespec parseStart;
+
+} InputReader;
+
+InputReader *openInputReader(FILE *file);
+
+/**
+ * Skip the whitespace up to the next token
+ * @return 1 when there are no tokens left
+ */
+int readerAtEnd(InputReader *reader);
+
+/**
+ * Read a decimal integer, exits when the next token is not one or does not fit in an int
+ */
+int readInteger(InputReader *reader);
+
+//Read an entity name (ROCK, FOX or RABBIT), any other name is EMPTY
+SlotContent readEntityType(InputReader *reader);
+
+/**
+ * Read an entity from a part of a mapped input, when it is alone on its line
+ * @return 1 when it was, 0 when there are no tokens left, -1 when the next line is not exactly one entity (the
+ * entity is left unread, the sequential loading has to read this input)
+ */
+int readEntityLine(InputReader *reader, SlotContent *content, int *row, int *col);
+
+//1 when the input is mapped, so it can be split in parts that are read at the same time
+int isInputMapped(InputReader *reader);
+
+//Bytes of a mapped input left to read
+long mappedBytesLeft(InputReader *reader);
+
+/**
+ * Set part up to read the given chunk of the rest of a mapped input. The chunks are split at the start of a line
+ * and together cover the whole rest of the input, the reader itself is left as it was. A chunk can only be read on
+ * its own when every entity is on a line of its own (see readEntityLine)
+ */
+void splitInputReader(InputReader *reader, int chunks, int chunk, InputReader *part);
+
+//Mark the rest of the input as read
+void skipInputReader(InputReader *reader);
+
+//Time the parsing between these calls, so the throughput does not count allocating and setting up the world
+void startParsing(InputReader *reader);
+
+void stopParsing(InputReader *reader);
+
+//Write how many bytes were parsed and how fast
+void reportParseThroughput(FILE *outputFile, InputReader *reader);
+
+void closeInputReader(InputReader *reader);
+
+#endif //TRABALHO_2_READER_H
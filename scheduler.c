@@ -0,0 +1,335 @@
+#include "scheduler.h"
+#include "movements.h"
+#include "timers.h"
+#include <stdlib.h>
+#include <time.h>
+
+typedef enum TaskPass_ {
+
+    MOVE_RABBITS,
+    RESOLVE_RABBITS,
+    MOVE_FOXES,
+    RESOLVE_FOXES
+
+} TaskPass;
+
+//The phase the tasks of every pass are timed as
+static const TimedPhase PASS_PHASES[] = {
+        [MOVE_RABBITS] = PHASE_RABBITS,
+        [RESOLVE_RABBITS] = PHASE_CONFLICTS,
+        [MOVE_FOXES] = PHASE_FOXES,
+        [RESOLVE_FOXES] = PHASE_CONFLICTS
+};
+
+static long elapsedNanos(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1000000000L + (end->tv_nsec - start->tv_nsec);
+}
+
+static struct TileScheduler *createTileScheduler(int threadCount) {
+    struct TileScheduler *scheduler = malloc(sizeof(struct TileScheduler));
+
+    scheduler->tileSize = 0;
+    scheduler->tileRows = 0;
+    scheduler->tileColumns = 0;
+    scheduler->tileCount = 0;
+    scheduler->tiles = NULL;
+    scheduler->tileConflicts = NULL;
+    scheduler->tileCapacity = 0;
+    scheduler->conflictCapacity = 0;
+    scheduler->conflictPool = NULL;
+    scheduler->threadCount = threadCount;
+
+    scheduler->deques = allocateCacheAligned(sizeof(TaskDeque) * threadCount);
+
+    for (int thread = 0; thread < threadCount; thread++) {
+        pthread_mutex_init(&scheduler->deques[thread].lock, NULL);
+    }
+
+    return scheduler;
+}
+
+void prepareTileScheduler(InputData *worldData, struct ThreadedData *threadSystem) {
+    if (threadSystem->scheduler == NULL) {
+        threadSystem->scheduler = createTileScheduler(threadSystem->threadCount);
+    }
+
+    struct TileScheduler *scheduler = threadSystem->scheduler;
+
+    int tileSize = threadSystem->taskTileSize;
+
+    scheduler->tileSize = tileSize;
+    scheduler->tileRows = (worldData->rows + tileSize - 1) / tileSize;
+    scheduler->tileColumns = (worldData->columns + tileSize - 1) / tileSize;
+    scheduler->tileCount = scheduler->tileRows * scheduler->tileColumns;
+
+    if (scheduler->tileCount > scheduler->tileCapacity) {
+        scheduler->tileCapacity = scheduler->tileCount;
+
+        scheduler->tiles = realloc(scheduler->tiles, sizeof(ThreadRowData) * scheduler->tileCapacity);
+        scheduler->tileConflicts = realloc(scheduler->tileConflicts, sizeof(Conflicts) * scheduler->tileCapacity);
+
+        //Force the conflict lists to be laid out again for the new tiles
+        scheduler->conflictCapacity = 0;
+    }
+
+    //Every slot on the edge of a tile can make at most one move out of the tile in each direction
+    if (tileSize > scheduler->conflictCapacity) {
+        scheduler->conflictCapacity = tileSize;
+
+        scheduler->conflictPool = realloc(scheduler->conflictPool,
+                                          sizeof(Conflict) * 4 * scheduler->conflictCapacity * scheduler->tileCapacity);
+
+        for (int tile = 0; tile < scheduler->tileCapacity; tile++) {
+            for (int direction = 0; direction < 4; direction++) {
+                scheduler->tileConflicts[tile].conflicts[direction] =
+                        &scheduler->conflictPool[(tile * 4 + direction) * scheduler->conflictCapacity];
+            }
+        }
+    }
+
+    for (int tile = 0; tile < scheduler->tileCount; tile++) {
+        int tileRow = tile / scheduler->tileColumns, tileColumn = tile % scheduler->tileColumns;
+
+        ThreadRowData *tileSlots = &scheduler->tiles[tile];
+
+        tileSlots->startRow = tileRow * tileSize;
+        tileSlots->endRow = (tileRow + 1) * tileSize < worldData->rows ? (tileRow + 1) * tileSize - 1 : worldData->rows - 1;
+        tileSlots->startCol = tileColumn * tileSize;
+        tileSlots->endCol = (tileColumn + 1) * tileSize < worldData->columns ? (tileColumn + 1) * tileSize - 1 : worldData->columns - 1;
+    }
+
+    for (int thread = 0; thread < scheduler->threadCount; thread++) {
+        TaskDeque *deque = &scheduler->deques[thread];
+
+        deque->top = 0;
+        deque->bottom = 0;
+        deque->pass = 0;
+        deque->busyNanos = 0;
+        deque->totalNanos = 0;
+        deque->tasksRun = 0;
+        deque->tasksStolen = 0;
+    }
+}
+
+//The tile next to the given one in the given direction, -1 if the tile is at the edge of the world
+static int neighbourTileInDirection(struct TileScheduler *scheduler, int tile, MoveDirection direction) {
+    int tileRow = tile / scheduler->tileColumns, tileColumn = tile % scheduler->tileColumns;
+
+    switch (direction) {
+        case NORTH:
+            return tileRow > 0 ? tile - scheduler->tileColumns : -1;
+        case SOUTH:
+            return tileRow < scheduler->tileRows - 1 ? tile + scheduler->tileColumns : -1;
+        case WEST:
+            return tileColumn > 0 ? tile - 1 : -1;
+        case EAST:
+            return tileColumn < scheduler->tileColumns - 1 ? tile + 1 : -1;
+        default:
+            return -1;
+    }
+}
+
+//Fill our deque with our share of the tiles for the next pass
+static int startPass(int threadNumber, int threadCount, struct TileScheduler *scheduler) {
+    TaskDeque *deque = &scheduler->deques[threadNumber];
+
+    pthread_mutex_lock(&deque->lock);
+
+    deque->top = (int) ((long) threadNumber * scheduler->tileCount / threadCount);
+    deque->bottom = (int) ((long) (threadNumber + 1) * scheduler->tileCount / threadCount);
+    deque->pass++;
+
+    int pass = deque->pass;
+
+    pthread_mutex_unlock(&deque->lock);
+
+    return pass;
+}
+
+//Take a tile from a deque, from the bottom when we own it and from the top when we're stealing it. -1 when the
+//deque has no tiles left for this pass (a deque whose owner has not started the pass yet has none either)
+static int takeTask(TaskDeque *deque, int pass, int stealing) {
+    int tile = -1;
+
+    pthread_mutex_lock(&deque->lock);
+
+    if (deque->pass == pass && deque->top < deque->bottom) {
+        tile = stealing ? deque->top++ : --deque->bottom;
+    }
+
+    pthread_mutex_unlock(&deque->lock);
+
+    return tile;
+}
+
+static int findTask(int threadNumber, int threadCount, int pass, struct TileScheduler *scheduler) {
+    int tile = takeTask(&scheduler->deques[threadNumber], pass, 0);
+
+    if (tile >= 0) return tile;
+
+    for (int offset = 1; offset < threadCount; offset++) {
+        tile = takeTask(&scheduler->deques[(threadNumber + offset) % threadCount], pass, 1);
+
+        if (tile >= 0) {
+            scheduler->deques[threadNumber].tasksStolen++;
+
+            return tile;
+        }
+    }
+
+    return -1;
+}
+
+static void runTileTask(int threadNumber, int tile, TaskPass taskPass, int genNumber, InputData *simulationData,
+                        struct ThreadedData *threadedData, WorldSlot *frontWorld, WorldSlot *backWorld) {
+
+    struct TileScheduler *scheduler = threadedData->scheduler;
+
+    ThreadRowData *tileSlots = &scheduler->tiles[tile];
+
+    //The scheduler does not rebalance, so the tiles don't count their entities
+    struct ThreadConflictData region = {
+            .threadNum = threadNumber,
+            .startRow = tileSlots->startRow, .endRow = tileSlots->endRow,
+            .startCol = tileSlots->startCol, .endCol = tileSlots->endCol,
+            .inputData = simulationData,
+            .world = backWorld,
+            .threadedData = threadedData,
+            .entitiesPerRow = NULL, .entitiesPerColumn = NULL
+    };
+
+    Conflicts *tileConflicts = &scheduler->tileConflicts[tile];
+
+    switch (taskPass) {
+        case MOVE_RABBITS:
+        case MOVE_FOXES:
+            for (int direction = 0; direction < 4; direction++) {
+                tileConflicts->count[direction] = 0;
+            }
+
+            if (taskPass == MOVE_RABBITS) {
+                moveRabbitsInRegion(genNumber, &region, frontWorld, threadedData->rabbitMovementsPerThread[threadNumber],
+                                    tileConflicts);
+            } else {
+                moveFoxesInRegion(genNumber, &region, frontWorld, threadedData->foxMovementsPerThread[threadNumber],
+                                  tileConflicts);
+            }
+            break;
+        case RESOLVE_RABBITS:
+        case RESOLVE_FOXES:
+            for (int direction = 0; direction < 4; direction++) {
+                int neighbour = neighbourTileInDirection(scheduler, tile, (MoveDirection) direction);
+
+                if (neighbour < 0) continue;
+
+                //The neighbour's moves into our tile are the ones it made in the direction that goes back to us
+                MoveDirection towardsUs = (MoveDirection) ((direction + 2) % 4);
+
+                Conflicts *neighbourConflicts = &scheduler->tileConflicts[neighbour];
+
+                resolveThreadConflicts(&region, neighbourConflicts->count[towardsUs],
+                                       neighbourConflicts->conflicts[towardsUs]);
+            }
+            break;
+    }
+}
+
+//Run every task of a pass we can get our hands on, then wait for the rest of the threads to finish theirs
+static void runPass(int threadNumber, TaskPass taskPass, int genNumber, InputData *simulationData,
+                    struct ThreadedData *threadedData, WorldSlot *frontWorld, WorldSlot *backWorld) {
+
+    struct TileScheduler *scheduler = threadedData->scheduler;
+
+    TaskDeque *ourDeque = &scheduler->deques[threadNumber];
+
+    long passStart = readPhaseClock(threadedData->timers, threadNumber), passBusy = 0;
+
+    int pass = startPass(threadNumber, simulationData->threads, scheduler);
+
+    int tile;
+
+    PhaseCounters *counters = threadedData->timers != NULL ? threadedData->timers->counters : NULL;
+
+    while ((tile = findTask(threadNumber, simulationData->threads, pass, scheduler)) >= 0) {
+        struct timespec start, end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        runTileTask(threadNumber, tile, taskPass, genNumber, simulationData, threadedData, frontWorld, backWorld);
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        passBusy += elapsedNanos(&start, &end);
+        ourDeque->tasksRun++;
+    }
+
+    ourDeque->busyNanos += passBusy;
+
+    //Reading the counters around every task costs more than the smaller tasks, so the events of looking for the
+    //tasks go to the pass, and only the barrier's to the waits
+    if (counters != NULL) {
+        countPhaseEvents(counters, threadNumber, PASS_PHASES[ taskPass ]);
+    }
+
+    //The next pass reads the slots and conflicts every tile wrote in this one
+    pthread_barrier_wait(&threadedData->barrier);
+
+    if (threadedData->timers != NULL) {
+        //The time outside of the tasks went to looking for them and waiting for the other threads
+        long passNanos = monotonicNanos() - passStart;
+
+        addPhaseNanos(threadedData->timers, threadNumber, genNumber, PASS_PHASES[ taskPass ], passBusy);
+        addPhaseNanos(threadedData->timers, threadNumber, genNumber, PHASE_WAITS, passNanos - passBusy);
+
+        if (counters != NULL) {
+            countPhaseEvents(counters, threadNumber, PHASE_WAITS);
+        }
+    }
+}
+
+void executeScheduledGeneration(int threadNumber, int genNumber, InputData *simulationData,
+                                struct ThreadedData *threadedData, WorldSlot *world, WorldSlot *backWorld) {
+
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    runPass(threadNumber, MOVE_RABBITS, genNumber, simulationData, threadedData, world, backWorld);
+    runPass(threadNumber, RESOLVE_RABBITS, genNumber, simulationData, threadedData, world, backWorld);
+
+    runPass(threadNumber, MOVE_FOXES, genNumber, simulationData, threadedData, backWorld, world);
+    runPass(threadNumber, RESOLVE_FOXES, genNumber, simulationData, threadedData, backWorld, world);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    threadedData->scheduler->deques[threadNumber].totalNanos += elapsedNanos(&start, &end);
+}
+
+void reportTileSchedulerTimes(FILE *outputFile, int threadCount, struct TileScheduler *scheduler) {
+    fprintf(outputFile, "Tile scheduler: %d tiles of %dx%d\n", scheduler->tileCount, scheduler->tileSize,
+            scheduler->tileSize);
+
+    for (int thread = 0; thread < threadCount; thread++) {
+        TaskDeque *deque = &scheduler->deques[thread];
+
+        fprintf(outputFile, "Thread %d: busy %ld microseconds, idle %ld microseconds, %d tasks (%d stolen)\n",
+                thread, deque->busyNanos / 1000, (deque->totalNanos - deque->busyNanos) / 1000,
+                deque->tasksRun, deque->tasksStolen);
+    }
+}
+
+void destroyTileScheduler(struct TileScheduler *scheduler) {
+    if (scheduler == NULL) {
+        return;
+    }
+
+    for (int thread = 0; thread < scheduler->threadCount; thread++) {
+        pthread_mutex_destroy(&scheduler->deques[thread].lock);
+    }
+
+    free(scheduler->deques);
+    free(scheduler->tiles);
+    free(scheduler->tileConflicts);
+    free(scheduler->conflictPool);
+    free(scheduler);
+}
@@ -0,0 +1,89 @@
+#ifndef TRABALHO_2_SCHEDULER_H
+#define TRABALHO_2_SCHEDULER_H
+
+#include <stdio.h>
+#include "threads.h"
+
+//Default size of the side of the tiles the task scheduler cuts the world in
+#define DEFAULT_TASK_TILE_SIZE 32
+
+/*
+ * Work stealing tile scheduler (PARTITION_STEALING).
+ *
+ * The world is cut in tiles of a fixed size and every phase is split in two passes of tasks, one task per tile:
+ * the move pass moves the entities of the tile into the back buffer (the moves that leave the tile are stored in
+ * the conflict lists of the tile) and the resolve pass resolves the moves the neighbouring tiles made into the tile.
+ * A pass only writes the slots of its own tile, and every entity lands where it would in the sequential
+ * simulation whatever the order the conflicts are resolved in, so the results don't depend on which thread runs
+ * which task.
+ *
+ * At the start of a pass every thread gets a contiguous range of tiles in its deque. It takes its tasks from the
+ * bottom of its deque and, once it runs out, steals from the top of the deques of the other threads, so a thread
+ * whose tiles are crowded is helped by the others instead of making them wait at the barrier.
+ */
+
+//The deques are aligned to the cache lines, so the owner counting its tasks doesn't slow down the thieves of the
+//deques next to its own
+typedef struct TaskDeque_ {
+
+    _Alignas(CACHE_LINE_SIZE) pthread_mutex_t lock;
+
+    //The tiles left in the deque are [top, bottom)
+    int top, bottom;
+
+    //Pass the tiles in the deque belong to. Only thieves in the same pass can take them
+    int pass;
+
+    //Time the owner spent running tasks, and in the scheduled generations overall, during the last simulation
+    long busyNanos, totalNanos;
+
+    int tasksRun, tasksStolen;
+
+} TaskDeque;
+
+struct TileScheduler {
+
+    int tileSize;
+
+    int tileRows, tileColumns, tileCount;
+
+    //The slots covered by every tile
+    ThreadRowData *tiles;
+
+    //The moves that leave every tile, indexed by the MoveDirection they leave it in
+    Conflicts *tileConflicts;
+
+    //Tiles and conflicts per tile list the arrays can hold
+    int tileCapacity, conflictCapacity;
+
+    Conflict *conflictPool;
+
+    //One per thread of the threading system
+    TaskDeque *deques;
+
+    int threadCount;
+};
+
+/**
+ * Cut the world in tiles and get the deques of every thread of the threading system ready, a simulation can run on
+ * any number of them (the passes are split between worldData->threads).
+ * Must only be called while no thread is using the threading system
+ */
+void prepareTileScheduler(InputData *worldData, struct ThreadedData *threadSystem);
+
+/**
+ * Perform a generation of the world with the tasks of the tile scheduler. Every thread of the simulation must call it.
+ * Like executeParallelGeneration, the new state ends up in world
+ */
+void executeScheduledGeneration(int threadNumber, int genNumber, InputData *simulationData,
+                                struct ThreadedData *threadedData, WorldSlot *world, WorldSlot *backWorld);
+
+/**
+ * Write how long every thread was busy running tasks and how long it was idle (looking for tasks to steal or
+ * waiting for the others at the end of the passes) during the last simulation
+ */
+void reportTileSchedulerTimes(FILE *outputFile, int threadCount, struct TileScheduler *scheduler);
+
+void destroyTileScheduler(struct TileScheduler *scheduler);
+
+#endif //TRABALHO_2_SCHEDULER_H
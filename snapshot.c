@@ -0,0 +1,189 @@
+#include "snapshot.h"
+#include "output.h"
+#include "occupancy.h"
+#include "movements.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+int isWorldSnapshot(FILE *file) {
+    long offset = ftell(file);
+
+    char magic[sizeof(((SnapshotHeader *) NULL)->magic)];
+
+    int snapshot = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                   memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+
+    fseek(file, offset, SEEK_SET);
+
+    return snapshot;
+}
+
+static void checkSnapshotHeader(SnapshotHeader *header) {
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        fprintf(stderr, "ERROR: The input is not a world snapshot\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (header->version != SNAPSHOT_VERSION) {
+        fprintf(stderr, "ERROR: Snapshot version %u is not supported (expected %d)\n", header->version,
+                SNAPSHOT_VERSION);
+        exit(EXIT_FAILURE);
+    }
+
+    if (header->slotSize != sizeof(WorldSlot) || header->byteOrder != SNAPSHOT_BYTE_ORDER) {
+        fprintf(stderr, "ERROR: The snapshot was written by a build with a different slot layout\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (header->rows <= 0 || header->columns <= 0 ||
+        header->bodySize != WORLD_MATRIX_SIZE(header->rows, header->columns)) {
+        fprintf(stderr, "ERROR: The snapshot of a %dx%d world has a body of %llu bytes\n", header->rows,
+                header->columns, (unsigned long long) header->bodySize);
+        exit(EXIT_FAILURE);
+    }
+
+    if (header->generation < 0 || header->generation > header->n_gen) {
+        fprintf(stderr, "ERROR: The snapshot was taken at generation %d of %d\n", header->generation, header->n_gen);
+        exit(EXIT_FAILURE);
+    }
+}
+
+//The planes are part of the snapshot, so the counts come from them instead of the slots
+static void restoreEntityDistribution(InputData *simulationData, WorldSlot *world) {
+    int accumulated = 0, rocks = 0;
+
+    for (int row = 0; row < simulationData->rows; row++) {
+        const uint64_t *occupied = occupancyRow(simulationData, world, row), *rockWords = rockRow(simulationData, world, row);
+
+        int entities = 0;
+
+        for (int word = 0; word < OCCUPANCY_WORDS(simulationData->columns); word++) {
+            entities += __builtin_popcountll(occupied[ word ]);
+            rocks += __builtin_popcountll(rockWords[ word ]);
+        }
+
+        accumulated += entities;
+
+        simulationData->entitiesPerRow[ row ] = entities;
+        simulationData->entitiesAccumulatedPerRow[ row ] = accumulated;
+    }
+
+    simulationData->rocks = rocks;
+    simulationData->initialPopulation = accumulated + rocks;
+
+    calculateWorldTopology(simulationData, world);
+}
+
+InputData *readWorldSnapshot(FILE *file, WorldSlot **world) {
+    SnapshotHeader header;
+
+    struct stat fileStatus;
+
+    long offset = ftell(file);
+
+    char *mapping = NULL;
+
+    size_t mappingSize = 0;
+
+    if (offset >= 0 && fstat(fileno(file), &fileStatus) == 0 && S_ISREG(fileStatus.st_mode) &&
+        fileStatus.st_size >= offset + (long) sizeof(SnapshotHeader)) {
+
+        mapping = mmap(NULL, fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+
+        if (mapping == MAP_FAILED) {
+            mapping = NULL;
+        } else {
+            mappingSize = fileStatus.st_size;
+        }
+    }
+
+    if (mapping != NULL) {
+        memcpy(&header, mapping + offset, sizeof(SnapshotHeader));
+    } else if (fread(&header, sizeof(SnapshotHeader), 1, file) != 1) {
+        fprintf(stderr, "ERROR: The input is too short to be a world snapshot\n");
+        exit(EXIT_FAILURE);
+    }
+
+    checkSnapshotHeader(&header);
+
+    InputData parameters = {
+            .gen_proc_rabbits = header.gen_proc_rabbits,
+            .gen_proc_foxes = header.gen_proc_foxes,
+            .gen_food_foxes = header.gen_food_foxes,
+            .n_gen = header.n_gen,
+            .rows = header.rows,
+            .columns = header.columns
+    };
+
+    InputData *simulationData = createSimulationData(&parameters);
+
+    simulationData->firstGeneration = header.generation;
+
+    *world = initializeWorldMatrix(simulationData);
+
+    if (mapping != NULL) {
+        size_t bodyOffset = offset + sizeof(SnapshotHeader);
+
+        if (mappingSize - bodyOffset < header.bodySize) {
+            fprintf(stderr, "ERROR: The world snapshot is truncated\n");
+            exit(EXIT_FAILURE);
+        }
+
+        memcpy(*world, mapping + bodyOffset, header.bodySize);
+
+        munmap(mapping, mappingSize);
+
+        fseek(file, (long) (bodyOffset + header.bodySize), SEEK_SET);
+    } else if (fread(*world, 1, header.bodySize, file) != header.bodySize) {
+        fprintf(stderr, "ERROR: The world snapshot is truncated\n");
+        exit(EXIT_FAILURE);
+    }
+
+    restoreEntityDistribution(simulationData, *world);
+
+    return simulationData;
+}
+
+void writeWorldSnapshot(FILE *file, InputData *simulationData, WorldSlot *world, int generation) {
+    SnapshotHeader header;
+
+    memset(&header, 0, sizeof(SnapshotHeader));
+
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+
+    header.version = SNAPSHOT_VERSION;
+    header.slotSize = sizeof(WorldSlot);
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.gen_proc_rabbits = simulationData->gen_proc_rabbits;
+    header.gen_proc_foxes = simulationData->gen_proc_foxes;
+    header.gen_food_foxes = simulationData->gen_food_foxes;
+    header.n_gen = simulationData->n_gen;
+    header.generation = generation;
+    header.rows = simulationData->rows;
+    header.columns = simulationData->columns;
+    header.bodySize = WORLD_MATRIX_SIZE(simulationData->rows, simulationData->columns);
+
+    if (fwrite(&header, sizeof(SnapshotHeader), 1, file) != 1 ||
+        fwrite(world, 1, header.bodySize, file) != header.bodySize) {
+        fprintf(stderr, "ERROR: Failed to write the world snapshot\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void saveWorldSnapshot(const char *path, InputData *simulationData, WorldSlot *world, int generation) {
+    FILE *file = fopen(path, "wb");
+
+    if (file == NULL) {
+        fprintf(stderr, "ERROR: Failed to open snapshot file %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    writeWorldSnapshot(file, simulationData, world, generation);
+
+    if (fclose(file) != 0) {
+        fprintf(stderr, "ERROR: Failed to write the world snapshot to %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+}
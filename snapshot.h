@@ -0,0 +1,88 @@
+#ifndef TRABALHO_2_SNAPSHOT_H
+#define TRABALHO_2_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "rabbitsandfoxes.h"
+
+/*
+ * Binary world snapshots.
+ *
+ * A snapshot is a SnapshotHeader followed by the whole world buffer as it is in memory: the slots (so the age and
+ * the food of every animal are kept, and a world can be saved in the middle of a simulation) and then the occupancy
+ * planes (see occupancy.h). Loading one is a single copy from the mapped file, there is nothing to parse, and only
+ * the per row counts and the topology are rebuilt from the planes.
+ *
+ * The body is only readable by a build with the same slot layout and byte order as the one that wrote it, both are
+ * stored in the header and checked when the snapshot is read. Any change to the layout of the body must bump
+ * SNAPSHOT_VERSION.
+ */
+
+#define SNAPSHOT_MAGIC "ECOWORLD"
+
+#define SNAPSHOT_VERSION 1
+
+//Read back in the byte order of the reader, it only matches when the writer used the same order
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+typedef struct SnapshotHeader_ {
+
+    char magic[8];
+
+    uint32_t version;
+
+    //sizeof(WorldSlot) and SNAPSHOT_BYTE_ORDER of the build that wrote the snapshot
+    uint32_t slotSize, byteOrder;
+
+    int32_t gen_proc_rabbits, gen_proc_foxes, gen_food_foxes;
+
+    int32_t n_gen;
+
+    //Generations already simulated, the simulation goes on from here
+    int32_t generation;
+
+    int32_t rows, columns;
+
+    //Bytes of the world buffer after the header, WORLD_MATRIX_SIZE(rows, columns)
+    uint64_t bodySize;
+
+} SnapshotHeader;
+
+/**
+ * What a simulation reads and writes as snapshots
+ */
+typedef struct SnapshotOptions_ {
+
+    //The input is a snapshot instead of a text world
+    int binaryInput;
+
+    //When not NULL the world is also written here as a snapshot once it is simulated
+    const char *outputPath;
+
+    //When checkpointInterval is not 0 the world is written to checkpointPath every checkpointInterval generations
+    //(see checkpoint.h)
+    const char *checkpointPath;
+
+    int checkpointInterval;
+
+} SnapshotOptions;
+
+//1 when the next bytes of the file are the start of a snapshot, the file is left where it was
+int isWorldSnapshot(FILE *file);
+
+/**
+ * Load a world from a snapshot, its firstGeneration is the generation the snapshot was taken at. The file is
+ * mapped when it can be, and left right after the snapshot. Exits when the file is not a snapshot this build can read
+ * @param world Set to the world buffer
+ */
+InputData *readWorldSnapshot(FILE *file, WorldSlot **world);
+
+/**
+ * Write a world, after the given number of generations were simulated, as a snapshot
+ */
+void writeWorldSnapshot(FILE *file, InputData *simulationData, WorldSlot *world, int generation);
+
+//Same as writeWorldSnapshot, to a new file at path
+void saveWorldSnapshot(const char *path, InputData *simulationData, WorldSlot *world, int generation);
+
+#endif //TRABALHO_2_SNAPSHOT_H
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""
+Conflict Synchronization Microbenchmark
+
+Usage: sync_benchmark.py [input size] [--rebalance], e.g. sync_benchmark.py 100x100
+
+Compares the CPU time (user + sys) and the wall time of the simulation when the threads wait for their
+neighbours' conflicts with the bounded spin followed by a blocking wait (the default build) and when they
+busy wait on sem_trywait (built with CONFLICT_SPIN_LIMIT=-1).
+
+With the busy wait every waiting thread burns a core, so the CPU time grows past wall time x useful threads
+as soon as there are more threads than free cores.
+
+With --rebalance it instead compares the time the threads spend accumulating the entity counts per row and
+rebalancing, with the two pass parallel scan (the default build) and with the counts passed down the threads
+like a token (built with PREFIX_SUM_CHAIN).
+"""
+
+import os
+import re
+import subprocess
+import sys
+import time
+
+# Configuration
+INPUT_SIZE = '200x200'
+THREAD_COUNTS = [8, 16, 32]
+RUNS = 3
+ECOSYSTEM_DIR = 'ecosystem_examples'
+VARIANTS = {
+    'spin-then-park': ('./ecosystem_park', []),
+    'busy-spin': ('./ecosystem_busyspin', ['-DCONFLICT_SPIN_LIMIT=-1']),
+}
+REBALANCE_THREAD_COUNTS = [16, 32, 64]
+REBALANCE_VARIANTS = {
+    'two-pass scan': ('./ecosystem_scan', ['-DPRINT_REBALANCE_TIME=1']),
+    'token chain': ('./ecosystem_chain', ['-DPRINT_REBALANCE_TIME=1', '-DPREFIX_SUM_CHAIN']),
+}
+
+
+def build(executable, flags):
+    """Build the simulation through the makefile, with the given extra compiler flags"""
+    result = subprocess.run(['make', 'all', 'ARGS=' + ' '.join(['-Wall'] + flags), 'OUTPUT=' + executable],
+                            capture_output=True, text=True)
+    if result.returncode != 0:
+        print(f"Build of {executable} failed: {result.stderr}")
+        sys.exit(1)
+
+
+def run_once(executable, input_file, thread_count):
+    """Run the simulation once and return (wall, user + sys) in seconds"""
+    with open(input_file, 'r') as f:
+        start = time.perf_counter()
+        process = subprocess.Popen([executable, str(thread_count)], stdin=f,
+                                   stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        _, status, usage = os.wait4(process.pid, 0)
+        wall = time.perf_counter() - start
+
+    if status != 0:
+        print(f"\n{executable} exited with status {status}")
+        return None
+
+    return wall, usage.ru_utime + usage.ru_stime
+
+
+def run_rebalance_once(executable, input_file, thread_count):
+    """Run the simulation once and return the microseconds each thread spent rebalancing"""
+    with open(input_file, 'r') as f:
+        result = subprocess.run([executable, str(thread_count)], stdin=f,
+                                stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True)
+
+    match = re.search(r'Rebalancing took (\d+) microseconds', result.stderr)
+
+    if result.returncode != 0 or match is None:
+        print(f"\n{executable} failed: {result.stderr}")
+        return None
+
+    return int(match.group(1))
+
+
+def benchmark_rebalance(input_size, input_file):
+    for executable, flags in REBALANCE_VARIANTS.values():
+        build(executable, flags)
+
+    print(f"Entity count accumulation and rebalance on {input_size}, best of {RUNS} runs")
+    print(f"{'variant':>16} {'threads':>8} {'per thread (us)':>16}")
+
+    for thread_count in REBALANCE_THREAD_COUNTS:
+        for name, (executable, _) in REBALANCE_VARIANTS.items():
+            results = [run_rebalance_once(executable, input_file, thread_count) for _ in range(RUNS)]
+            results = [result for result in results if result is not None]
+
+            if results:
+                print(f"{name:>16} {thread_count:>8} {min(results):>16}")
+
+    for executable, _ in REBALANCE_VARIANTS.values():
+        os.remove(executable)
+
+
+def main():
+    arguments = [argument for argument in sys.argv[1:] if not argument.startswith('--')]
+    input_size = arguments[0] if arguments else INPUT_SIZE
+    input_file = f"{ECOSYSTEM_DIR}/input{input_size}"
+    cores = os.cpu_count()
+
+    if '--rebalance' in sys.argv:
+        benchmark_rebalance(input_size, input_file)
+        return
+
+    for executable, flags in VARIANTS.values():
+        build(executable, flags)
+
+    print(f"Conflict synchronization on {input_size}, {cores} core(s), best of {RUNS} runs")
+    print(f"{'variant':>16} {'threads':>8} {'wall (s)':>10} {'cpu (s)':>10} {'cpu/wall':>9}")
+
+    for thread_count in THREAD_COUNTS:
+        for name, (executable, _) in VARIANTS.items():
+            results = [run_once(executable, input_file, thread_count) for _ in range(RUNS)]
+            results = [result for result in results if result is not None]
+
+            if not results:
+                continue
+
+            wall, cpu = min(results)
+            print(f"{name:>16} {thread_count:>8} {wall:>10.3f} {cpu:>10.3f} {cpu / wall:>9.2f}")
+
+    for executable, _ in VARIANTS.values():
+        os.remove(executable)
+
+
+if __name__ == "__main__":
+    main()
@@ -1,37 +1,243 @@
 
 #include "threads.h"
+#include "scheduler.h"
+#include "bitboard.h"
+#include "occupancy.h"
+#include "movements.h"
+#include "matrix_utils.h"
 #include <stdlib.h>
 #include "semaphore.h"
 #include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+void *allocateCacheAligned(size_t size) {
+    //aligned_alloc wants a multiple of the alignment, which also keeps the end of the memory off shared lines
+    size_t lines = (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE;
+
+    void *memory = aligned_alloc(CACHE_LINE_SIZE, (lines > 0 ? lines : 1) * CACHE_LINE_SIZE);
+
+    if (memory == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate %zu bytes aligned to the cache lines\n", size);
+        exit(EXIT_FAILURE);
+    }
+
+    return memory;
+}
 
 void initializeThreadingSystem(int threadCount, InputData *worldData, struct ThreadedData *threadSystem) {
     // Allocate thread management arrays
     threadSystem->threads = malloc(sizeof(pthread_t) * threadCount);
-    threadSystem->conflictPerThreads = malloc(sizeof(Conflicts *) * threadCount);
-    threadSystem->threadSemaphores = malloc(sizeof(sem_t) * threadCount);
-    threadSystem->precedingSemaphores = malloc(sizeof(sem_t) * threadCount);
+    threadSystem->workers = allocateCacheAligned(sizeof(WorkerBlock) * threadCount);
+    threadSystem->rabbitMovementsPerThread = malloc(sizeof(struct RabbitMovements *) * threadCount);
+    threadSystem->foxMovementsPerThread = malloc(sizeof(struct FoxMovements *) * threadCount);
+
+    threadSystem->threadCount = threadCount;
+
+    threadSystem->syncMode = SYNC_BARRIER;
+    threadSystem->rebalanceInterval = 1;
+
+    threadSystem->partitionMode = PARTITION_BANDS;
+    threadSystem->tileRows = threadCount;
+    threadSystem->tileColumns = 1;
+
+    // The entity counts per thread are only needed when several threads count, they are allocated when a world is
+    // prepared for them
+    threadSystem->entitiesPerRowPerThread = calloc(threadCount, sizeof(int *));
+    threadSystem->entitiesPerColumnPerThread = calloc(threadCount, sizeof(int *));
+    threadSystem->entitiesPerColumn = NULL;
+    threadSystem->entitiesAccumulatedPerColumn = NULL;
+    threadSystem->countRowCapacity = 0;
+    threadSystem->countColumnCapacity = 0;
+
+    threadSystem->taskTileSize = DEFAULT_TASK_TILE_SIZE;
+    threadSystem->scheduler = NULL;
+
+    // The neighbour masks are created when a world is prepared in bitboard mode
+    threadSystem->analysisMode = ANALYSIS_SCALAR;
+    threadSystem->bitboardKernel = BITBOARD_AUTO;
+    threadSystem->neighbourMasksPerThread = calloc(threadCount, sizeof(NeighbourMasks *));
+
+    threadSystem->timers = NULL;
+
+    threadSystem->rowGroupCount = 0;
+    threadSystem->rowGroupThreads = NULL;
 
     // Initialize thread synchronization barrier
     pthread_barrier_init(&threadSystem->barrier, NULL, threadCount);
+    threadSystem->barrierThreads = threadCount;
+
+    // The conflict arrays are sized by the world width, a world might not be known yet (see prepareThreadingSystem)
+    threadSystem->conflictCapacity = worldData != NULL ? worldData->columns : 0;
+    threadSystem->sideConflictCapacity = 0;
 
     // Initialize each thread's conflict management and synchronization
     for (int threadIndex = 0; threadIndex < threadCount; threadIndex++) {
-        // Allocate conflict storage for this thread
-        threadSystem->conflictPerThreads[threadIndex] = malloc(sizeof(Conflicts));
-        Conflicts *threadConflicts = threadSystem->conflictPerThreads[threadIndex];
-        
+        WorkerBlock *worker = &threadSystem->workers[threadIndex];
+
+        // Conflict storage for this thread
+        Conflicts *threadConflicts = &worker->conflicts;
+
         // Initialize conflict counters
-        threadConflicts->aboveCount = 0;
-        threadConflicts->bellowCount = 0;
-        
-        // Allocate conflict arrays (size based on world width)
-        threadConflicts->above = malloc(sizeof(Conflict) * worldData->columns);
-        threadConflicts->bellow = malloc(sizeof(Conflict) * worldData->columns);
+        for (int direction = 0; direction < 4; direction++) {
+            threadConflicts->count[direction] = 0;
+        }
+
+        // Allocate conflict arrays (size based on world width, the sides are only used by tiles)
+        threadConflicts->conflicts[NORTH] = malloc(sizeof(Conflict) * threadSystem->conflictCapacity);
+        threadConflicts->conflicts[SOUTH] = malloc(sizeof(Conflict) * threadSystem->conflictCapacity);
+        threadConflicts->conflicts[EAST] = NULL;
+        threadConflicts->conflicts[WEST] = NULL;
+
+        // Movement analysis scratch space, reused by every generation
+        threadSystem->rabbitMovementsPerThread[threadIndex] = createRabbitMovementContext();
+        threadSystem->foxMovementsPerThread[threadIndex] = createFoxMovementContext();
 
         // Initialize semaphores for thread coordination
-        sem_init(&threadSystem->threadSemaphores[threadIndex], 0, 0);
-        sem_init(&threadSystem->precedingSemaphores[threadIndex], 0, 0);
+        sem_init(&worker->conflictsReady, 0, 0);
+        sem_init(&worker->countsReady, 0, 0);
+
+        worker->phaseCounter.phase = 0;
+        worker->bandTotal = 0;
+        worker->rebalanceNanos = 0;
+        pthread_mutex_init(&worker->phaseCounter.lock, NULL);
+        pthread_cond_init(&worker->phaseCounter.advanced, NULL);
+    }
+}
+
+void setThreadSynchronization(SyncMode syncMode, int rebalanceInterval, struct ThreadedData *threadSystem) {
+    threadSystem->syncMode = syncMode;
+    threadSystem->rebalanceInterval = rebalanceInterval > 0 ? rebalanceInterval : 1;
+}
+
+void setThreadPartitioning(PartitionMode partitionMode, struct ThreadedData *threadSystem) {
+    threadSystem->partitionMode = partitionMode;
+}
+
+void setThreadTaskTileSize(int tileSize, struct ThreadedData *threadSystem) {
+    threadSystem->taskTileSize = tileSize > 0 ? tileSize : DEFAULT_TASK_TILE_SIZE;
+}
+
+void setThreadAnalysis(AnalysisMode analysisMode, BitboardKernel bitboardKernel, struct ThreadedData *threadSystem) {
+    threadSystem->analysisMode = analysisMode;
+
+    if (bitboardKernel != threadSystem->bitboardKernel) {
+        threadSystem->bitboardKernel = bitboardKernel;
+
+        // The masks are created for a kernel, they will be created again for the new one
+        for (int threadIndex = 0; threadIndex < threadSystem->threadCount; threadIndex++) {
+            destroyNeighbourMasks(threadSystem->neighbourMasksPerThread[threadIndex]);
+            threadSystem->neighbourMasksPerThread[threadIndex] = NULL;
+        }
+    }
+}
+
+void setThreadTimers(struct PhaseTimers_ *timers, struct ThreadedData *threadSystem) {
+    threadSystem->timers = timers;
+}
+
+void setThreadRowGroups(int groupCount, const int *firstThreads, struct ThreadedData *threadSystem) {
+    free(threadSystem->rowGroupThreads);
+
+    threadSystem->rowGroupCount = groupCount;
+    threadSystem->rowGroupThreads = malloc(sizeof(int) * (groupCount + 1));
+
+    memcpy(threadSystem->rowGroupThreads, firstThreads, sizeof(int) * (groupCount + 1));
+}
+
+void prepareThreadingSystem(int threadCount, InputData *worldData, struct ThreadedData *threadSystem) {
+    if (threadSystem->partitionMode == PARTITION_BANDS) {
+        threadSystem->tileRows = threadCount;
+        threadSystem->tileColumns = 1;
+    }
+
+    if (threadSystem->barrierThreads != threadCount) {
+        pthread_barrier_destroy(&threadSystem->barrier);
+        pthread_barrier_init(&threadSystem->barrier, NULL, threadCount);
+        threadSystem->barrierThreads = threadCount;
+    }
+
+    if (worldData->columns > threadSystem->conflictCapacity) {
+        threadSystem->conflictCapacity = worldData->columns;
+
+        for (int threadIndex = 0; threadIndex < threadSystem->threadCount; threadIndex++) {
+            Conflicts *threadConflicts = &threadSystem->workers[threadIndex].conflicts;
+
+            threadConflicts->conflicts[NORTH] = realloc(threadConflicts->conflicts[NORTH], sizeof(Conflict) * threadSystem->conflictCapacity);
+            threadConflicts->conflicts[SOUTH] = realloc(threadConflicts->conflicts[SOUTH], sizeof(Conflict) * threadSystem->conflictCapacity);
+        }
+    }
+
+    if (threadSystem->partitionMode == PARTITION_TILES) {
+        if (worldData->rows > threadSystem->sideConflictCapacity) {
+            threadSystem->sideConflictCapacity = worldData->rows;
+
+            for (int threadIndex = 0; threadIndex < threadSystem->threadCount; threadIndex++) {
+                Conflicts *threadConflicts = &threadSystem->workers[threadIndex].conflicts;
+
+                threadConflicts->conflicts[EAST] = realloc(threadConflicts->conflicts[EAST], sizeof(Conflict) * threadSystem->sideConflictCapacity);
+                threadConflicts->conflicts[WEST] = realloc(threadConflicts->conflicts[WEST], sizeof(Conflict) * threadSystem->sideConflictCapacity);
+            }
+        }
+
+        if (worldData->columns > threadSystem->countColumnCapacity) {
+            threadSystem->countColumnCapacity = worldData->columns;
+
+            // The counts are cleared at the start of every phase, there is nothing to keep
+            for (int threadIndex = 0; threadIndex < threadSystem->threadCount; threadIndex++) {
+                free(threadSystem->entitiesPerColumnPerThread[threadIndex]);
+                threadSystem->entitiesPerColumnPerThread[threadIndex] =
+                        allocateCacheAligned(sizeof(int) * threadSystem->countColumnCapacity);
+            }
+
+            threadSystem->entitiesPerColumn = realloc(threadSystem->entitiesPerColumn, sizeof(int) * threadSystem->countColumnCapacity);
+            threadSystem->entitiesAccumulatedPerColumn = realloc(threadSystem->entitiesAccumulatedPerColumn,
+                                                                 sizeof(int) * threadSystem->countColumnCapacity);
+        }
+    }
+
+    int countsPerThread = threadSystem->partitionMode == PARTITION_TILES ||
+                          (threadSystem->partitionMode == PARTITION_BANDS && threadCount > 1);
+
+    if (countsPerThread && worldData->rows > threadSystem->countRowCapacity) {
+        threadSystem->countRowCapacity = worldData->rows;
+
+        for (int threadIndex = 0; threadIndex < threadSystem->threadCount; threadIndex++) {
+            free(threadSystem->entitiesPerRowPerThread[threadIndex]);
+            threadSystem->entitiesPerRowPerThread[threadIndex] =
+                    allocateCacheAligned(sizeof(int) * threadSystem->countRowCapacity);
+        }
+    }
+
+    if (threadSystem->partitionMode == PARTITION_STEALING) {
+        prepareTileScheduler(worldData, threadSystem);
+    }
+
+    if (threadSystem->analysisMode == ANALYSIS_BITBOARD) {
+        for (int threadIndex = 0; threadIndex < threadSystem->threadCount; threadIndex++) {
+            if (threadSystem->neighbourMasksPerThread[threadIndex] == NULL) {
+                threadSystem->neighbourMasksPerThread[threadIndex] = createNeighbourMasks(threadSystem->bitboardKernel);
+            }
+
+            ensureNeighbourMasksCapacity(threadSystem->neighbourMasksPerThread[threadIndex], OCCUPANCY_WORDS(worldData->columns));
+        }
+    }
+
+    // The semaphores are always left at 0 when a simulation ends, so they can be reused as they are
+    for (int threadIndex = 0; threadIndex < threadSystem->threadCount; threadIndex++) {
+        threadSystem->workers[threadIndex].phaseCounter.phase = 0;
+        threadSystem->workers[threadIndex].rebalanceNanos = 0;
+    }
+}
+
+//A single thread counts straight into the counts of the world, there is nobody to merge with
+int *threadRowCounts(int threadIndex, InputData *worldData, struct ThreadedData *threadSystem) {
+    if (threadSystem->partitionMode == PARTITION_TILES || worldData->threads > 1) {
+        return threadSystem->entitiesPerRowPerThread[threadIndex];
     }
+
+    return worldData->entitiesPerRow;
 }
 
 /*
@@ -39,29 +245,20 @@ void initializeThreadingSystem(int threadCount, InputData *worldData, struct Thr
  * rest
  */
 void resetThreadConflicts(int threadIndex, struct ThreadedData *threadSystem) {
-    Conflicts *threadConflicts = threadSystem->conflictPerThreads[threadIndex];
+    Conflicts *threadConflicts = &threadSystem->workers[threadIndex].conflicts;
 
     // Reset conflict counters (arrays are reused, no need to clear contents)
-    threadConflicts->aboveCount = 0;
-    threadConflicts->bellowCount = 0;
+    for (int direction = 0; direction < 4; direction++) {
+        threadConflicts->count[direction] = 0;
+    }
 }
 
-void createAndStoreConflict(Conflicts *threadConflicts, int isAboveThread, int targetRow, int targetCol, WorldSlot *sourceSlot) {
+void createAndStoreConflict(Conflicts *threadConflicts, MoveDirection direction, int targetRow, int targetCol, WorldSlot *sourceSlot) {
     // Thread boundary conflict: entity wants to move to another thread's region
     // Store conflict for later resolution during synchronization phase
-    
-    int *conflictCount;
-    Conflict *conflictArray;
-
-    if (isAboveThread) {
-        // Conflict with thread responsible for rows above current thread
-        conflictCount = &threadConflicts->aboveCount;
-        conflictArray = threadConflicts->above;
-    } else {
-        // Conflict with thread responsible for rows below current thread  
-        conflictCount = &threadConflicts->bellowCount;
-        conflictArray = threadConflicts->bellow;
-    }
+    // Entities only move one slot, so the thread next to us in the direction of the move owns the target slot
+    int *conflictCount = &threadConflicts->count[direction];
+    Conflict *conflictArray = threadConflicts->conflicts[direction];
 
     // Create conflict record
     Conflict *newConflict = &conflictArray[*conflictCount];
@@ -72,15 +269,14 @@ void createAndStoreConflict(Conflicts *threadConflicts, int isAboveThread, int t
     // Store entity-specific data for conflict resolution
     switch (sourceSlot->slotContent) {
         case FOX:
-            newConflict->data = sourceSlot->entityInfo.foxInfo;
+            newConflict->entityInfo.foxInfo = sourceSlot->entityInfo.foxInfo;
             break;
         case RABBIT:
-            newConflict->data = sourceSlot->entityInfo.rabbitInfo;
+            newConflict->entityInfo.rabbitInfo = sourceSlot->entityInfo.rabbitInfo;
             break;
         case EMPTY:
         case ROCK:
         default:
-            newConflict->data = NULL;
             break;
     }
 
@@ -133,27 +329,131 @@ int validateThreadConfiguration(InputData *simulationData) {
     return 1;
 }
 
-void distributeWorkloadAcrossThreads(int threadCount, ThreadRowData *threadAssignments, InputData *worldData) {
-    int totalEntities = worldData->entitiesAccumulatedPerRow[worldData->rows - 1];
-    int entitiesPerThread = totalEntities / threadCount;
-    int lastRowIndex = worldData->rows - 1;
-    int nextThreadStartRow = 0;
+// The row group of the thread threadIndex when threadCount threads are simulating, [*firstThread, *endThread)
+static void findThreadRowGroup(int threadIndex, int threadCount, struct ThreadedData *threadSystem, int *firstThread,
+                               int *endThread) {
+    *firstThread = 0;
+    *endThread = threadCount;
+
+    for (int group = 0; group < threadSystem->rowGroupCount; group++) {
+        int end = threadSystem->rowGroupThreads[group + 1];
+
+        if (threadIndex < end || end >= threadCount) {
+            *firstThread = threadSystem->rowGroupThreads[group];
+            *endThread = end < threadCount ? end : threadCount;
+            return;
+        }
+    }
+}
+
+/*
+ * The accumulated entity counts of the world while the two pass scan is running: the count of every row is known,
+ * and so are the entities before every band (bandOffset), but the rows of a band are only accumulated later, by the
+ * thread of the band. NULL when entitiesAccumulatedPerRow is complete
+ */
+typedef struct BandScan_ {
+
+    int bandCount;
+
+    WorkerBlock *workers;
+
+} BandScan;
+
+// The band (the previous rows of a thread) the row is in
+static int findRowBand(int row, const BandScan *bands) {
+    int low = 0, high = bands->bandCount - 1;
+
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+
+        if (bands->workers[middle].bandStartRow <= row) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+
+    return low;
+}
+
+// The entities in the rows 0 to row
+static int entitiesUpToRow(int row, InputData *worldData, const BandScan *bands) {
+    if (bands == NULL) {
+        return worldData->entitiesAccumulatedPerRow[row];
+    }
+
+    WorkerBlock *band = &bands->workers[findRowBand(row, bands)];
+
+    int entities = band->bandOffset;
+
+    for (int bandRow = band->bandStartRow; bandRow <= row; bandRow++) {
+        entities += worldData->entitiesPerRow[bandRow];
+    }
+
+    return entities;
+}
+
+// Same as findRowByEntityCount, the last row with at most targetEntityCount entities up to it (or the first row)
+static int findSplitRow(int targetEntityCount, InputData *worldData, const BandScan *bands) {
+    if (bands == NULL) {
+        return findRowByEntityCount(targetEntityCount, worldData->entitiesAccumulatedPerRow, worldData->rows);
+    }
+
+    // The last band that starts with at most the target, its rows (or the rows before it) have the split
+    int low = 0, high = bands->bandCount - 1;
+
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+
+        if (bands->workers[middle].bandOffset <= targetEntityCount) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+
+    WorkerBlock *band = &bands->workers[low];
+
+    int entities = band->bandOffset, splitRow = band->bandStartRow - 1;
+
+    for (int row = band->bandStartRow; row < worldData->rows && row <= band->bandEndRow; row++) {
+        entities += worldData->entitiesPerRow[row];
+
+        if (entities > targetEntityCount) {
+            break;
+        }
+
+        splitRow = row;
+    }
+
+    return splitRow > 0 ? splitRow : 0;
+}
+
+// Cut the rows of a row group between its threads. The group keeps the rows the even split of the world gives to its
+// threads
+static void splitRowGroup(int firstThread, int endThread, int threadCount, ThreadRowData *threadRows,
+                          InputData *worldData, const BandScan *bands) {
+    int firstRow = (int) ((long) firstThread * worldData->rows / threadCount);
+    int lastRowIndex = (int) ((long) endThread * worldData->rows / threadCount) - 1;
+
+    int entitiesBefore = firstRow > 0 ? entitiesUpToRow(firstRow - 1, worldData, bands) : 0;
+    int groupThreads = endThread - firstThread;
+    int entitiesPerThread = (entitiesUpToRow(lastRowIndex, worldData, bands) - entitiesBefore) / groupThreads;
+    int nextThreadStartRow = firstRow;
 
     // Distribute workload by assigning row ranges to each thread
-    for (int threadIndex = 0; threadIndex < threadCount; threadIndex++) {
-        int remainingThreads = threadCount - threadIndex - 1;
+    for (int threadIndex = firstThread; threadIndex < endThread; threadIndex++) {
+        int remainingThreads = endThread - threadIndex - 1;
         int startRow = nextThreadStartRow;
         int endRow;
 
-        if (threadIndex == threadCount - 1) {
+        if (threadIndex == endThread - 1) {
             // Last thread takes all remaining rows
             endRow = lastRowIndex;
         } else {
             // Find optimal end row based on entity distribution
-            int targetCumulativeEntities = (threadIndex + 1) * entitiesPerThread;
-            int optimalEndRow = findRowByEntityCount(targetCumulativeEntities, 
-                                                      worldData->entitiesAccumulatedPerRow, 
-                                                      worldData->rows);
+            int targetCumulativeEntities = entitiesBefore + (threadIndex - firstThread + 1) * entitiesPerThread;
+            int optimalEndRow = findSplitRow(targetCumulativeEntities, worldData, bands);
             
             // Ensure enough rows remain for subsequent threads
             int rowsNeededForRemainingThreads = remainingThreads;
@@ -172,43 +472,354 @@ void distributeWorkloadAcrossThreads(int threadCount, ThreadRowData *threadAssig
         }
 
         // Assign row range to thread
-        threadAssignments[threadIndex].startRow = startRow;
-        threadAssignments[threadIndex].endRow = endRow;
+        ThreadRowData *rows = &threadRows[threadIndex];
+
+        rows->startRow = startRow;
+        rows->endRow = endRow;
+        rows->startCol = 0;
+        rows->endCol = worldData->columns - 1;
         
         // Next thread starts after this thread's range
         nextThreadStartRow = endRow + 1;
     }
 }
 
+// Cut the rows of every row group between its threads
+static void splitRowGroups(int threadCount, ThreadRowData *threadAssignments, InputData *worldData,
+                           struct ThreadedData *threadSystem, const BandScan *bands) {
+    int firstThread = 0;
+
+    // The groups are cut one after the other, a group can be left without threads when the world has less threads
+    while (firstThread < threadCount) {
+        int groupFirst, groupEnd;
+
+        findThreadRowGroup(firstThread, threadCount, threadSystem, &groupFirst, &groupEnd);
+
+        splitRowGroup(groupFirst, groupEnd, threadCount, threadAssignments, worldData, bands);
+
+        firstThread = groupEnd;
+    }
+}
+
+void distributeWorkloadAcrossThreads(int threadCount, ThreadRowData *threadAssignments, InputData *worldData,
+                                     struct ThreadedData *threadSystem) {
+    splitRowGroups(threadCount, threadAssignments, worldData, threadSystem, NULL);
+}
+
+int chooseTileLayout(int threadCount, InputData *worldData, struct ThreadedData *threadSystem) {
+    int bestRows = 1, bestColumns = 1, bestThreads = 0;
+    double bestPerimeter = 0;
+
+    for (int tileRows = 1; tileRows <= threadCount && tileRows <= worldData->rows; tileRows++) {
+        int tileColumns = threadCount / tileRows;
+
+        if (tileColumns > worldData->columns) {
+            tileColumns = worldData->columns;
+        }
+
+        int threads = tileRows * tileColumns;
+
+        // Height plus width of a tile, the halo of a tile grows with it
+        double perimeter = (double) worldData->rows / tileRows + (double) worldData->columns / tileColumns;
+
+        if (threads > bestThreads || (threads == bestThreads && perimeter < bestPerimeter)) {
+            bestRows = tileRows;
+            bestColumns = tileColumns;
+            bestThreads = threads;
+            bestPerimeter = perimeter;
+        }
+    }
+
+    threadSystem->tileRows = bestRows;
+    threadSystem->tileColumns = bestColumns;
+
+    return bestThreads;
+}
+
+// Cut length rows (or columns) in parts with about the same number of entities, the same way
+// distributeWorkloadAcrossThreads cuts the rows. ends[part] is the last row of each part
+static void splitByEntityCount(int parts, const int *accumulated, int length, int *ends) {
+    int entitiesPerPart = accumulated[length - 1] / parts;
+    int lastIndex = length - 1;
+    int start = 0;
+
+    for (int part = 0; part < parts; part++) {
+        int end = lastIndex;
+
+        if (part < parts - 1) {
+            end = findRowByEntityCount((part + 1) * entitiesPerPart, accumulated, length);
+
+            // Every part after this one needs at least one row
+            if (end > lastIndex - (parts - part - 1)) {
+                end = lastIndex - (parts - part - 1);
+            }
+
+            if (end < start) {
+                end = start;
+            }
+        }
+
+        ends[part] = end;
+        start = end + 1;
+    }
+}
+
+// Give every thread the tile at the crossing of its band of rows and strip of columns
+static void assignTiles(ThreadRowData *threadAssignments, InputData *worldData, struct ThreadedData *threadSystem) {
+    int rowEnds[threadSystem->tileRows], columnEnds[threadSystem->tileColumns];
+
+    splitByEntityCount(threadSystem->tileRows, worldData->entitiesAccumulatedPerRow, worldData->rows, rowEnds);
+    splitByEntityCount(threadSystem->tileColumns, threadSystem->entitiesAccumulatedPerColumn, worldData->columns, columnEnds);
+
+    for (int tileRow = 0; tileRow < threadSystem->tileRows; tileRow++) {
+        for (int tileColumn = 0; tileColumn < threadSystem->tileColumns; tileColumn++) {
+            ThreadRowData *tile = &threadAssignments[tileRow * threadSystem->tileColumns + tileColumn];
+
+            tile->startRow = tileRow > 0 ? rowEnds[tileRow - 1] + 1 : 0;
+            tile->endRow = rowEnds[tileRow];
+            tile->startCol = tileColumn > 0 ? columnEnds[tileColumn - 1] + 1 : 0;
+            tile->endCol = columnEnds[tileColumn];
+        }
+    }
+}
+
+static void accumulateColumnCounts(InputData *worldData, struct ThreadedData *threadSystem) {
+    int total = 0;
+
+    for (int col = 0; col < worldData->columns; col++) {
+        total += threadSystem->entitiesPerColumn[col];
+        threadSystem->entitiesAccumulatedPerColumn[col] = total;
+    }
+}
+
+void distributeTilesAcrossThreads(ThreadRowData *threadAssignments, InputData *worldData, WorldSlot *world,
+                                  struct ThreadedData *threadSystem) {
+    // The rows were counted when the world was loaded, the columns still have to be
+    for (int col = 0; col < worldData->columns; col++) {
+        threadSystem->entitiesPerColumn[col] = 0;
+    }
+
+    for (int row = 0; row < worldData->rows; row++) {
+        for (int col = 0; col < worldData->columns; col++) {
+            SlotContent content = world[PROJECT(worldData->columns, row, col)].slotContent;
+
+            if (content == RABBIT || content == FOX) {
+                threadSystem->entitiesPerColumn[col]++;
+            }
+        }
+    }
+
+    accumulateColumnCounts(worldData, threadSystem);
+
+    assignTiles(threadAssignments, worldData, threadSystem);
+}
+
+/*
+ * Tile mode version of accumulateAndRebalance. Once every thread is done, the first one adds up the counts of the
+ * tiles into counts per row and per column and moves the cuts, then everyone continues with their new tiles
+ */
+static void rebalanceTiles(int threadIndex, InputData *worldData, ThreadRowData *threadAssignments,
+                           struct ThreadedData *threadSystem) {
+    pthread_barrier_wait(&threadSystem->barrier);
+
+    if (threadIndex == 0) {
+        for (int row = 0; row < worldData->rows; row++) {
+            worldData->entitiesPerRow[row] = 0;
+        }
+
+        for (int col = 0; col < worldData->columns; col++) {
+            threadSystem->entitiesPerColumn[col] = 0;
+        }
+
+        for (int thread = 0; thread < worldData->threads; thread++) {
+            ThreadRowData *tile = &threadAssignments[thread];
+
+            int *rowCounts = threadSystem->entitiesPerRowPerThread[thread],
+                *columnCounts = threadSystem->entitiesPerColumnPerThread[thread];
+
+            for (int row = tile->startRow; row <= tile->endRow; row++) {
+                worldData->entitiesPerRow[row] += rowCounts[row];
+            }
+
+            for (int col = tile->startCol; col <= tile->endCol; col++) {
+                threadSystem->entitiesPerColumn[col] += columnCounts[col];
+            }
+        }
+
+        int total = 0;
+
+        for (int row = 0; row < worldData->rows; row++) {
+            total += worldData->entitiesPerRow[row];
+            worldData->entitiesAccumulatedPerRow[row] = total;
+        }
+
+        accumulateColumnCounts(worldData, threadSystem);
+
+        assignTiles(threadAssignments, worldData, threadSystem);
+    }
+
+    pthread_barrier_wait(&threadSystem->barrier);
+}
+
 void destroyConflict(Conflict *conflict) {
     if (conflict != NULL) {
         free(conflict);
     }
 }
 
+//Resolve the conflicts the thread neighbourThread created in our region, which are the moves it has in the
+//direction that goes from its region to ours
+static void resolveNeighbourConflicts(struct ThreadConflictData *conflictData, int neighbourThread, MoveDirection direction) {
+    Conflicts *conflicts = &conflictData->threadedData->workers[neighbourThread].conflicts;
+
+    resolveThreadConflicts(conflictData, conflicts->count[direction], conflicts->conflicts[direction]);
+}
+
+//The direction that goes back from a neighbour to us
+static MoveDirection oppositeDirection(MoveDirection direction) {
+    return (MoveDirection) ((direction + 2) % 4);
+}
+
+//The thread whose region is next to ours in the given direction, -1 if our region is at the edge of the world
+static int neighbourThreadInDirection(int threadIndex, MoveDirection direction, struct ThreadedData *threadSystem) {
+    int tileRow = threadIndex / threadSystem->tileColumns, tileColumn = threadIndex % threadSystem->tileColumns;
+
+    switch (direction) {
+        case NORTH:
+            return tileRow > 0 ? threadIndex - threadSystem->tileColumns : -1;
+        case SOUTH:
+            return tileRow < threadSystem->tileRows - 1 ? threadIndex + threadSystem->tileColumns : -1;
+        case WEST:
+            return tileColumn > 0 ? threadIndex - 1 : -1;
+        case EAST:
+            return tileColumn < threadSystem->tileColumns - 1 ? threadIndex + 1 : -1;
+        default:
+            return -1;
+    }
+}
+
+//Move our phase counter to the next synchronization point and wake up the neighbours waiting for it
+static int advanceThreadPhase(int threadIndex, struct ThreadedData *threadSystem) {
+    PhaseCounter *counter = &threadSystem->workers[threadIndex].phaseCounter;
+
+    pthread_mutex_lock(&counter->lock);
+
+    int phase = counter->phase + 1;
+
+    __atomic_store_n(&counter->phase, phase, __ATOMIC_RELEASE);
+
+    pthread_cond_broadcast(&counter->advanced);
+
+    pthread_mutex_unlock(&counter->lock);
+
+    return phase;
+}
+
+static int threadReachedPhase(int threadIndex, int phase, struct ThreadedData *threadSystem) {
+    return __atomic_load_n(&threadSystem->workers[threadIndex].phaseCounter.phase, __ATOMIC_ACQUIRE) >= phase;
+}
+
+static void waitForThreadPhase(int threadIndex, int phase, struct ThreadedData *threadSystem) {
+    PhaseCounter *counter = &threadSystem->workers[threadIndex].phaseCounter;
+
+    for (int spin = 0; CONFLICT_SPIN_LIMIT < 0 || spin < CONFLICT_SPIN_LIMIT; spin++) {
+        if (threadReachedPhase(threadIndex, phase, threadSystem)) return;
+    }
+
+    pthread_mutex_lock(&counter->lock);
+
+    while (counter->phase < phase) {
+        pthread_cond_wait(&counter->advanced, &counter->lock);
+    }
+
+    pthread_mutex_unlock(&counter->lock);
+}
+
+void waitForNeighbourThreads(int threadIndex, InputData *worldData, struct ThreadedData *threadSystem) {
+    //Only we write our counter, no need to load it atomically
+    int phase = threadSystem->workers[threadIndex].phaseCounter.phase;
+
+    for (int direction = 0; direction < 4; direction++) {
+        int neighbour = neighbourThreadInDirection(threadIndex, (MoveDirection) direction, threadSystem);
+
+        if (neighbour >= 0) {
+            waitForThreadPhase(neighbour, phase, threadSystem);
+        }
+    }
+}
+
+/*
+ * Conflict hand off with the phase counters, used in neighbour sync mode and by tiles. The semaphores can't be used
+ * here: a thread that is a phase ahead could take the post its neighbour left for the thread on the other side of
+ * it, and a tile has up to four neighbours
+ */
+static void exchangeNeighbourConflicts(struct ThreadConflictData *conflictData) {
+    struct ThreadedData *threadedData = conflictData->threadedData;
+
+    int threadNum = conflictData->threadNum;
+
+    //Our conflicts are ready for the neighbours
+    int phase = advanceThreadPhase(threadNum, threadedData);
+
+    int neighbours[4], pending = 0;
+
+    for (int direction = 0; direction < 4; direction++) {
+        neighbours[direction] = neighbourThreadInDirection(threadNum, (MoveDirection) direction, threadedData);
+
+        if (neighbours[direction] >= 0) pending++;
+    }
+
+    //Resolve the neighbours in the order they get done, then block on the ones that are still missing
+    for (int spin = 0; pending > 0 && (CONFLICT_SPIN_LIMIT < 0 || spin < CONFLICT_SPIN_LIMIT); spin++) {
+        for (int direction = 0; direction < 4; direction++) {
+            int neighbour = neighbours[direction];
+
+            if (neighbour >= 0 && threadReachedPhase(neighbour, phase, threadedData)) {
+                resolveNeighbourConflicts(conflictData, neighbour, oppositeDirection((MoveDirection) direction));
+
+                neighbours[direction] = -1;
+                pending--;
+            }
+        }
+    }
+
+    for (int direction = 0; direction < 4; direction++) {
+        int neighbour = neighbours[direction];
+
+        if (neighbour >= 0) {
+            waitForThreadPhase(neighbour, phase, threadedData);
+
+            resolveNeighbourConflicts(conflictData, neighbour, oppositeDirection((MoveDirection) direction));
+        }
+    }
+
+    //Our region is final for this phase, and we're done reading the neighbours' conflicts
+    advanceThreadPhase(threadNum, threadedData);
+}
+
 void synchronizeAndResolveThreadConflicts(struct ThreadConflictData *conflictData) {
     if (conflictData->inputData->threads > 1) {
 
         struct ThreadedData *threadedData = conflictData->threadedData;
 
-        if (conflictData->threadNum == 0) {
+        if (threadedData->syncMode == SYNC_NEIGHBOURS || threadedData->partitionMode == PARTITION_TILES) {
+            exchangeNeighbourConflicts(conflictData);
+        } else if (conflictData->threadNum == 0) {
 
             //We only need one post as the top thread only synchronizes with the thread bellow it
-            sem_post(&threadedData->threadSemaphores[conflictData->threadNum]);
+            sem_post(&threadedData->workers[conflictData->threadNum].conflictsReady);
             //The first thread will only sync with one thread
 
             //Wait for the semaphores of thread below
-            sem_wait(&threadedData->threadSemaphores[conflictData->threadNum + 1]);
-
-            Conflicts *bottomConflicts = threadedData->conflictPerThreads[conflictData->threadNum + 1];
+            sem_wait(&threadedData->workers[conflictData->threadNum + 1].conflictsReady);
 
 //            printf("Thread %d called handle conflicts with thread %d\n", conflictData->threadNum,  conflictData->threadNum + 1);
 
-            resolveThreadConflicts(conflictData, bottomConflicts->aboveCount, bottomConflicts->above);
+            resolveNeighbourConflicts(conflictData, conflictData->threadNum + 1, NORTH);
 
         } else if (conflictData->threadNum > 0 && conflictData->threadNum < (conflictData->inputData->threads - 1)) {
 
-            sem_t *our_sem = &threadedData->threadSemaphores[conflictData->threadNum];
+            sem_t *our_sem = &threadedData->workers[conflictData->threadNum].conflictsReady;
             //Since middle threads will have to sync with 2 different threads, we
             //Increment the semaphore to 2
             sem_post(our_sem);
@@ -216,70 +827,76 @@ void synchronizeAndResolveThreadConflicts(struct ThreadConflictData *conflictDat
 
             int topThread = conflictData->threadNum - 1, bottThread = conflictData->threadNum + 1;
 
-            sem_t *topSem = &threadedData->threadSemaphores[topThread],
-                    *bottomSem = &threadedData->threadSemaphores[bottThread];
+            sem_t *topSem = &threadedData->workers[topThread].conflictsReady,
+                    *bottomSem = &threadedData->workers[bottThread].conflictsReady;
 
             int topDone = 0, botDone = 0;
             int sems_left = 2;
 
             //We don't have to wait for both semaphores to solve the conflicts
-            //Try to unlock the semaphores and do them as soon as they are unlocked
-            while (sems_left > 0) {
-                if (!topDone) {
-                    if (sem_trywait(topSem) == 0) {
-
-                        //Since we are bellow the thread that is above us (Who knew?)
-                        //We get the conflicts of that thread with the thread bellow it (That's us!)
-
-                        Conflicts *topConf = threadedData->conflictPerThreads[topThread];
+            //Try to unlock the semaphores and do them as soon as they are unlocked, but only for a bounded
+            //number of rounds. A neighbour that is still busy after that is waited for in sem_wait, so we don't
+            //keep a core busy (that the neighbour might need) doing nothing
+            for (int spin = 0; sems_left > 0 && (CONFLICT_SPIN_LIMIT < 0 || spin < CONFLICT_SPIN_LIMIT); spin++) {
+                if (!topDone && sem_trywait(topSem) == 0) {
+                    //Since we are bellow the thread that is above us (Who knew?)
+                    //We get the conflicts of that thread with the thread bellow it (That's us!)
+                    resolveNeighbourConflicts(conflictData, topThread, SOUTH);
+
+                    sems_left--;
+                    topDone = 1;
+                }
 
-//                        printf("Thread %d called handle conflicts with thread %d\n", conflictData->threadNum,  topThread);
-                        resolveThreadConflicts(conflictData, topConf->bellowCount, topConf->bellow);
+                if (!botDone && sem_trywait(bottomSem) == 0) {
+                    //Since we are above the thread that is bellow us (Again, who knew? :))
+                    //We get the conflicts of that thread with the thread above it (That's us again!)
+                    resolveNeighbourConflicts(conflictData, bottThread, NORTH);
 
-                        sems_left--;
-                        topDone = 1;
-                    }
+                    sems_left--;
+                    botDone = 1;
                 }
+            }
 
-                if (!botDone) {
-                    //If there are 2 semaphore left, then the bottom one is still not done
-                    //If there's only one, then the bottom one is done if the top isn't
-                    if (sem_trywait(bottomSem) == 0) {
-                        //Since we are above the thread that is bellow us (Again, who knew? :))
-                        //We get the conflicts of that thread with the thread above it (That's us again!)
-                        Conflicts *botConf = threadedData->conflictPerThreads[bottThread];
+            //Park until the neighbours we're still missing are done
+            if (!topDone) {
+                sem_wait(topSem);
 
-//                        printf("Thread %d called handle conflicts with thread %d\n", conflictData->threadNum,  bottThread);
-                        resolveThreadConflicts(conflictData, botConf->aboveCount, botConf->above);
+                resolveNeighbourConflicts(conflictData, topThread, SOUTH);
+            }
 
-                        botDone = 1;
-                        sems_left--;
-                    }
-                }
+            if (!botDone) {
+                sem_wait(bottomSem);
+
+                resolveNeighbourConflicts(conflictData, bottThread, NORTH);
             }
 
         } else {
             //The last thread will also only sync with one thread
-            sem_post(&threadedData->threadSemaphores[conflictData->threadNum]);
+            sem_post(&threadedData->workers[conflictData->threadNum].conflictsReady);
 
             int topThread = conflictData->threadNum - 1;
 
-            sem_t *topSem = &threadedData->threadSemaphores[topThread];
+            sem_t *topSem = &threadedData->workers[topThread].conflictsReady;
 
             sem_wait(topSem);
 
-            Conflicts *conflicts = threadedData->conflictPerThreads[topThread];
 //            printf("Thread %d called handle conflicts with thread %d\n", conflictData->threadNum,  conflictData->threadNum - 1);
 
-            resolveThreadConflicts(conflictData, conflicts->bellowCount, conflicts->bellow);
+            resolveNeighbourConflicts(conflictData, topThread, SOUTH);
         }
     }
 }
 
 
+/*
+ * How the entity counts of the rows are accumulated before the rows are cut between the threads again. The default is
+ * the two pass scan, building with PREFIX_SUM_CHAIN passes the counts down the threads one after the other instead
+ */
+#ifdef PREFIX_SUM_CHAIN
+
 static void signalCompletionAndWaitForBarrier(int threadNumber, InputData *data, struct ThreadedData *threadedData) {
     if (threadNumber < data->threads - 1) {
-        sem_t *our_sem = &threadedData->precedingSemaphores[threadNumber];
+        sem_t *our_sem = &threadedData->workers[threadNumber].countsReady;
 
         sem_post(our_sem);
     }
@@ -293,14 +910,18 @@ static void signalCompletionAndWaitForBarrier(int threadNumber, InputData *data,
 static void waitForPreviousThreadCompletion(int threadNumber, InputData *data, struct ThreadedData *threadedData) {
 
     if (threadNumber > 0) {
-        sem_t *topSem = &threadedData->precedingSemaphores[threadNumber - 1];
+        sem_t *topSem = &threadedData->workers[threadNumber - 1].countsReady;
 
         sem_wait(topSem);
     }
 
 }
 
-void updateCumulativeEntityCounts(int threadIndex, InputData *worldData, ThreadRowData *threadAssignments,
+/*
+ * Serial version (built with PREFIX_SUM_CHAIN): the cumulative counts are passed down the threads like a token, so
+ * every thread waits for all the threads above it
+ */
+static void accumulateAndRebalance(int threadIndex, InputData *worldData, ThreadRowData *threadAssignments,
                                    struct ThreadedData *threadSystem) {
     // Wait for previous thread to complete its cumulative calculation
     waitForPreviousThreadCompletion(threadIndex, worldData, threadSystem);
@@ -309,27 +930,111 @@ void updateCumulativeEntityCounts(int threadIndex, InputData *worldData, ThreadR
     int startRow = currentThreadRows->startRow;
     int endRow = currentThreadRows->endRow;
 
-    // Update cumulative entity counts for this thread's assigned rows
+    int *rowCounts = threadRowCounts(threadIndex, worldData, threadSystem);
+
+    // Update cumulative entity counts for this thread's assigned rows, publishing the counts we kept on our own
     for (int row = startRow; row <= endRow; row++) {
         int previousRowCount = (row > 0) ? worldData->entitiesAccumulatedPerRow[row - 1] : 0;
-        worldData->entitiesAccumulatedPerRow[row] = previousRowCount + worldData->entitiesPerRow[row];
+        worldData->entitiesPerRow[row] = rowCounts[row];
+        worldData->entitiesAccumulatedPerRow[row] = previousRowCount + rowCounts[row];
     }
 
     // Last thread recalculates workload distribution for next generation
     if (threadIndex == worldData->threads - 1) {
-        distributeWorkloadAcrossThreads(worldData->threads, threadAssignments, worldData);
+        distributeWorkloadAcrossThreads(worldData->threads, threadAssignments, worldData, threadSystem);
     }
 
     // Signal completion and wait for other threads
     signalCompletionAndWaitForBarrier(threadIndex, worldData, threadSystem);
 }
 
+#else
+
+/*
+ * Two pass scan: every thread publishes the counts of its rows and the total of its band. One thread then scans the
+ * band totals into the entities before every band and cuts the new rows of every thread from them, and every thread
+ * accumulates the rows of its band on its own. No thread waits for the threads above it to finish their part
+ */
+static void accumulateAndRebalance(int threadIndex, InputData *worldData, ThreadRowData *threadAssignments,
+                                   struct ThreadedData *threadSystem) {
+    WorkerBlock *ourBlock = &threadSystem->workers[threadIndex];
+
+    // The rows are cut again before we accumulate them, remember which rows were ours
+    ourBlock->bandStartRow = threadAssignments[threadIndex].startRow;
+    ourBlock->bandEndRow = threadAssignments[threadIndex].endRow;
+
+    int *rowCounts = threadRowCounts(threadIndex, worldData, threadSystem);
+
+    // The counts we kept on our own during the generation become the counts of the world, the lines at the edges of
+    // the band are only shared with the neighbours this once
+    int bandTotal = 0;
+
+    for (int row = ourBlock->bandStartRow; row <= ourBlock->bandEndRow; row++) {
+        bandTotal += rowCounts[row];
+        worldData->entitiesPerRow[row] = rowCounts[row];
+    }
+
+    ourBlock->bandTotal = bandTotal;
+
+    if (pthread_barrier_wait(&threadSystem->barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+        // Exclusive scan of the band totals, done once
+        int entitiesBefore = 0;
+
+        for (int thread = 0; thread < worldData->threads; thread++) {
+            threadSystem->workers[thread].bandOffset = entitiesBefore;
+            entitiesBefore += threadSystem->workers[thread].bandTotal;
+        }
+
+        BandScan bands = {.bandCount = worldData->threads, .workers = threadSystem->workers};
+
+        splitRowGroups(worldData->threads, threadAssignments, worldData, threadSystem, &bands);
+    }
+
+    pthread_barrier_wait(&threadSystem->barrier);
+
+    // Nothing reads the accumulated counts while the threads simulate, but the thread that got our rows may already
+    // be publishing their counts for the next rebalance, so we accumulate our own
+    int accumulated = ourBlock->bandOffset;
+
+    for (int row = ourBlock->bandStartRow; row <= ourBlock->bandEndRow; row++) {
+        accumulated += rowCounts[row];
+        worldData->entitiesAccumulatedPerRow[row] = accumulated;
+    }
+}
+
+#endif
+
+void updateCumulativeEntityCounts(int threadIndex, InputData *worldData, ThreadRowData *threadAssignments,
+                                   struct ThreadedData *threadSystem) {
+    struct timespec start, end;
+
+    if (PRINT_REBALANCE_TIME) {
+        //Start timing once every thread is here, otherwise we would mostly measure the wait for the slowest band
+        pthread_barrier_wait(&threadSystem->barrier);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+    }
+
+    if (threadSystem->partitionMode == PARTITION_TILES) {
+        rebalanceTiles(threadIndex, worldData, threadAssignments, threadSystem);
+    } else {
+        accumulateAndRebalance(threadIndex, worldData, threadAssignments, threadSystem);
+    }
+
+    if (PRINT_REBALANCE_TIME) {
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        threadSystem->workers[threadIndex].rebalanceNanos += (end.tv_sec - start.tv_sec) * 1000000000L +
+                                                             (end.tv_nsec - start.tv_nsec);
+    }
+}
+
 
 void synchronizeWithAdjacentThreads(int threadNumber, InputData *data, struct ThreadedData *threadedData) {
 
     if (data->threads < 2) return;
 
-    sem_t *our_sem = &threadedData->threadSemaphores[threadNumber];
+    sem_t *our_sem = &threadedData->workers[threadNumber].conflictsReady;
 
     if (threadNumber > 0 && threadNumber < (data->threads - 1)) {
         //If we're a middle thread, we will have to post for 2 threads
@@ -347,7 +1052,7 @@ void synchronizeWithAdjacentThreads(int threadNumber, InputData *data, struct Th
     //printf("Thread %d entered post and wait %p value: %d\n", threadNumber, our_sem, val);
 
     if (threadNumber == 0) {
-        sem_t *botSem = &threadedData->threadSemaphores[threadNumber + 1];
+        sem_t *botSem = &threadedData->workers[threadNumber + 1].conflictsReady;
 
         // printf("Thread %d Waiting for bot_sem %d\n", threadNumber, threadNumber + 1);
 
@@ -359,8 +1064,8 @@ void synchronizeWithAdjacentThreads(int threadNumber, InputData *data, struct Th
         //printf("Thread %d unlocked.\n", threadNumber);
     } else if (threadNumber > 0 && threadNumber < (data->threads - 1)) {
 
-        sem_t *botSem = &threadedData->threadSemaphores[threadNumber + 1],
-                *topSem = &threadedData->threadSemaphores[threadNumber - 1];
+        sem_t *botSem = &threadedData->workers[threadNumber + 1].conflictsReady,
+                *topSem = &threadedData->workers[threadNumber - 1].conflictsReady;
 
 
         //printf("Thread %d Waiting for top sem,...\n", threadNumber);
@@ -375,7 +1080,7 @@ void synchronizeWithAdjacentThreads(int threadNumber, InputData *data, struct Th
         sem_wait(botSem);
         //printf("Thread %d unlocked bot. (UNLOCKED)\n", threadNumber);
     } else {
-        sem_t *topSem = &threadedData->threadSemaphores[threadNumber - 1];
+        sem_t *topSem = &threadedData->workers[threadNumber - 1].conflictsReady;
 
         //printf("Thread %d Waiting for top_sem %d\n", threadNumber, threadNumber - 1);
         sem_getvalue(topSem, &val);
@@ -387,11 +1092,10 @@ void synchronizeWithAdjacentThreads(int threadNumber, InputData *data, struct Th
 
 }
 
+//The conflicts live in the blocks of the threads, only their arrays are freed
 void destroyConflictsContainer(Conflicts *conflicts) {
-    if (conflicts != NULL) {
-        free(conflicts->above);
-        free(conflicts->bellow);
-        free(conflicts);
+    for (int direction = 0; direction < 4; direction++) {
+        free(conflicts->conflicts[direction]);
     }
 }
 
@@ -402,17 +1106,34 @@ void destroyThreadingSystem(int threadCount, struct ThreadedData *threadSystem)
 
     // Clean up per-thread resources
     for (int threadIndex = 0; threadIndex < threadCount; threadIndex++) {
-        destroyConflictsContainer(threadSystem->conflictPerThreads[threadIndex]);
-        sem_destroy(&threadSystem->threadSemaphores[threadIndex]);
-        sem_destroy(&threadSystem->precedingSemaphores[threadIndex]);
+        WorkerBlock *worker = &threadSystem->workers[threadIndex];
+
+        destroyConflictsContainer(&worker->conflicts);
+        destroyRabbitMovementContext(threadSystem->rabbitMovementsPerThread[threadIndex]);
+        destroyFoxMovementContext(threadSystem->foxMovementsPerThread[threadIndex]);
+        sem_destroy(&worker->conflictsReady);
+        sem_destroy(&worker->countsReady);
+        free(threadSystem->entitiesPerRowPerThread[threadIndex]);
+        free(threadSystem->entitiesPerColumnPerThread[threadIndex]);
+        pthread_mutex_destroy(&worker->phaseCounter.lock);
+        pthread_cond_destroy(&worker->phaseCounter.advanced);
+        destroyNeighbourMasks(threadSystem->neighbourMasksPerThread[threadIndex]);
     }
     
     // Clean up arrays
-    free(threadSystem->conflictPerThreads);
-    free(threadSystem->threadSemaphores);
-    free(threadSystem->precedingSemaphores);
+    free(threadSystem->workers);
+    free(threadSystem->rabbitMovementsPerThread);
+    free(threadSystem->foxMovementsPerThread);
+    free(threadSystem->entitiesPerRowPerThread);
+    free(threadSystem->entitiesPerColumnPerThread);
+    free(threadSystem->entitiesPerColumn);
+    free(threadSystem->entitiesAccumulatedPerColumn);
+    free(threadSystem->neighbourMasksPerThread);
+    free(threadSystem->rowGroupThreads);
     free(threadSystem->threads);
 
+    destroyTileScheduler(threadSystem->scheduler);
+
     // Destroy synchronization barrier
     pthread_barrier_destroy(&threadSystem->barrier);
 
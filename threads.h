@@ -4,6 +4,66 @@
 #include "pthread.h"
 #include "semaphore.h"
 #include "rabbitsandfoxes.h"
+#include "movements.h"
+
+//Number of rounds a thread polls its neighbours for their conflicts before blocking on them.
+//A negative limit never blocks (the thread busy waits until both neighbours are done)
+#ifndef CONFLICT_SPIN_LIMIT
+#define CONFLICT_SPIN_LIMIT 128
+#endif
+
+//Generations between two workload rebalances when the threads only synchronize with their neighbours
+#define DEFAULT_REBALANCE_INTERVAL 16
+
+//Size of the cache lines the state of every thread is aligned and padded to, so two threads never write to the same
+//line (see WorkerBlock)
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+//Print how long the threads spent accumulating the entity counts and rebalancing (to stderr)
+#ifndef PRINT_REBALANCE_TIME
+#define PRINT_REBALANCE_TIME 0
+#endif
+
+typedef enum SyncMode_ {
+
+    //Every thread waits for all the others between the phases and at the end of every generation
+    SYNC_BARRIER,
+
+    //Threads only wait for the threads above and bellow them, the global barrier is only used to rebalance
+    SYNC_NEIGHBOURS
+
+} SyncMode;
+
+typedef enum PartitionMode_ {
+
+    //Every thread gets a band of whole rows
+    PARTITION_BANDS,
+
+    //The threads are laid out in a grid and every thread gets a tile, so there can be more threads than rows
+    PARTITION_TILES,
+
+    //The world is cut in many small tiles of a fixed size, which the threads take as tasks from their own deque,
+    //stealing tasks from the other threads when theirs runs out (see scheduler.h)
+    PARTITION_STEALING
+
+} PartitionMode;
+
+/*
+ * Counts the synchronization points a thread went through in neighbour sync mode. Every thread goes through the
+ * same sequence of points, so a thread knows its neighbour is done with a point when the neighbour's counter
+ * reaches its own
+ */
+typedef struct PhaseCounter_ {
+
+    int phase;
+
+    pthread_mutex_t lock;
+
+    pthread_cond_t advanced;
+
+} PhaseCounter;
 
 typedef struct Conflict_ {
 
@@ -11,33 +71,131 @@ typedef struct Conflict_ {
 
     SlotContent slotContent;
 
-    void *data;
+    //State of the moving entity, copied into the new slot if it wins the move
+    union {
+
+        FoxInfo foxInfo;
+
+        RabbitInfo rabbitInfo;
+
+    } entityInfo;
 
 } Conflict;
 
 typedef struct Conflicts_ {
 
-    //Conflicts with the row the bounds given
-    int aboveCount;
+    //Moves into the region of the thread next to ours, indexed by the MoveDirection the entity left our region in
+    int count[4];
 
-    Conflict *above;
+    Conflict *conflicts[4];
 
-    //Conflicts with the row below the bounds given
-    int bellowCount;
+} Conflicts;
 
-    Conflict *bellow;
 
-} Conflicts;
+/*
+ * The state of a thread that the other threads read or write during a generation. The blocks of the threads are
+ * aligned to the cache lines, and every part the neighbours poll or post to starts a line of its own, so writing our
+ * conflicts never takes a line away from a neighbour waiting on our semaphore, or from the thread next to us writing
+ * its own block
+ */
+typedef struct WorkerBlock_ {
+
+    //Written while moving, read by the neighbours once they are handed off
+    Conflicts conflicts;
+
+    //Posted when our conflicts are ready, taken by the neighbours (bands with barrier sync)
+    _Alignas(CACHE_LINE_SIZE) sem_t conflictsReady;
+
+    //Posted when our cumulative counts are done, taken by the thread bellow us (PREFIX_SUM_CHAIN)
+    _Alignas(CACHE_LINE_SIZE) sem_t countsReady;
+
+    //Polled by the neighbours in neighbour sync mode and by tiles
+    _Alignas(CACHE_LINE_SIZE) PhaseCounter phaseCounter;
+
+    //Our rows before the rebalance, the entities in them and the entities in the rows above them, for the two pass
+    //scan of the cumulative counts
+    _Alignas(CACHE_LINE_SIZE) int bandStartRow, bandEndRow, bandTotal, bandOffset;
+
+    //Time spent accumulating the entity counts and rebalancing during the last simulation
+    long rebalanceNanos;
+
+} WorkerBlock;
 
+struct RabbitMovements;
+
+struct FoxMovements;
+
+struct TileScheduler;
+
+struct NeighbourMasks_;
 
 struct ThreadedData {
-    Conflicts **conflictPerThreads;
+    //One per thread, contiguous and cache line aligned
+    WorkerBlock *workers;
 
-    pthread_t *threads;
+    //Scratch space each thread uses to analyze the moves of its entities, allocated once for the whole simulation
+    struct RabbitMovements **rabbitMovementsPerThread;
 
-    sem_t *threadSemaphores, *precedingSemaphores;
+    struct FoxMovements **foxMovementsPerThread;
+
+    pthread_t *threads;
 
     pthread_barrier_t barrier;
+
+    //Number of threads the threading system was initialized with
+    int threadCount;
+
+    //Number of threads the barrier currently waits for
+    int barrierThreads;
+
+    //Number of conflicts each of the NORTH/SOUTH arrays can hold (one per column of the world)
+    int conflictCapacity;
+
+    //Number of conflicts each of the EAST/WEST arrays can hold (one per row of the world, tile mode only)
+    int sideConflictCapacity;
+
+    PartitionMode partitionMode;
+
+    //Layout of the threads, tileColumns is 1 when the threads get bands of rows
+    int tileRows, tileColumns;
+
+    //The entities that end up in each row (and column, in tile mode) of the region of each thread. Tiles share rows
+    //and columns, and the bands share the cache lines at their edges, so every thread counts on its own and the
+    //counts are gathered when rebalancing (see threadRowCounts)
+    int **entitiesPerRowPerThread, **entitiesPerColumnPerThread;
+
+    //Tile mode: entities per column of the world, for the rebalance of the columns
+    int *entitiesPerColumn, *entitiesAccumulatedPerColumn;
+
+    //Rows and columns the arrays above can hold
+    int countRowCapacity, countColumnCapacity;
+
+    SyncMode syncMode;
+
+    //In neighbour sync mode, the workload is only rebalanced every rebalanceInterval generations
+    int rebalanceInterval;
+
+    //Stealing mode: size of the side of the tiles and the tasks of the threads, created when a world is prepared
+    int taskTileSize;
+
+    struct TileScheduler *scheduler;
+
+    AnalysisMode analysisMode;
+
+    BitboardKernel bitboardKernel;
+
+    //Bitboard mode: the neighbour masks of the row each thread is moving the animals of
+    struct NeighbourMasks_ **neighbourMasksPerThread;
+
+    //When not NULL every thread adds the time it spends in every phase to these (see timers.h)
+    struct PhaseTimers_ *timers;
+
+    //The threads are rebalanced in groups (the threads of a NUMA node, see placement.h), the rows of a group are
+    //only moved between its threads. rowGroupThreads has the first thread of every group and the number of threads
+    //after the last one, a single group of every thread when rowGroupCount is 0
+    int rowGroupCount;
+
+    int *rowGroupThreads;
 };
 
 struct ThreadConflictData {
@@ -46,28 +204,119 @@ struct ThreadConflictData {
 
     int startRow, endRow;
 
+    int startCol, endCol;
+
     InputData *inputData;
 
     WorldSlot *world;
 
     struct ThreadedData *threadedData;
+
+    //Where the entities that end up in our region are counted. entitiesPerColumn is NULL when only rows are balanced
+    int *entitiesPerRow, *entitiesPerColumn;
 };
 
 typedef struct ThreadRowData_ {
 
     int startRow, endRow;
 
+    //Every column, unless the threads are given tiles
+    int startCol, endCol;
+
 } ThreadRowData;
 
 void initializeThreadingSystem(int threadCount, InputData *worldData, struct ThreadedData *threadSystem);
 
+/**
+ * Get a threading system ready to simulate a world with threadCount threads, which can be less than the number
+ * of threads it was initialized with. Grows the conflict arrays when the world is wider than the previous one.
+ * Must only be called while no thread is using the threading system
+ */
+void prepareThreadingSystem(int threadCount, InputData *worldData, struct ThreadedData *threadSystem);
+
+/**
+ * Choose how the threads synchronize. Must only be called while no thread is using the threading system
+ * @param syncMode
+ * @param rebalanceInterval Only used by SYNC_NEIGHBOURS
+ * @param threadSystem
+ */
+void setThreadSynchronization(SyncMode syncMode, int rebalanceInterval, struct ThreadedData *threadSystem);
+
+/**
+ * Choose how the world is split between the threads. Must only be called while no thread is using the threading system
+ */
+void setThreadPartitioning(PartitionMode partitionMode, struct ThreadedData *threadSystem);
+
+/**
+ * Choose the size of the side of the tiles in PARTITION_STEALING mode.
+ * Must only be called while no thread is using the threading system
+ */
+void setThreadTaskTileSize(int tileSize, struct ThreadedData *threadSystem);
+
+/**
+ * Choose how the threads find the moves of the animals, and with what instructions in ANALYSIS_BITBOARD mode.
+ * Must only be called while no thread is using the threading system
+ */
+void setThreadAnalysis(AnalysisMode analysisMode, BitboardKernel bitboardKernel, struct ThreadedData *threadSystem);
+
+/**
+ * Time the phases of the next simulations with the given timers, or stop timing them with NULL.
+ * Must only be called while no thread is using the threading system
+ */
+void setThreadTimers(struct PhaseTimers_ *timers, struct ThreadedData *threadSystem);
+
+/**
+ * Only move rows between the threads of the same group when rebalancing the bands, every group keeps the rows the
+ * even split of the world gives to its threads. firstThreads has the first thread of every group and the number of
+ * threads after the last one (groupCount + 1 entries), the groups of a world with less threads are cut short.
+ * Must only be called while no thread is using the threading system
+ */
+void setThreadRowGroups(int groupCount, const int *firstThreads, struct ThreadedData *threadSystem);
+
+/**
+ * Allocate memory that starts a cache line and covers whole lines, so nothing another thread writes shares a line
+ * with it. Exits when it can't be allocated, must be released with free
+ */
+void *allocateCacheAligned(size_t size);
+
+/**
+ * Where the thread threadIndex counts the entities that end up in each row of its region (indexed by the row of the
+ * world): its own array when other threads are counting too, the counts of the world otherwise
+ */
+int *threadRowCounts(int threadIndex, InputData *worldData, struct ThreadedData *threadSystem);
+
+/**
+ * Choose the grid of tiles for a world, with as many of the given threads as the world can use. Picks the layout
+ * with the smallest tiles perimeter (the least halo per tile) among the ones that use the most threads
+ * @return The number of threads the layout uses
+ */
+int chooseTileLayout(int threadCount, InputData *worldData, struct ThreadedData *threadSystem);
+
+/**
+ * Split the world in tiles, with the row and column cuts placed so every band of rows and every strip of
+ * columns has about the same number of entities
+ */
+void distributeTilesAcrossThreads(ThreadRowData *threadAssignments, InputData *worldData, WorldSlot *world,
+                                  struct ThreadedData *threadSystem);
+
+/**
+ * Neighbour sync mode: wait until the threads next to us went through every synchronization point we did,
+ * after which they are no longer reading our rows or conflicts (and have finished writing theirs)
+ */
+void waitForNeighbourThreads(int threadIndex, InputData *worldData, struct ThreadedData *threadSystem);
+
 void synchronizeWithAdjacentThreads(int threadNumber, InputData *data, struct ThreadedData *threadedData);
 
-void createAndStoreConflict(Conflicts *threadConflicts, int isAboveThread, int targetRow, int targetCol, WorldSlot *sourceSlot);
+void createAndStoreConflict(Conflicts *threadConflicts, MoveDirection direction, int targetRow, int targetCol, WorldSlot *sourceSlot);
 
 int validateThreadConfiguration(InputData *simulationData);
 
-void distributeWorkloadAcrossThreads(int threadCount, ThreadRowData *threadAssignments, InputData *worldData);
+/**
+ * Give every thread a band of rows with about the same number of entities as the other threads of its row group
+ * (see setThreadRowGroups)
+ */
+void distributeWorkloadAcrossThreads(int threadCount, ThreadRowData *threadAssignments, InputData *worldData,
+                                     struct ThreadedData *threadSystem);
 
 void synchronizeAndResolveThreadConflicts(struct ThreadConflictData *conflictData);
 
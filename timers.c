@@ -0,0 +1,42 @@
+#include "timers.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *const PHASE_NAMES[TIMED_PHASES] = {
+        [PHASE_RABBITS] = "rabbits",
+        [PHASE_FOXES] = "foxes",
+        [PHASE_CONFLICTS] = "conflicts",
+        [PHASE_WAITS] = "waits",
+        [PHASE_REBALANCE] = "rebalance"
+};
+
+PhaseTimers *createPhaseTimers(int threadCount, int firstGeneration, int generations) {
+    PhaseTimers *timers = malloc(sizeof(PhaseTimers));
+
+    timers->threadCount = threadCount;
+    timers->firstGeneration = firstGeneration;
+    timers->generations = generations;
+    timers->counters = NULL;
+    timers->nanos = calloc((size_t) threadCount * (generations > 0 ? generations : 1) * TIMED_PHASES, sizeof(long));
+
+    if (timers->nanos == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate the timers of %d threads for %d generations\n", threadCount,
+                generations);
+        exit(EXIT_FAILURE);
+    }
+
+    return timers;
+}
+
+const char *timedPhaseName(TimedPhase phase) {
+    return PHASE_NAMES[ phase ];
+}
+
+void destroyPhaseTimers(PhaseTimers *timers) {
+    if (timers->counters != NULL) {
+        destroyPhaseCounters(timers->counters);
+    }
+
+    free(timers->nanos);
+    free(timers);
+}
@@ -0,0 +1,109 @@
+#ifndef TRABALHO_2_TIMERS_H
+#define TRABALHO_2_TIMERS_H
+
+#include <stddef.h>
+#include <time.h>
+#include "counters.h"
+
+/*
+ * Per phase timers of a simulation, for the benchmark mode (see benchmark.h).
+ *
+ * Every thread adds the time it spends in every phase of every generation to its own counters. The threading system
+ * only reads the clock when it was given timers (see setThreadTimers), so a normal run does not pay for them. When the
+ * timers have counters the events of every phase are counted at the same points (see counters.h).
+ */
+
+typedef enum TimedPhase_ {
+
+    //Moving the rabbits of our region, carrying the rows over to the back buffer included
+    PHASE_RABBITS,
+
+    //Moving the foxes of our region
+    PHASE_FOXES,
+
+    //Handing our conflicts to the threads next to us and resolving theirs, waiting for them to be ready included
+    PHASE_CONFLICTS,
+
+    //Barriers and neighbour waits between the phases, and looking for tasks to steal
+    PHASE_WAITS,
+
+    //Accumulating the entity counts and moving the rows (or tiles) between the threads
+    PHASE_REBALANCE,
+
+    TIMED_PHASES
+
+} TimedPhase;
+
+typedef struct PhaseTimers_ {
+
+    int threadCount;
+
+    //The generations timed are [firstGeneration, firstGeneration + generations)
+    int firstGeneration, generations;
+
+    //Nanoseconds, [(thread * generations + generation - firstGeneration) * TIMED_PHASES + phase]. The counters of
+    //every thread are contiguous, so the threads only share the lines at the edges
+    long *nanos;
+
+    //NULL unless the hardware events are counted too, its phases are the TimedPhase
+    PhaseCounters *counters;
+
+} PhaseTimers;
+
+PhaseTimers *createPhaseTimers(int threadCount, int firstGeneration, int generations);
+
+//Name of a phase in the benchmark results
+const char *timedPhaseName(TimedPhase phase);
+
+static inline long monotonicNanos(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+//The time to measure the next phase of a thread from, 0 without timers
+static inline long readPhaseClock(PhaseTimers *timers, int thread) {
+    if (timers == NULL) {
+        return 0;
+    }
+
+    if (timers->counters != NULL) {
+        restartPhaseCounters(timers->counters, thread);
+    }
+
+    return monotonicNanos();
+}
+
+static inline void addPhaseNanos(PhaseTimers *timers, int thread, int generation, TimedPhase phase, long nanos) {
+    timers->nanos[ ((size_t) thread * timers->generations + generation - timers->firstGeneration) * TIMED_PHASES +
+                   phase ] += nanos;
+}
+
+/**
+ * Add the time since the given clock reading (and the events since the last reading of the thread) to a phase
+ * @return The clock now, for the next phase
+ */
+static inline long markPhase(PhaseTimers *timers, int thread, int generation, TimedPhase phase, long since) {
+    if (timers == NULL) {
+        return 0;
+    }
+
+    long now = monotonicNanos();
+
+    addPhaseNanos(timers, thread, generation, phase, now - since);
+
+    if (timers->counters != NULL) {
+        countPhaseEvents(timers->counters, thread, phase);
+
+        //Don't charge the read of the counters to the next phase
+        now = monotonicNanos();
+    }
+
+    return now;
+}
+
+void destroyPhaseTimers(PhaseTimers *timers);
+
+#endif //TRABALHO_2_TIMERS_H
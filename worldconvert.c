@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "rabbitsandfoxes.h"
+#include "output.h"
+#include "reader.h"
+#include "snapshot.h"
+#include "writer.h"
+
+/*
+ * Usage: worldconvert <input> <output>
+ *
+ * Converts a text world (the input format of ecosystem) into a world snapshot (see snapshot.h), or a snapshot back
+ * into a text world, depending on what the input is. A text world has no room for the age and the food of the
+ * animals, so turning a snapshot taken in the middle of a simulation into text starts every animal anew, and the
+ * text world only holds the generations that were left to simulate.
+ */
+
+static void convertTextToSnapshot(FILE *inputFile, const char *outputPath) {
+    InputReader *reader = openInputReader(inputFile);
+
+    InputData *simulationData = parseSimulationParameters(reader);
+
+    if (simulationData == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate the world\n");
+        exit(EXIT_FAILURE);
+    }
+
+    WorldSlot *world = initializeWorldMatrix(simulationData);
+
+    readWorldEntities(reader, simulationData, world);
+
+    closeInputReader(reader);
+
+    saveWorldSnapshot(outputPath, simulationData, world, 0);
+
+    deallocateWorldMatrix(simulationData, world);
+}
+
+static void convertSnapshotToText(FILE *inputFile, const char *outputPath) {
+    WorldSlot *world;
+
+    InputData *simulationData = readWorldSnapshot(inputFile, &world);
+
+    if (simulationData->firstGeneration > 0 && simulationData->firstGeneration < simulationData->n_gen) {
+        fprintf(stderr, "WARNING: The snapshot was taken at generation %d, the ages and food of the animals are lost\n",
+                simulationData->firstGeneration);
+    }
+
+    FILE *outputFile = fopen(outputPath, "w");
+
+    if (outputFile == NULL) {
+        fprintf(stderr, "ERROR: Failed to open output file %s\n", outputPath);
+        exit(EXIT_FAILURE);
+    }
+
+    ResultWrite *write = createResultWrite(simulationData, world, 1);
+
+    write->generations = simulationData->n_gen - simulationData->firstGeneration;
+
+    formatResultBand(0, write);
+
+    finishResultWrite(outputFile, write);
+
+    fclose(outputFile);
+
+    deallocateWorldMatrix(simulationData, world);
+}
+
+int main(int argc, char **argv) {
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <input> <output>\n", argv[ 0 ]);
+        exit(EXIT_FAILURE);
+    }
+
+    FILE *inputFile = fopen(argv[ 1 ], "rb");
+
+    if (inputFile == NULL) {
+        fprintf(stderr, "Failed to open input file %s\n", argv[ 1 ]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (isWorldSnapshot(inputFile)) {
+        convertSnapshotToText(inputFile, argv[ 2 ]);
+    } else {
+        convertTextToSnapshot(inputFile, argv[ 2 ]);
+    }
+
+    fclose(inputFile);
+
+    return 0;
+}
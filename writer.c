@@ -0,0 +1,158 @@
+#include "writer.h"
+#include "occupancy.h"
+#include "matrix_utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+//Longest decimal int, without the sign
+#define MAX_INT_DIGITS 10
+
+static const char *const ENTITY_NAMES[] = {
+        [EMPTY] = "",
+        [ROCK] = "ROCK",
+        [RABBIT] = "RABBIT",
+        [FOX] = "FOX"
+};
+
+static const int ENTITY_NAME_LENGTHS[] = {
+        [EMPTY] = 0,
+        [ROCK] = 4,
+        [RABBIT] = 6,
+        [FOX] = 3
+};
+
+//Write the digits of a value that is not negative, returns the end of them
+static char *formatInteger(char *output, int value) {
+    char digits[MAX_INT_DIGITS];
+
+    int count = 0;
+
+    do {
+        digits[count++] = (char) ('0' + value % 10);
+
+        value /= 10;
+    } while (value > 0);
+
+    while (count > 0) {
+        *output++ = digits[--count];
+    }
+
+    return output;
+}
+
+static int countDigits(int value) {
+    int count = 1;
+
+    for (; value >= 10; value /= 10) {
+        count++;
+    }
+
+    return count;
+}
+
+static int countRowResults(InputData *simulationData, WorldSlot *world, int row) {
+    const uint64_t *occupied = occupancyRow(simulationData, world, row), *rocks = rockRow(simulationData, world, row);
+
+    int entities = 0;
+
+    for (int word = 0; word < OCCUPANCY_WORDS(simulationData->columns); word++) {
+        entities += __builtin_popcountll(occupied[word] | rocks[word]);
+    }
+
+    return entities;
+}
+
+ResultWrite *createResultWrite(InputData *simulationData, WorldSlot *world, int threadCount) {
+    ResultWrite *write = malloc(sizeof(ResultWrite));
+
+    write->simulationData = simulationData;
+    write->world = world;
+    write->generations = 0;
+    write->threadCount = threadCount;
+    write->buffers = calloc(threadCount, sizeof(char *));
+    write->lengths = calloc(threadCount, sizeof(size_t));
+    write->entities = calloc(threadCount, sizeof(int));
+
+    return write;
+}
+
+void formatResultBand(int threadNumber, ResultWrite *write) {
+    InputData *simulationData = write->simulationData;
+
+    WorldSlot *world = write->world;
+
+    int startRow = (int) ((long) threadNumber * simulationData->rows / write->threadCount),
+            endRow = (int) ((long) (threadNumber + 1) * simulationData->rows / write->threadCount) - 1;
+
+    int entities = 0;
+
+    for (int row = startRow; row <= endRow; row++) {
+        entities += countRowResults(simulationData, world, row);
+    }
+
+    //The longest a line of the band can be: the longest name, the row, the column, two spaces and the newline
+    size_t lineLength = ENTITY_NAME_LENGTHS[RABBIT] + countDigits(simulationData->rows - 1) +
+                        countDigits(simulationData->columns - 1) + 3;
+
+    char *buffer = malloc(lineLength * entities + 1), *output = buffer;
+
+    for (int row = startRow; row <= endRow; row++) {
+        const uint64_t *occupied = occupancyRow(simulationData, world, row), *rocks = rockRow(simulationData, world, row);
+
+        //Every line of the row shares the row number
+        char rowText[MAX_INT_DIGITS + 2];
+
+        rowText[0] = ' ';
+
+        int rowTextLength = (int) (formatInteger(&rowText[1], row) - rowText);
+
+        rowText[rowTextLength++] = ' ';
+
+        for (int word = 0; word < OCCUPANCY_WORDS(simulationData->columns); word++) {
+            for (uint64_t bits = occupied[word] | rocks[word]; bits != 0; bits &= bits - 1) {
+                int col = word * 64 + __builtin_ctzll(bits);
+
+                SlotContent content = world[PROJECT(simulationData->columns, row, col)].slotContent;
+
+                memcpy(output, ENTITY_NAMES[content], ENTITY_NAME_LENGTHS[content]);
+                output += ENTITY_NAME_LENGTHS[content];
+
+                memcpy(output, rowText, rowTextLength);
+                output += rowTextLength;
+
+                output = formatInteger(output, col);
+
+                *output++ = '\n';
+            }
+        }
+    }
+
+    write->buffers[threadNumber] = buffer;
+    write->lengths[threadNumber] = output - buffer;
+    write->entities[threadNumber] = entities;
+}
+
+void finishResultWrite(FILE *outputFile, ResultWrite *write) {
+    InputData *simulationData = write->simulationData;
+
+    int entities = 0;
+
+    for (int thread = 0; thread < write->threadCount; thread++) {
+        entities += write->entities[thread];
+    }
+
+    fprintf(outputFile, "%d %d %d %d %d %d %d\n", simulationData->gen_proc_rabbits, simulationData->gen_proc_foxes,
+            simulationData->gen_food_foxes, write->generations, simulationData->rows, simulationData->columns,
+            entities);
+
+    for (int thread = 0; thread < write->threadCount; thread++) {
+        fwrite(write->buffers[thread], 1, write->lengths[thread], outputFile);
+
+        free(write->buffers[thread]);
+    }
+
+    free(write->buffers);
+    free(write->lengths);
+    free(write->entities);
+    free(write);
+}
@@ -0,0 +1,50 @@
+#ifndef TRABALHO_2_WRITER_H
+#define TRABALHO_2_WRITER_H
+
+#include <stdio.h>
+#include "rabbitsandfoxes.h"
+
+/*
+ * Result writer.
+ *
+ * The results are formatted a band of rows at a time into private buffers, with the integers formatted by hand,
+ * and the buffers are written in order with a single fwrite each. Only the occupied slots (the animals and the
+ * rocks, see occupancy.h) are visited, and the number of entities comes from the bitmaps instead of scanning the
+ * slots. Several threads can each format a band at the same time (see outputSimulationJobOnEngine).
+ */
+
+typedef struct ResultWrite_ {
+
+    InputData *simulationData;
+
+    WorldSlot *world;
+
+    //Generations left to simulate, written in the parameters line. None once the world is simulated
+    int generations;
+
+    //Bands the rows are split in, one per thread formatting them
+    int threadCount;
+
+    char **buffers;
+
+    size_t *lengths;
+
+    //Entities (animals and rocks) in every band
+    int *entities;
+
+} ResultWrite;
+
+ResultWrite *createResultWrite(InputData *simulationData, WorldSlot *world, int threadCount);
+
+/**
+ * Format the lines of the band of rows of the given thread
+ */
+void formatResultBand(int threadNumber, ResultWrite *write);
+
+/**
+ * Write the parameters line and the formatted bands to outputFile, then release the write. Must be called once
+ * every band is formatted
+ */
+void finishResultWrite(FILE *outputFile, ResultWrite *write);
+
+#endif //TRABALHO_2_WRITER_H